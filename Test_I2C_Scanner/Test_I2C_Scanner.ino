@@ -21,6 +21,10 @@
 //    A sensor seems to use address 120.
 // Version 6, November 27, 2015.
 //    Added waiting for the Leonardo serial communication.
+// Version 7
+//    Fast mode with Scd4xBusScanner: probes at 400 kHz, identifies SCD4x
+//    and SSD1306 / SH1106 devices and then watches the bus for hot-plug
+//    events. Set FAST_SCAN to 0 for the classic scan.
 //
 //
 // This sketch tests the standard 7-bit addresses
@@ -28,6 +32,67 @@
 //
 
 #include <Wire.h>
+#include <Scd4xBusScanner.h>
+
+#define FAST_SCAN       1
+#define WATCH_INTERVAL  1000    // ms between hot-plug passes, 0 to disable
+
+Scd4xBusDevice devices[8];
+Scd4xBusScanner scanner(devices, 8);
+bool watching = false;            // print changes found by the watch
+
+void printAddress(uint8_t address)
+{
+  Serial.print("0x");
+  if (address < 16)
+    Serial.print("0");
+  Serial.print(address, HEX);
+}
+
+void printUint16Hex(uint16_t value)
+{
+  Serial.print(value < 4096 ? "0" : "");
+  Serial.print(value < 256 ? "0" : "");
+  Serial.print(value < 16 ? "0" : "");
+  Serial.print(value, HEX);
+}
+
+void printDevice(const Scd4xBusDevice &device)
+{
+  printAddress(device.address);
+  switch (device.type)
+  {
+    case BusDeviceScd4x:
+      Serial.print(F("  SCD4x"));
+      if (device.flags & BusDeviceMeasuring)
+      {
+        Serial.print(F(", measuring"));
+      }
+      else
+      {
+        Serial.print(F(", serial "));
+        for (uint8_t i = 0; i < 3; i++)
+          printUint16Hex(device.serial[i]);
+      }
+      break;
+    case BusDeviceSsd1306:
+    case BusDeviceSh1106:
+      Serial.print(device.type == BusDeviceSsd1306 ? F("  SSD1306") : F("  SH1106"));
+      Serial.print(device.flags & BusDeviceDisplayOn ? F(", display on") : F(", display off"));
+      break;
+    default:
+      Serial.print(F("  unknown"));
+  }
+  Serial.println();
+}
+
+void onBusEvent(const Scd4xBusDevice &device, bool attached)
+{
+  if (!watching)
+    return;
+  Serial.print(attached ? F("attached ") : F("removed  "));
+  printDevice(device);
+}
 
 
 void setup()
@@ -37,9 +102,33 @@ void setup()
   Serial.begin(9600);
   while (!Serial);             // Leonardo: wait for serial monitor
   Serial.println("\nI2C Scanner");
+
+#if FAST_SCAN
+  scanner.begin(Wire, 100000, onBusEvent);
+  unsigned long start = micros();
+  scanner.scan();
+  unsigned long elapsed = micros() - start;
+
+  for (uint8_t i = 0; i < scanner.count(); i++)
+    printDevice(scanner.device(i));
+  Serial.print(scanner.count());
+  Serial.print(F(" devices in "));
+  Serial.print(elapsed);
+  Serial.println(F(" us\n"));
+
+  // from now on only changes are printed
+  watching = true;
+  scanner.setWatchInterval(WATCH_INTERVAL);
+#endif
 }
 
 
+#if FAST_SCAN
+void loop()
+{
+  scanner.update(millis());
+}
+#else
 void loop()
 {
   byte error, address;
@@ -81,3 +170,4 @@ void loop()
 
   delay(5000);           // wait 5 seconds for next scan
 }
+#endif
@@ -1,8 +1,21 @@
 #include <Arduino.h>
+#include <Scd4xBackgroundRunner.h>
+#include <Scd4xConsole.h>
+#define SCD4X_PAINT_STACK_EARLY  // stack painted before main() for the RAM report
+#include <Scd4xMemory.h>
+#include <Scd4xReconfiguration.h>
 #include <SensirionI2CScd4x.h>
 #include <Wire.h>
 
 SensirionI2CScd4x scd4x;
+Scd4xReconfiguration reconfig;  // settings are applied right after a sample
+Scd4xBackgroundRunner runner;   // self test and factory reset
+unsigned long nextRead = 0;
+bool singleShot = false;        // single shot measurement in progress
+bool sleeping = false;          // sensor powered down
+bool reportSettings = false;    // print the settings read by reconfig
+bool reportFrc = false;         // print the FRC result of reconfig
+uint16_t frcTarget = 0;
 
 typedef enum {
   LOW_POWER,
@@ -40,42 +53,127 @@ void printSerialNumber(uint16_t serial0, uint16_t serial1, uint16_t serial2) {
   Serial.println();
 }
 
-void printErrorMsg(String fucName, uint16_t err) {
-  char errMsg[256];
+void printErrorMsg(const char* fucName, uint16_t err) {
+  char errMsg[80];  // on the stack, the longest error text has 75 characters
 
-  Serial.print("ERRO> " + fucName + "(): ");
-  errorToString(err, errMsg, 256);
+  Serial.print(F("ERRO> "));
+  Serial.print(fucName);
+  Serial.print(F("(): "));
+  errorToString(err, errMsg, sizeof(errMsg));
   Serial.println(errMsg);
 }
 
+bool isMeasuring() {
+  return reconfig.mode() != Scd4xIdle;
+}
+
+Scd4xMeasurementMode measurementMode() {
+  return (opMode == HIGH_PERF) ? Scd4xPeriodic : Scd4xLowPowerPeriodic;
+}
+
+void printDowntime() {
+  Serial.print(F("INFO> reconfigured in "));
+  Serial.print(reconfig.downtime());
+  Serial.println(F(" ms"));
+}
+
+void printFrcCorrection(uint16_t targetCo2Concentration, uint16_t frcCorrection) {
+  if (frcCorrection == 0xffff) {
+    Serial.println(F("WARN> FRC correction failed!"));
+  } else {
+    Serial.print(F("INFO> set correction:"));
+    Serial.print(targetCo2Concentration);
+    Serial.print(F(", offset: "));
+    Serial.print((frcCorrection - 32768.0), 2);
+    Serial.println(F(" ppm"));
+  }
+}
+
+void printSettings(const Scd4xSettings& settings) {
+  const uint16_t* serial = settings.serialNumber;
+
+  printSerialNumber(serial[0], serial[1], serial[2]);
+  ascState = (settings.ascEnabled <= 1) ? settings.ascEnabled : -1;
+  Serial.print(F("INFO> ASC is "));
+  Serial.println(settings.ascEnabled ? F("enabled") : F("disabled"));
+  Serial.print(F("INFO> offset temperature:"));
+  Serial.print(settings.temperatureOffsetTicks * 175.0 / 65536.0, 2);
+  Serial.println(F("°C"));
+  Serial.print(F("INFO> altitude: "));
+  Serial.print(settings.sensorAltitude);
+  Serial.println(F(" m"));
+}
+
+// apply queued changes, called right after a sample was read
+void applyReconfiguration() {
+  uint16_t error;
+
+  if (!reconfig.isPending()) {
+    return;
+  }
+  error = reconfig.measurementRead();
+
+  if (error) {
+    printErrorMsg(__func__, error);
+  } else {
+    printDowntime();
+    if (reportFrc) {
+      printFrcCorrection(frcTarget, reconfig.frcCorrection());
+    }
+    if (reportSettings) {
+      printSettings(reconfig.settings());
+    }
+  }
+  reportFrc = false;
+  reportSettings = false;
+  nextRead = millis() + updateInterval;
+}
+
+// apply at once when idle, otherwise after the next sample
+void queueReconfiguration() {
+  if (isMeasuring()) {
+    Serial.println(F("INFO> change queued until next sample"));
+  } else {
+    applyReconfiguration();
+  }
+}
+
+// always sent: the sensor may measure without the sketch knowing, e.g.
+// after a reset of the board alone
 void stopPeriodicMeasurement() {
   uint16_t error;
+  bool tracked = isMeasuring() || reconfig.isPending();
 
-  error = scd4x.stopPeriodicMeasurement();
+  if (tracked) {
+    reconfig.setMeasurementMode(Scd4xIdle);
+    error = reconfig.commit();
+  } else {
+    error = scd4x.stopPeriodicMeasurement();
+  }
 
   if (error) {
     printErrorMsg(__func__, error);
   } else {
     Serial.println(F("INFO> stop periodic measurement"));
+    if (tracked) {
+      printDowntime();
+    }
   }
 }
 
 void startPeriodicMeasurement() {
   uint16_t error;
-  String tmp = "";
 
-  if (opMode == HIGH_PERF) {
-    error = scd4x.startPeriodicMeasurement();
-  } else {
-    error = scd4x.startLowPowerPeriodicMeasurement();
-  }
+  reconfig.setMeasurementMode(measurementMode());
+  error = reconfig.commit();
+  nextRead = millis() + updateInterval;
 
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    tmp = (opMode == HIGH_PERF) ? "(High Performance)" : "(Low Power)";
     Serial.print(F("INFO> start periodic measurement "));
-    Serial.println(tmp);
+    Serial.println((opMode == HIGH_PERF) ? F("(High Performance)")
+                                         : F("(Low Power)"));
   }
 }
 
@@ -117,31 +215,22 @@ void getAutomaticSelfCalibration() {
 }
 
 void setAutomaticSelfCalibration(uint16_t ascEnabled) {
-  uint16_t error;
-
-  error = scd4x.setAutomaticSelfCalibration(ascEnabled);
-
-  if (error) {
-    printErrorMsg(__func__, error);
-  }
+  reconfig.setAutomaticSelfCalibration(ascEnabled);
+  queueReconfiguration();
 }
 
-void readMeasurement() {
+bool readMeasurement() {
   uint16_t error;
   uint16_t co2;
   float temperature;
   float humidity;
 
-#if 0
-  delay(updateInterval);
-#else
-  delay(updateInterval);
-  if (getDataReadyStatus() != 1) {
-    return;
+  if (!dataReady()) {
+    return false;
   }
-#endif
 
   error = scd4x.readMeasurement(co2, temperature, humidity);
+  singleShot = false;
 
   if (error) {
     printErrorMsg(__func__, error);
@@ -163,6 +252,22 @@ void readMeasurement() {
     Serial.println(humidity);
 #endif
   }
+  return true;
+}
+
+void pollMeasurement() {
+  if ((!isMeasuring() && !singleShot) || (long)(millis() - nextRead) < 0) {
+    return;
+  }
+  if (readMeasurement()) {
+    if (!isMeasuring()) {
+      return;
+    }
+    nextRead = millis() + updateInterval;
+    applyReconfiguration();
+  } else {
+    nextRead = millis() + 100;
+  }
 }
 
 void performForcedRecalibration(uint16_t targetCo2Concentration) {
@@ -174,22 +279,60 @@ void performForcedRecalibration(uint16_t targetCo2Concentration) {
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    if (frcCorrection == 0xffff) {
-      Serial.print(F("WARN> FRC correction failed!"));
-    } else {
-      Serial.print(F("INFO> set correction:"));
-      Serial.print(targetCo2Concentration);
-      Serial.print(F(", offset: "));
-      Serial.print((frcCorrection - 32768.0), 2);
-      Serial.println(F(" ppm"));
-    }
+    printFrcCorrection(targetCo2Concentration, frcCorrection);
+  }
+}
+
+// runs right after the next sample while measuring, the measurement goes on
+void queueForcedRecalibration(uint16_t targetCo2Concentration) {
+  Serial.print(F("INFO> FRC to "));
+  Serial.print(targetCo2Concentration);
+  Serial.println(F(" ppm"));
+  frcTarget = targetCo2Concentration;
+  reportFrc = true;
+  reconfig.performForcedRecalibration(targetCo2Concentration);
+  queueReconfiguration();
+}
+
+void readSettings() {
+  reportSettings = true;
+  reconfig.readSettings();
+  queueReconfiguration();
+}
+
+void onRunnerEvent(const Scd4xRunnerEvent& event) {
+  const __FlashStringHelper* name =
+    (event.operation == Scd4xSelfTest) ? F("self test") : F("factory reset");
+
+  if (!event.done) {
+    Serial.print(F("INFO> "));
+    Serial.print(name);
+    Serial.print(F(" "));
+    Serial.print(event.progress);
+    Serial.println(F("%"));
+  } else if (event.error) {
+    printErrorMsg(__func__, event.error);
+  } else if (event.operation == Scd4xFactoryReset) {
+    ascState = 1;
+    Serial.println(F("INFO> factory reset done"));
+  } else if (event.result == 0x0) {
+    Serial.println(F("INFO> no malfunction detected"));
+  } else {
+    Serial.println(F("WARN> malfunction detected!!!"));
+  }
+}
+
+void waitForRunner() {
+  while (runner.isBusy()) {
+    delay(10);
+    runner.update(millis());
   }
 }
 
 void performFactoryReset() {
   uint16_t error;
 
-  error = scd4x.performFactoryReset();
+  error = runner.startFactoryReset(millis());
 
   if (error) {
     printErrorMsg(__func__, error);
@@ -214,43 +357,83 @@ void getTemperatureOffset() {
   }
 }
 
-void setTemperatureOffset(uint16_t tOffset) {
+void setTemperatureOffset(float tOffset) {
+  Serial.print(F("INFO> set temperature offset: "));
+  Serial.println(tOffset, 2);
+  reconfig.setTemperatureOffset(tOffset);
+  queueReconfiguration();
+}
+
+void persistSettings() {
+  Serial.println(F("INFO> persist settings"));
+  reconfig.persistSettings();
+  queueReconfiguration();
+}
+
+void reinit() {
+  Serial.println(F("INFO> reinit"));
+  reconfig.reinit();
+  queueReconfiguration();
+}
+
+void setSensorAltitude(uint16_t sensorAltitude) {
+  Serial.print(F("INFO> set altitude: "));
+  Serial.println(sensorAltitude);
+  reconfig.setSensorAltitude(sensorAltitude);
+  queueReconfiguration();
+}
+
+// allowed during periodic measurement, applied at once
+void setAmbientPressure(uint16_t ambientPressure) {
   uint16_t error;
 
-  error = scd4x.setTemperatureOffset(tOffset);
+  error = scd4x.setAmbientPressure(ambientPressure);
 
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    Serial.print(F("INFO> set temperature offset: 0x"));
-    Serial.println(tOffset, HEX);
+    Serial.print(F("INFO> set ambient pressure: "));
+    Serial.println(ambientPressure);
   }
 }
 
-void persistSettings() {
+void measureSingleShot(bool rhtOnly) {
+  Scd4xCommandId command =
+    rhtOnly ? Scd4xCmdMeasureSingleShotRhtOnly : Scd4xCmdMeasureSingleShot;
   uint16_t error;
 
-  error = scd4x.persistSettings();
+  // sent without waiting, pollMeasurement() reads the result
+  error = scd4x.sendCommand(command, nullptr);
 
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    Serial.println(F("INFO> persist settings"));
+    singleShot = true;
+    nextRead = millis() + SensirionI2CScd4x::executionTime(command);
+    Serial.println(F("INFO> single shot measurement"));
   }
 }
 
-void reinit() {
+void powerDown() {
   uint16_t error;
 
-  error = scd4x.reinit();
+  error = scd4x.powerDown();
 
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    Serial.println(F("INFO> reinit"));
+    sleeping = true;
+    Serial.println(F("INFO> sensor sleeping"));
   }
 }
 
+void wakeUp() {
+  // the sensor does not acknowledge wake_up, so no error check
+  scd4x.wakeUp();
+  sleeping = false;
+  Serial.println(F("INFO> sensor woken up"));
+}
+
 bool getDataReadyStatus() {
   uint16_t error;
   uint16_t dataReady;
@@ -268,28 +451,39 @@ bool getDataReadyStatus() {
       return 1;
     }
   }
+  return 0;
+}
+
+// data-ready check for polling: no message while waiting, false on error
+bool dataReady() {
+  uint16_t error;
+  uint16_t dataReady;
+
+  error = scd4x.getDataReadyStatus(dataReady);
+
+  if (error) {
+    printErrorMsg(__func__, error);
+    return false;
+  }
+  return (dataReady & 0xFFF) != 0x0;
 }
 
 void performSelfTest() {
   uint16_t error;
-  uint16_t sensorStatus;
 
-  scd4x.performSelfTest(sensorStatus);
+  error = runner.startSelfTest(millis());
 
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    if (sensorStatus == 0x0) {
-      Serial.println(F("INFO> no malfunction detected"));
-    } else {
-      Serial.println(F("WARN> malfunction detected!!!"));
-    }
+    Serial.println(F("INFO> self test started, takes about 5.5 s"));
   }
 }
 
 void quickTest() {
   stopPeriodicMeasurement();
   performFactoryReset();
+  waitForRunner();
 
   getSerialNumber();
   //setAutomaticSelfCalibration(1);
@@ -301,6 +495,7 @@ void quickTest() {
   //-------------------------------
   startPeriodicMeasurement();
   for (int i = 0; i < 20; i++) {
+    delay(updateInterval);
     readMeasurement();
   }
   stopPeriodicMeasurement();
@@ -309,160 +504,346 @@ void quickTest() {
   performForcedRecalibration(824);
   startPeriodicMeasurement();
   for (int i = 0; i < 20; i++) {
+    delay(updateInterval);
     readMeasurement();
   }
   stopPeriodicMeasurement();
 }
 
-void setup() {
-  Serial.begin(115200);
-  while (!Serial) {
-    delay(100);
+// refuses commands while self test or factory reset are running
+bool sensorReady() {
+  if (runner.isBusy()) {
+    Serial.println(F("WARN> sensor busy, please wait"));
+    return false;
   }
+  return true;
+}
 
-  Wire.begin();
-  scd4x.begin(Wire);
+// for commands which need the sensor idle and would cost samples
+bool sensorIdle() {
+  if (!sensorReady()) {
+    return false;
+  }
+  if (isMeasuring() || singleShot) {
+    Serial.println(F("WARN> stop the measurement first"));
+    return false;
+  }
+  return true;
+}
 
-  //quickTest();
-  showMenu();
+bool parseSwitch(const char* text, uint16_t& value) {
+  if (!strcmp(text, "on") || !strcmp(text, "1")) {
+    value = 1;
+  } else if (!strcmp(text, "off") || !strcmp(text, "0")) {
+    value = 0;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void printUsage(const __FlashStringHelper* usage) {
+  Serial.print(F("WARN> usage: "));
+  Serial.println(usage);
 }
 
-void showMenu() {
-  String tmp = "";
-  Serial.print(
+void cmdHelp(uint8_t argc, char* argv[]) {
+  Serial.print(F(
     "\n"
     "\t---------------------------------\n"
-    "\t\tSCD40 Menu\n"
+    "\t\tSCD40 Console\n"
     "\t---------------------------------\n"
-    "\t1: Sensor Info\n"
-    "\t2: Read Measurement\n"
-    "\t3: Persist Settings\n"
-    "\t4: Factory Reset\n"
-  );
+    "\tstatus            Mode and pending changes\n"
+    "\tinfo              Serial number and settings\n"
+    "\tstart | stop      Periodic measurement\n"
+    "\tmode hp|lp        High performance / low power\n"
+    "\tasc on|off        Automatic self-calibration\n"
+    "\tfrc <ppm>         Forced re-calibration\n"
+    "\toffset <C>        Temperature offset\n"
+    "\taltitude <m>      Sensor altitude\n"
+    "\tpressure <hPa>    Ambient pressure, applied at once\n"
+    "\tpersist           Persist settings\n"
+    "\treinit            Reload settings from EEPROM\n"
+    "\tsingle [rht]      Single shot measurement (idle)\n"
+    "\tselftest          Perform self test\n"
+    "\treset             Factory reset\n"
+    "\tsleep | wake      Power down / wake up (idle)\n"
+    "\tmem               Stack, heap and static RAM\n"
+    "\n"
+    "\tWhile measuring, settings are applied right after the\n"
+    "\tnext sample.\n"
+  ));
+}
+
+void cmdStatus(uint8_t argc, char* argv[]) {
+  Serial.print(F("INFO> "));
+  if (sleeping) {
+    Serial.print(F("sleeping"));
+  } else if (!isMeasuring()) {
+    Serial.print(F("idle"));
+  } else {
+    Serial.print(F("measuring every "));
+    Serial.print(updateInterval / 1000);
+    Serial.print(F(" s"));
+  }
+  Serial.print((opMode == HIGH_PERF) ? F(", high performance")
+                                     : F(", low power"));
+  if (reconfig.isPending()) {
+    Serial.print(F(", changes queued"));
+  }
+  if (runner.isBusy()) {
+    Serial.print(F(", busy"));
+  }
+  Serial.println();
+}
+
+void cmdInfo(uint8_t argc, char* argv[]) {
+  if (sensorReady()) {
+    readSettings();
+  }
+}
+
+void cmdStart(uint8_t argc, char* argv[]) {
+  if (sensorReady()) {
+    startPeriodicMeasurement();
+  }
+}
 
-  tmp = (ascState == 1) ? "(Enabled)\n" : "(Disabled)\n";
-  Serial.print(
-    "\t5: Toggle ASC (Automatic self-calibration) " + tmp
-  );
+void cmdStop(uint8_t argc, char* argv[]) {
+  if (sensorReady()) {
+    stopPeriodicMeasurement();
+  }
+}
+
+void cmdMode(uint8_t argc, char* argv[]) {
+  if (!strcmp(argv[1], "hp")) {
+    updateOpMode(HIGH_PERF);
+  } else if (!strcmp(argv[1], "lp")) {
+    updateOpMode(LOW_POWER);
+  } else {
+    printUsage(F("mode hp|lp"));
+    return;
+  }
+  if (isMeasuring() && sensorReady()) {
+    reconfig.setMeasurementMode(measurementMode());
+    queueReconfiguration();
+  }
+}
+
+void cmdAsc(uint8_t argc, char* argv[]) {
+  uint16_t ascEnabled;
+
+  if (!parseSwitch(argv[1], ascEnabled)) {
+    printUsage(F("asc on|off"));
+  } else if (sensorReady()) {
+    Serial.println(ascEnabled ? F("INFO> enable ASC...")
+                              : F("INFO> disable ASC..."));
+    ascState = ascEnabled;
+    setAutomaticSelfCalibration(ascEnabled);
+  }
+}
+
+void cmdFrc(uint8_t argc, char* argv[]) {
+  uint16_t ppm;
+
+  if (!Scd4xConsole::parseUInt16(argv[1], ppm)) {
+    printUsage(F("frc <ppm>"));
+  } else if (sensorReady()) {
+    queueForcedRecalibration(ppm);
+  }
+}
 
+void cmdOffset(uint8_t argc, char* argv[]) {
+  float tOffset;
 
-  Serial.print(
-    "\t6: FRC (Forced Re-Calibration)\n"
-    "\t7: Set Temperature Offset\n"
-  );
+  if (!Scd4xConsole::parseFloat(argv[1], tOffset)) {
+    printUsage(F("offset <C>"));
+  } else if (sensorReady()) {
+    setTemperatureOffset(tOffset);
+  }
+}
 
+void cmdAltitude(uint8_t argc, char* argv[]) {
+  uint16_t sensorAltitude;
 
-  tmp = (opMode == 1) ? "(High Performance)\n" : "(Low Power)\n";
-  Serial.print(
-    "\t8: Toggle operation mode " + tmp
-  );
+  if (!Scd4xConsole::parseUInt16(argv[1], sensorAltitude)) {
+    printUsage(F("altitude <m>"));
+  } else if (sensorReady()) {
+    setSensorAltitude(sensorAltitude);
+  }
+}
 
-  Serial.print(
-    "\t9: Perform Self Test\n"
-  );
+void cmdPressure(uint8_t argc, char* argv[]) {
+  uint16_t ambientPressure;
 
-  Serial.println();
+  if (!Scd4xConsole::parseUInt16(argv[1], ambientPressure)) {
+    printUsage(F("pressure <hPa>"));
+  } else if (sensorReady()) {
+    setAmbientPressure(ambientPressure);
+  }
+}
+
+void cmdPersist(uint8_t argc, char* argv[]) {
+  if (sensorReady()) {
+    persistSettings();
+  }
+}
+
+void cmdReinit(uint8_t argc, char* argv[]) {
+  if (sensorReady()) {
+    reinit();
+  }
+}
+
+void cmdSingle(uint8_t argc, char* argv[]) {
+  if (argc > 1 && strcmp(argv[1], "rht")) {
+    printUsage(F("single [rht]"));
+  } else if (sensorIdle()) {
+    measureSingleShot(argc > 1);
+  }
+}
+
+// self test and factory reset take the sensor out of measurement
+void cmdSelfTest(uint8_t argc, char* argv[]) {
+  if (sensorReady() && !singleShot) {
+    stopPeriodicMeasurement();
+    performSelfTest();
+  }
+}
+
+void cmdReset(uint8_t argc, char* argv[]) {
+  if (sensorReady() && !singleShot) {
+    stopPeriodicMeasurement();
+    performFactoryReset();
+  }
+}
+
+void cmdSleep(uint8_t argc, char* argv[]) {
+  if (sensorIdle()) {
+    powerDown();
+  }
+}
+
+void cmdWake(uint8_t argc, char* argv[]) {
+  if (sensorReady()) {
+    wakeUp();
+  }
+}
+
+void printRamRegion(const __FlashStringHelper* name, size_t size) {
+  Serial.print(F("STAT> ram "));
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print(size);
+  Serial.println(F(" B"));
+}
+
+void cmdMem(uint8_t argc, char* argv[]) {
+  Scd4xHeapStats heap;
+
+  Scd4xMemory::heapStats(heap);
+  Serial.print(F("STAT> stack high water "));
+  Serial.print(Scd4xMemory::stackHighWater());
+  Serial.print(F(" B, never used "));
+  Serial.print(Scd4xMemory::stackUnused());
+  Serial.print(F(" B, free now "));
+  Serial.print(Scd4xMemory::freeRam());
+  Serial.println(F(" B"));
+  Serial.print(F("STAT> heap "));
+  Serial.print(heap.heapSize);
+  Serial.print(F(" B, free "));
+  Serial.print(heap.freeBytes);
+  Serial.print(F(" B in "));
+  Serial.print(heap.fragments);
+  Serial.print(F(" blocks, largest "));
+  Serial.print(heap.largestFree);
+  Serial.println(F(" B"));
+
+  printRamRegion(F("static total"), Scd4xMemory::staticRam());
+  printRamRegion(F("serial"), sizeof(Serial));
+#ifdef BUFFER_LENGTH
+  // TwoWire rx/tx and the three twi buffers
+  printRamRegion(F("wire buffers"), 5 * BUFFER_LENGTH);
+#endif
+  printRamRegion(F("sensirion driver"), sizeof(scd4x));
+  printRamRegion(F("reconfiguration"), sizeof(reconfig));
+  printRamRegion(F("background runner"), sizeof(runner));
+  printRamRegion(F("console line"), SCD4X_CONSOLE_LINE_MAX);
+}
+
+const Scd4xConsoleCommand commands[] = {
+  {"help", cmdHelp, 0},
+  {"status", cmdStatus, 0},
+  {"info", cmdInfo, 0},
+  {"start", cmdStart, 0},
+  {"stop", cmdStop, 0},
+  {"mode", cmdMode, 1},
+  {"asc", cmdAsc, 1},
+  {"frc", cmdFrc, 1},
+  {"offset", cmdOffset, 1},
+  {"altitude", cmdAltitude, 1},
+  {"pressure", cmdPressure, 1},
+  {"persist", cmdPersist, 0},
+  {"reinit", cmdReinit, 0},
+  {"single", cmdSingle, 0},
+  {"selftest", cmdSelfTest, 0},
+  {"reset", cmdReset, 0},
+  {"sleep", cmdSleep, 0},
+  {"wake", cmdWake, 0},
+  {"mem", cmdMem, 0},
+};
+
+// fixed line buffer, input is read as it arrives and never waited for
+Scd4xConsole console(commands, sizeof(commands) / sizeof(commands[0]));
+
+void reportConsole(Scd4xConsoleStatus status) {
+  switch (status) {
+    case ConsoleUnknown:
+      Serial.print(F("WARN> unknown command: "));
+      Serial.println(console.command());
+      Serial.println(F("INFO> type help for the command list"));
+      break;
+
+    case ConsoleUsage:
+      Serial.print(F("WARN> wrong arguments for "));
+      Serial.println(console.command());
+      break;
+
+    case ConsoleTooLong:
+      Serial.println(F("WARN> line too long, ignored"));
+      break;
+
+    default:
+      break;
+  }
+}
+
+void setup() {
+  uint16_t error;
+
+  Serial.begin(115200);
+  while (!Serial) {
+    delay(100);
+  }
+
+  Wire.begin();
+  scd4x.begin(Wire);
+  // a warm reset leaves the sensor measuring, the sketch starts from idle
+  error = scd4x.stopPeriodicMeasurement();
+  if (error) {
+    printErrorMsg(__func__, error);
+  }
+  reconfig.begin(scd4x);
+  runner.begin(scd4x, onRunnerEvent);
+
+  //quickTest();
+  cmdHelp(0, nullptr);
 }
 
 void loop() {
-  if (Serial.available() > 0) {
-    switch (Serial.read()) {
-      case '1': // Sensor Info
-        Serial.readStringUntil('\n'); // clean the buffer in serial
-        stopPeriodicMeasurement();
-        getSerialNumber();
-        getAutomaticSelfCalibration();
-        getTemperatureOffset();
-        break;
-
-      case '2': // Read Measurement
-        Serial.readStringUntil('\n'); // clean the buffer in serial
-        stopPeriodicMeasurement();
-        startPeriodicMeasurement();
-        Serial.println(F("INFO> press q to quit\n"));
-        for (;;) {
-          readMeasurement();
-          if (Serial.available() > 0) {
-            if (Serial.read() == 'q') {
-              stopPeriodicMeasurement();
-              break;
-            }
-          }
-        }
-        break;
-
-      case '3': // Persist Settings
-        Serial.readStringUntil('\n'); // clean the buffer in serial
-        stopPeriodicMeasurement();
-        persistSettings();
-        break;
-
-      case '4': // Factory Reset
-        Serial.readStringUntil('\n'); // clean the buffer in serial
-        stopPeriodicMeasurement();
-        performFactoryReset();
-        break;
-
-      case '5': // Toggle ASC (Automatic self-calibration)
-        Serial.readStringUntil('\n'); // clean the buffer in serial
-        stopPeriodicMeasurement();
-        getAutomaticSelfCalibration();
-
-        if (ascState == 1) {
-          Serial.println(F("INFO> disable ASC..."));
-        } else if (ascState == 0) {
-          Serial.println(F("INFO> enable ASC..."));
-        }
-        ascState = 1 - ascState;
-        setAutomaticSelfCalibration(ascState);
-        break;
-
-      case '6': // FRC (Forced Re-Calibration)
-        Serial.readStringUntil('\n'); // clean the buffer in serial
-        stopPeriodicMeasurement();
-        Serial.println(F("INFO> input FRC (ppm) from serial..."));
-
-        for (;;) {
-          if (Serial.available() > 0) {
-            String str = Serial.readStringUntil('\n');
-            int ppm = str.toInt();
-            //Serial.println(ppm, DEC);
-            performForcedRecalibration(ppm);
-            break;
-          }
-        }
-        break;
-
-      case '7': // Set Temperature Offset
-        Serial.readStringUntil('\n'); // clean the buffer in serial
-        stopPeriodicMeasurement();
-        Serial.println(F("INFO> input temperature offset from serial..."));
-
-        for (;;) {
-          if (Serial.available() > 0) {
-            String str = Serial.readStringUntil('\n');
-            float tOffset = str.toFloat();
-            //Serial.println((int)((tOffset * 65536.0) / 175.0));
-            setTemperatureOffset(tOffset);
-            break;
-          }
-        }
-        break;
-
-      case '8': // Toggle operation mode
-        stopPeriodicMeasurement();
-        opMode = 1 - opMode;
-        updateOpMode(opMode);
-        break;
-
-      case '9': // Perform Self Test
-        stopPeriodicMeasurement();
-        performSelfTest();
-        break;
-
-      default: // includes the case 'no input'
-        Serial.readStringUntil('\n'); // clean the buffer in serial
-        showMenu();
-    }
+  while (Serial.available() > 0) {
+    reportConsole(console.feed(Serial.read()));
   }
+  runner.update(millis());
+  pollMeasurement();
 }
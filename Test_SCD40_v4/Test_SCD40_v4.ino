@@ -1,9 +1,16 @@
 #include <Arduino.h>
 #include <SensirionI2CScd4x.h>
+#include <Scd4xWindowStats.h>
+#include <Scd4xOutlierFilter.h>
+#include <Scd4xTelemetry.h>
 #include <Wire.h>
 
 SensirionI2CScd4x scd4x;
 
+// 1: send samples and read errors as binary telemetry frames, decoded on the
+// host with scd4x_telemetry; 0: print them as text
+#define BINARY_TELEMETRY 0
+
 typedef enum {
   LOW_POWER,
   HIGH_PERF,
@@ -13,6 +20,18 @@ opMode_t    opMode          = HIGH_PERF;    // { 1:high performance mode,   0:Lo
 uint16_t    updateInterval  = 5000; // {5s:high performance mode, 30s:Low Power operation}
 int         ascState        = 1;    // { 1: enabled, 0: disabled }
 
+Scd4xSample           sampleBuffer[2];
+Scd4xSampleRing       sampleRing(sampleBuffer, 2);
+Scd4xSampleFilter<>   sampleFilter;         // flags implausible samples
+Scd4xMeasurementStats stats;                // 1m/15m/1h windows, ~4.2 kB RAM, ~0.8 kB on Uno
+uint32_t              lastStatsPrint  = 0;
+
+void writeSerial(const uint8_t data[], size_t length) {
+  Serial.write(data, length);
+}
+
+Scd4xTelemetrySink    telemetrySink(writeSerial);
+
 void updateOpMode(opMode_t mode) {
   if (mode == HIGH_PERF) {
     opMode = HIGH_PERF;
@@ -126,6 +145,30 @@ void setAutomaticSelfCalibration(uint16_t ascEnabled) {
   }
 }
 
+void printSample(const Scd4xSample &sample) {
+  if (sample.flags & SampleInvalidCo2) {
+    Serial.println(F("WARN> Invalid sample detected, skipping."));
+    return;
+  }
+  if (sample.flags & (SampleOutlier | SampleRateLimited)) {
+    Serial.print(F("WARN> Implausible sample flagged: "));
+  }
+#if 0
+  Serial.print(F("Co2:"));
+  Serial.print(sample.co2);
+  Serial.print(F("\tTemperature:"));
+  Serial.print(sample.temperature);
+  Serial.print(F("\tHumidity:"));
+  Serial.println(sample.humidity);
+#else
+  Serial.print(sample.co2);
+  Serial.print(F(", "));
+  Serial.print(sample.temperature);
+  Serial.print(F(", "));
+  Serial.println(sample.humidity);
+#endif
+}
+
 void readMeasurement() {
   uint16_t error;
   uint16_t co2;
@@ -144,27 +187,69 @@ void readMeasurement() {
   error = scd4x.readMeasurement(co2, temperature, humidity);
 
   if (error) {
+#if BINARY_TELEMETRY
+    telemetrySink.onError(error);
+#else
     printErrorMsg(__func__, error);
-  } else if (co2 == 0) {
-    Serial.println(F("WARN> Invalid sample detected, skipping."));
-  } else {
-#if 0
-    Serial.print(F("Co2:"));
-    Serial.print(co2);
-    Serial.print(F("\tTemperature:"));
-    Serial.print(temperature);
-    Serial.print(F("\tHumidity:"));
-    Serial.println(humidity);
+#endif
+  }
+
+  Scd4xSample sample;
+  while (sampleRing.pop(sample)) {
+    sampleFilter.apply(sample);
+#if BINARY_TELEMETRY
+    telemetrySink.onSample(sample);
 #else
-    Serial.print(co2);
-    Serial.print(F(", "));
-    Serial.print(temperature);
-    Serial.print(F(", "));
-    Serial.println(humidity);
+    printSample(sample);
 #endif
+    stats.add(sample);    // skips flagged samples
+  }
+  if (millis() - lastStatsPrint >= 60000) {
+    lastStatsPrint = millis();
+    stats.expire(lastStatsPrint);
+    printStats(F("CO2"), stats.co2, 0);
+    printStats(F("TMP"), stats.temperature, 1);
+    printStats(F("HUM"), stats.humidity, 2);
   }
 }
 
+float ticksToUnit(float ticks, uint8_t channel) {
+  if (channel == 1) {
+    return Scd4xMeasurementStats::toTemperature(ticks);
+  } else if (channel == 2) {
+    return Scd4xMeasurementStats::toHumidity(ticks);
+  }
+  return ticks;
+}
+
+void printAggregate(const __FlashStringHelper *label, const Scd4xAggregate &agg, uint8_t channel) {
+  Serial.print(label);
+  if (agg.count == 0) {
+    Serial.print(F("-"));
+    return;
+  }
+  Serial.print(ticksToUnit(agg.min, channel));
+  Serial.print(F("/"));
+  Serial.print(ticksToUnit(agg.mean(), channel));
+  Serial.print(F("/"));
+  Serial.print(ticksToUnit(agg.max, channel));
+}
+
+void printStats(const __FlashStringHelper *name, const Scd4xWindowStats &channelStats, uint8_t channel) {
+  Scd4xAggregate agg;
+
+  Serial.print(F("STAT> "));
+  Serial.print(name);
+  channelStats.minute(agg);
+  printAggregate(F(" 1m:"), agg, channel);
+  channelStats.quarterHour(agg);
+  printAggregate(F(" 15m:"), agg, channel);
+  channelStats.hour(agg);
+  printAggregate(F(" 1h:"), agg, channel);
+  Serial.print(F(" ewma:"));
+  Serial.println(ticksToUnit(channelStats.ewma(), channel));
+}
+
 void performForcedRecalibration(uint16_t targetCo2Concentration) {
   uint16_t error;
   uint16_t frcCorrection;
@@ -312,6 +397,7 @@ void setup() {
 
   Wire.begin();
   scd4x.begin(Wire);
+  scd4x.attachSampleRing(&sampleRing);
 
   stopPeriodicMeasurement();
   configSCDx();
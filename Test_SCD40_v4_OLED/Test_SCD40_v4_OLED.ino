@@ -1,11 +1,30 @@
 #include <Arduino.h>
 #include <SensirionI2CScd4x.h>
+#include <Scd4xMeasurementBus.h>
+#define SCD4X_PAINT_STACK_EARLY  // stack painted before main() for the RAM report
+#include <Scd4xMemory.h>
+#include <Scd4xOutlierFilter.h>
+#include <Scd4xOutputQueue.h>
+#include <Scd4xScheduler.h>
+#include <Scd4xTelemetry.h>
+#include <Scd4xTrace.h>
+#define SCD4X_RESET_FLAGS_HOOK   // MCUSR taken and cleared, watchdog stopped before main()
+#include <Scd4xWarmStart.h>
 #include <Wire.h>
 #include "U8glib.h"
 
 U8GLIB_SSD1306_128X64   u8g(13, 11, 10, 9); // SW SPI Com: SCK = 13, MOSI = 11, CS = 10, A0/DC = 9, RES/RST = arduino RST pin
 #define RST_PIN         8                   // if you want to manually control by GPIO pin
 
+// 1: send samples and read errors as binary telemetry frames, decoded on the
+// host with scd4x_telemetry; 0: print them as text
+#define BINARY_TELEMETRY 0
+
+// spans of bus transfers, command waits, tasks and display pages kept for
+// 't' on the console, which prints them as Chrome trace JSON for
+// ui.perfetto.dev; 11 bytes of RAM each, 0 disables tracing
+#define TRACE_EVENTS 0
+
 SensirionI2CScd4x       scd4x;
 
 typedef enum {
@@ -17,43 +36,76 @@ opMode_t    opMode          = HIGH_PERF;    // { 1:high performance mode,   0:Lo
 uint16_t    updateInterval  = 5000; // {5s:high performance mode, 30s:Low Power operation}
 int         ascState        = 1;    // { 1: enabled, 0: disabled }
 
-uint16_t    co2;
-float       temperature;
-float       humidity;
+Scd4xSample       sampleBuffer[4];
+Scd4xSampleRing   sampleRing(sampleBuffer, 4);  // filled by scd4x on every read
+Scd4xSampleFilter<> sampleFilter;               // flags implausible samples
+Scd4xMeasurementBus measurementBus;             // hands every sample to the sinks below
+const uint16_t    co2AlarmPpm = 1500;
+
+Scd4xTaskSlot     taskSlots[4];
+Scd4xScheduler    scheduler(taskSlots, 4);      // runs the tasks below from loop()
+int8_t            displayTaskId;
+
+uint8_t           outputBuffer[320];            // a 96 byte line per priority at least
+Scd4xOutputQueue  outputQueue(outputBuffer, sizeof(outputBuffer), Serial);
+Print            *logOut = &Serial;             // the queue once setup() is done
+
+#if TRACE_EVENTS
+Scd4xTraceEvent   traceEvents[TRACE_EVENTS];
+#endif
+u8g_dev_fnptr     displayDevFn;                 // u8glib device procedure
+uint8_t           displayPages;                 // pages sent in this frame
+
+bool              warmStart;                    // sensor and display kept their setup
+uint32_t          bootMs;                       // millis() when setup() started
+bool              firstSampleSeen;
+bool              firstFrameSeen;
 
 void updateOpMode(opMode_t mode) {
   if (mode == HIGH_PERF) {
     opMode = HIGH_PERF;
     updateInterval = 5000;
-    Serial.println(F("INFO> switch to High Performance Mode"));
+    logOut->println(F("INFO> switch to High Performance Mode"));
   } else {
     opMode = LOW_POWER;
     updateInterval = 30000;
-    Serial.println(F("INFO> switch to Low Power Mode"));
+    logOut->println(F("INFO> switch to Low Power Mode"));
   }
 }
 
 void printUint16Hex(uint16_t value) {
-  Serial.print(value < 4096 ? "0" : "");
-  Serial.print(value < 256 ? "0" : "");
-  Serial.print(value < 16 ? "0" : "");
-  Serial.print(value, HEX);
+  logOut->print(value < 4096 ? "0" : "");
+  logOut->print(value < 256 ? "0" : "");
+  logOut->print(value < 16 ? "0" : "");
+  logOut->print(value, HEX);
 }
 
 void printSerialNumber(uint16_t serial0, uint16_t serial1, uint16_t serial2) {
-  Serial.print("INFO> SN: 0x");
+  logOut->print("INFO> SN: 0x");
   printUint16Hex(serial0);
   printUint16Hex(serial1);
   printUint16Hex(serial2);
-  Serial.println();
+  logOut->println();
+}
+
+// time from setup() to the first sample or frame
+void printBootTime(const __FlashStringHelper *what) {
+  logOut->print(warmStart ? F("INFO> warm") : F("INFO> cold"));
+  logOut->print(F(" boot to first "));
+  logOut->print(what);
+  logOut->print(F(": "));
+  logOut->print(millis() - bootMs);
+  logOut->println(F(" ms"));
 }
 
-void printErrorMsg(String fucName, uint16_t err) {
-  char errMsg[256];
+void printErrorMsg(const char *fucName, uint16_t err) {
+  char errMsg[80];  // on the stack, the longest error text has 75 characters
 
-  Serial.print("ERRO> " + fucName + "(): ");
-  errorToString(err, errMsg, 256);
-  Serial.println(errMsg);
+  logOut->print(F("ERRO> "));
+  logOut->print(fucName);
+  logOut->print(F("(): "));
+  errorToString(err, errMsg, sizeof(errMsg));
+  logOut->println(errMsg);
 }
 
 void stopPeriodicMeasurement() {
@@ -64,13 +116,12 @@ void stopPeriodicMeasurement() {
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    Serial.println(F("INFO> stop periodic measurement"));
+    logOut->println(F("INFO> stop periodic measurement"));
   }
 }
 
 void startPeriodicMeasurement() {
   uint16_t error;
-  String tmp = "";
 
   if (opMode == HIGH_PERF) {
     error = scd4x.startPeriodicMeasurement();
@@ -81,10 +132,23 @@ void startPeriodicMeasurement() {
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    tmp = (opMode == HIGH_PERF) ? "(High Performance)" : "(Low Power)";
-    Serial.print(F("INFO> start periodic measurement "));
-    Serial.println(tmp);
+    logOut->print(F("INFO> start periodic measurement "));
+    logOut->println((opMode == HIGH_PERF) ? F("(High Performance)")
+                                          : F("(Low Power)"));
+  }
+}
+
+bool isMeasuring() {
+  uint16_t error;
+  bool measuring;
+
+  error = scd4x.isMeasuring(measuring);
+
+  if (error) {
+    printErrorMsg(__func__, error);
+    return false;
   }
+  return measuring;
 }
 
 void getSerialNumber() {
@@ -113,13 +177,13 @@ void getAutomaticSelfCalibration() {
   } else {
     if (ascEnabled == 1) {
       ascState = 1;
-      Serial.println(F("INFO> ASC is enabled"));
+      logOut->println(F("INFO> ASC is enabled"));
     } else if (ascEnabled == 0) {
       ascState = 0;
-      Serial.println(F("INFO> ASC is disabled"));
+      logOut->println(F("INFO> ASC is disabled"));
     } else {
       ascState = -1;
-      Serial.println(F("WARN> Unknown ASC state"));
+      logOut->println(F("WARN> Unknown ASC state"));
     }
   }
 }
@@ -134,29 +198,51 @@ void setAutomaticSelfCalibration(uint16_t ascEnabled) {
   }
 }
 
-void readMeasurement() {
-  uint16_t error;
-
-  delay(updateInterval);
+void printSample(const Scd4xSample &sample) {
+  if (sample.flags & SampleInvalidCo2) {
+    logOut->println(F("WARN> Invalid sample detected, skipping."));
+    return;
+  }
+  if (sample.flags & (SampleOutlier | SampleRateLimited)) {
+    logOut->print(F("WARN> Implausible sample flagged: "));
+  }
+  logOut->print(F("Co2:"));
+  logOut->print(sample.co2);
+  logOut->print(F("\tTemperature:"));
+  logOut->print(sample.temperature);
+  logOut->print(F("\tHumidity:"));
+  logOut->println(sample.humidity);
+}
 
-  error = scd4x.readMeasurement(co2, temperature, humidity);
+// sensor task: polls data ready and reads the sample as soon as there is
+// one, instead of waiting the whole measurement interval in delay()
+void sensorTask(uint32_t) {
+  uint16_t error;
+  uint16_t dataReady;
+  uint16_t co2;
+  float temperature;
+  float humidity;
+  Scd4xSample sample;
+
+  error = scd4x.getDataReadyStatus(dataReady);
+  if (!error && !(dataReady & 0x07FF)) {
+    return;
+  }
+  if (!error) {
+    error = scd4x.readMeasurement(co2, temperature, humidity);
+  }
 
   if (error) {
-    printErrorMsg(__func__, error);
-    co2 = 0;    /* unsigned */
-    temperature = -1;
-    humidity = -1;
-  } else if (co2 == 0) {
-    Serial.println(F("WARN> Invalid sample detected, skipping."));
-    temperature = 0;
-    humidity = 0;
-  } else {
-    Serial.print(F("Co2:"));
-    Serial.print(co2);
-    Serial.print(F("\tTemperature:"));
-    Serial.print(temperature);
-    Serial.print(F("\tHumidity:"));
-    Serial.println(humidity);
+    measurementBus.publishError(error);
+  }
+
+  while (sampleRing.pop(sample)) {
+    sampleFilter.apply(sample);
+    measurementBus.publish(sample);
+    if (!firstSampleSeen) {
+      firstSampleSeen = true;
+      printBootTime(F("sample"));
+    }
   }
 }
 
@@ -170,13 +256,13 @@ void performForcedRecalibration(uint16_t targetCo2Concentration) {
     printErrorMsg(__func__, error);
   } else {
     if (frcCorrection == 0xffff) {
-      Serial.print(F("WARN> FRC correction failed!"));
+      logOut->print(F("WARN> FRC correction failed!"));
     } else {
-      Serial.print(F("INFO> set correction:"));
-      Serial.print(targetCo2Concentration);
-      Serial.print(F(", offset: "));
-      Serial.print((frcCorrection - 32768.0), 2);
-      Serial.println(F(" ppm"));
+      logOut->print(F("INFO> set correction:"));
+      logOut->print(targetCo2Concentration);
+      logOut->print(F(", offset: "));
+      logOut->print((frcCorrection - 32768.0), 2);
+      logOut->println(F(" ppm"));
     }
   }
 }
@@ -189,7 +275,7 @@ void performFactoryReset() {
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    Serial.println(F("INFO> perform factory reset"));
+    logOut->println(F("INFO> perform factory reset"));
   }
 }
 
@@ -202,10 +288,10 @@ void getTemperatureOffset() {
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    //Serial.println(tOffset);
-    Serial.print(F("INFO> offset temperature:"));
-    Serial.print(tOffset, 2);
-    Serial.println(F("°C"));
+    //logOut->println(tOffset);
+    logOut->print(F("INFO> offset temperature:"));
+    logOut->print(tOffset, 2);
+    logOut->println(F("°C"));
   }
 }
 
@@ -217,8 +303,8 @@ void setTemperatureOffset(uint16_t tOffset) {
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    Serial.print(F("INFO> set temperature offset: 0x"));
-    Serial.println(tOffset, HEX);
+    logOut->print(F("INFO> set temperature offset: 0x"));
+    logOut->println(tOffset, HEX);
   }
 }
 
@@ -230,7 +316,7 @@ void persistSettings() {
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    Serial.println(F("INFO> persist settings"));
+    logOut->println(F("INFO> persist settings"));
   }
 }
 
@@ -242,7 +328,7 @@ void reinit() {
   if (error) {
     printErrorMsg(__func__, error);
   } else {
-    Serial.println(F("INFO> reinit"));
+    logOut->println(F("INFO> reinit"));
   }
 }
 
@@ -262,13 +348,42 @@ void configSCDx() {
   //reinit();
 }
 
+// wraps the u8glib device procedure: every page buffer transfer
+// (u8g_pb_WriteBuffer on U8G_DEV_MSG_PAGE_NEXT) is traced as a span, and on
+// a warm start the controller init sequence is left out
+uint8_t hookedDisplayDevFn(u8g_t *u8g, u8g_dev_t *dev, uint8_t msg, void *arg) {
+  if (msg == U8G_DEV_MSG_INIT && warmStart) {
+    // the controller kept its setup, the constructor set up the pins
+    return 1;
+  } else if (msg == U8G_DEV_MSG_PAGE_FIRST) {
+    displayPages = 0;
+  } else if (msg == U8G_DEV_MSG_PAGE_NEXT) {
+    Scd4xTraceScope page(TraceDisplayPage, displayPages++);
+    return displayDevFn(u8g, dev, msg, arg);
+  }
+  return displayDevFn(u8g, dev, msg, arg);
+}
+
+void hookDisplay() {
+  u8g_dev_t *dev = u8g.getU8g()->dev;
+
+  displayDevFn = dev->dev_fn;
+  dev->dev_fn = hookedDisplayDevFn;
+}
+
 void clearScreen(void) {
+  Scd4xTraceScope frame(TraceDisplayFrame);
+
   u8g.firstPage();
   do {
   } while (u8g.nextPage());
+  frame.setArg(displayPages);
 }
 
-void drawData(void) {
+void drawData(const Scd4xSample *sample) {
+  bool valid = sample && !(sample->flags & SampleRejectMask);
+  Scd4xTraceScope frame(TraceDisplayFrame);
+
   u8g.firstPage();
   do {
     //u8g.setFont(u8g_font_unifont);
@@ -276,31 +391,32 @@ void drawData(void) {
 
     u8g.setPrintPos(0, 20);
     u8g.print("CO2:");
-    if (co2 == 0) {
+    if (!valid) {
       u8g.print("err ");
     } else {
-      u8g.print(co2);
+      u8g.print(sample->co2);
     }
     u8g.print("ppm");
 
     u8g.setPrintPos(0, 40);
     u8g.print("TMP:");
-    if (temperature < 0) {
+    if (!valid || sample->temperature < 0) {
       u8g.print("err ");
     } else {
-      u8g.print(temperature);
+      u8g.print(sample->temperature);
     }
     u8g.print("C");
 
     u8g.setPrintPos(0, 60);
     u8g.print("HUM:");
-    if (humidity < 0) {
+    if (!valid) {
       u8g.print("err ");
     } else {
-      u8g.print(humidity);
+      u8g.print(sample->humidity);
     }
     u8g.print("%");
   } while (u8g.nextPage());
+  frame.setArg(displayPages);
 }
 
 void drawTest(void) {
@@ -326,23 +442,268 @@ void resetOLED() {
   digitalWrite(RST_PIN, HIGH);
 }
 
+// sinks of the measurement bus, each gets the sample by reference
+class SerialSink : public Scd4xSampleSink {
+  public:
+    void onSample(const Scd4xSample &sample) {
+      printSample(sample);
+    }
+    void onError(uint16_t error) {
+      printErrorMsg("readMeasurement", error);
+    }
+};
+
+// keeps the latest sample and lets the display task redraw, so the slow
+// software SPI transfer does not delay the other sinks
+class DisplaySink : public Scd4xSampleSink {
+  public:
+    void onSample(const Scd4xSample &sample) {
+      latest = sample;
+      valid = true;
+      scheduler.trigger(displayTaskId, millis());
+    }
+    void onError(uint16_t) {
+      valid = false;
+      scheduler.trigger(displayTaskId, millis());
+    }
+
+    Scd4xSample latest;
+    bool valid = false;
+};
+
+class AlarmSink : public Scd4xSampleSink {
+  public:
+    void onSample(const Scd4xSample &sample) {
+      bool high = !(sample.flags & SampleRejectMask) && sample.co2 >= co2AlarmPpm;
+
+      if (high != active) {
+        active = high;
+        logOut->println(high ? F("WARN> CO2 above alarm level, ventilate")
+                            : F("INFO> CO2 back below alarm level"));
+      }
+    }
+
+  private:
+    bool active = false;
+};
+
+void writeSerial(const uint8_t data[], size_t length) {
+  outputQueue.write(OutputCritical, data, length);
+}
+
+SerialSink  serialSink;
+Scd4xTelemetrySink telemetrySink(writeSerial);
+DisplaySink displaySink;
+AlarmSink   alarmSink;
+
+void displayTask(uint32_t) {
+  drawData(displaySink.valid ? &displaySink.latest : nullptr);
+  if (!firstFrameSeen) {
+    // the display is set up now, a reset from here on may skip that
+    firstFrameSeen = true;
+    printBootTime(F("frame"));
+    Scd4xWarmStart::mark();
+  }
+}
+
+// loop jitter and CPU time per task since the last reset
+void printSchedulerStats(uint32_t nowMs) {
+  uint32_t elapsedMs = scheduler.elapsedMs(nowMs);
+
+  logOut->print(F("STAT> loop max "));
+  logOut->print(scheduler.maxLoopUs());
+  logOut->print(F(" us, busy "));
+  logOut->print(elapsedMs ? scheduler.busyUs() / (elapsedMs * 10.0) : 0.0, 1);
+  logOut->println(F(" %"));
+
+  for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+    const Scd4xTaskStats &stats = scheduler.taskStats(i);
+
+    logOut->print(F("STAT> "));
+    logOut->print(scheduler.taskName(i));
+    logOut->print(F(": runs "));
+    logOut->print(stats.runs);
+    logOut->print(F(", cpu "));
+    logOut->print(stats.totalUs);
+    logOut->print(F(" us, max "));
+    logOut->print(stats.maxUs);
+    logOut->print(F(" us, late "));
+    logOut->print(stats.maxLatenessMs);
+    logOut->print(F(" ms, missed "));
+    logOut->println(stats.missedDeadlines);
+  }
+
+  logOut->print(F("STAT> output dropped "));
+  logOut->print(outputQueue.droppedLines());
+  logOut->print(F(" lines, "));
+  logOut->print(outputQueue.droppedBytes());
+  logOut->println(F(" bytes"));
+}
+
+// stack high-water mark and heap fragmentation
+void printMemoryStats() {
+  Scd4xHeapStats heap;
+
+  Scd4xMemory::heapStats(heap);
+  logOut->print(F("STAT> stack high water "));
+  logOut->print(Scd4xMemory::stackHighWater());
+  logOut->print(F(" B, never used "));
+  logOut->print(Scd4xMemory::stackUnused());
+  logOut->print(F(" B, free now "));
+  logOut->print(Scd4xMemory::freeRam());
+  logOut->println(F(" B"));
+
+  logOut->print(F("STAT> heap "));
+  logOut->print(heap.heapSize);
+  logOut->print(F(" B, free "));
+  logOut->print(heap.freeBytes);
+  logOut->print(F(" B in "));
+  logOut->print(heap.fragments);
+  logOut->print(F(" blocks, largest "));
+  logOut->print(heap.largestFree);
+  logOut->println(F(" B"));
+}
+
+void printRamRegion(const __FlashStringHelper *name, size_t size) {
+  logOut->print(F("STAT> ram "));
+  logOut->print(name);
+  logOut->print(F(": "));
+  logOut->print(size);
+  logOut->println(F(" B"));
+}
+
+// static RAM of the larger components, the rest of .data and .bss is the
+// Arduino core and smaller globals
+void printMemoryReport() {
+  const u8g_pb_t *pb = (const u8g_pb_t *)u8g.getU8g()->dev->dev_mem;
+
+  printMemoryStats();
+  printRamRegion(F("static total"), Scd4xMemory::staticRam());
+  printRamRegion(F("u8glib page buffer"), pb->width * pb->p.page_height / 8);
+  printRamRegion(F("u8glib object"), sizeof(u8g));
+  printRamRegion(F("serial"), sizeof(Serial));
+#ifdef BUFFER_LENGTH
+  // TwoWire rx/tx and the three twi buffers
+  printRamRegion(F("wire buffers"), 5 * BUFFER_LENGTH);
+#endif
+  printRamRegion(F("sensirion driver"), sizeof(scd4x));
+  printRamRegion(F("sample ring"), sizeof(sampleBuffer) + sizeof(sampleRing));
+  printRamRegion(F("sample filter"), sizeof(sampleFilter));
+  printRamRegion(F("measurement bus"), sizeof(measurementBus));
+  printRamRegion(F("scheduler"), sizeof(taskSlots) + sizeof(scheduler));
+  printRamRegion(F("output queue"), sizeof(outputBuffer) + sizeof(outputQueue));
+  printRamRegion(F("display sink"), sizeof(displaySink));
+#if TRACE_EVENTS
+  printRamRegion(F("trace ring"), sizeof(traceEvents));
+#endif
+}
+
+// reports have more lines than the queue holds: they go straight to
+// Serial after the queued lines, waiting for the UART
+void beginReport() {
+  outputQueue.drain(sizeof(outputBuffer));
+  logOut = &Serial;
+}
+
+void endReport() {
+  logOut = &outputQueue;
+}
+
+// the recorded spans as Chrome trace JSON; the ring starts over afterwards
+void printTrace() {
+  beginReport();
+  Scd4xTrace::writeJson(Serial, &scheduler);
+  Scd4xTrace::clear();
+  endReport();
+}
+
+// console task: 's' prints the scheduler statistics, 'r' resets them,
+// 'm' prints the RAM report, 't' the trace
+void consoleTask(uint32_t nowMs) {
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+
+    if (c == 's') {
+      beginReport();
+      printSchedulerStats(nowMs);
+      endReport();
+    } else if (c == 'r') {
+      scheduler.resetStats(nowMs);
+      logOut->println(F("INFO> scheduler statistics reset"));
+    } else if (c == 'm') {
+      beginReport();
+      printMemoryReport();
+      endReport();
+    } else if (c == 't') {
+      printTrace();
+    }
+  }
+}
+
+void loggingTask(uint32_t nowMs) {
+  beginReport();
+  printSchedulerStats(nowMs);
+  printMemoryStats();
+  endReport();
+}
+
 void setup() {
+  bootMs = millis();
+  warmStart = Scd4xWarmStart::warm();
+
   Serial.begin(115200);
-  while (!Serial) {
+  // after a reset without power cycle keep measuring, terminal or not
+  while (!warmStart && !Serial) {
     delay(100);
   }
 
+#if TRACE_EVENTS
+  Scd4xTrace::attach(traceEvents, TRACE_EVENTS);
+#endif
+  hookDisplay();
+
   Wire.begin();
   scd4x.begin(Wire);
+  scd4x.attachSampleRing(&sampleRing);
+
+#if BINARY_TELEMETRY
+  measurementBus.subscribe(telemetrySink);
+#else
+  measurementBus.subscribe(serialSink);
+#endif
+  measurementBus.subscribe(displaySink);
+  measurementBus.subscribe(alarmSink);  // every sample, no crossing is missed
+
+  if (warmStart) {
+    warmStart = isMeasuring();
+  }
+  if (warmStart) {
+    // no stop, configuration read-out, display reset or init sequence
+    logOut->println(F("INFO> warm start, sensor still measuring"));
+    updateOpMode(HIGH_PERF);  // the mode configSCDx() selects
+    u8g.begin();
+  } else {
+    Scd4xWarmStart::clear();
+    stopPeriodicMeasurement();
+    configSCDx();
+    startPeriodicMeasurement();
+
+    resetOLED();
+  }
 
-  stopPeriodicMeasurement();
-  configSCDx();
-  startPeriodicMeasurement();
+  uint32_t now = millis();
+  // priority: sensor before console before display before logging
+  scheduler.addTask("sensor", sensorTask, updateInterval / 10, 3, 0, now);
+  scheduler.addTask("console", consoleTask, 50, 2, 0, now);
+  displayTaskId = scheduler.addTask("display", displayTask, 0, 1, 200, now);
+  scheduler.addTask("logging", loggingTask, 60000, 0, 0, now + 60000);
+  scheduler.resetStats(now);
 
-  resetOLED();
+  // from now on log lines are queued instead of waiting for the UART
+  logOut = &outputQueue;
 }
 
 void loop() {
-  readMeasurement();
-  drawData();
+  scheduler.update(millis());
+  outputQueue.drain(Serial.availableForWrite());
 }
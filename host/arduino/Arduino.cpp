@@ -0,0 +1,259 @@
+/*
+ * Host implementation of the Arduino core subset and the simulated Wire bus.
+ */
+#include <time.h>
+
+#include "Arduino.h"
+#include "Wire.h"
+
+uint64_t VirtualClock::_now = 0;
+uint64_t VirtualClock::_originNs = 0;
+uint32_t VirtualClock::_speedup = 0;
+
+static uint64_t monotonicNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+void VirtualClock::followRealTime(uint32_t speedup) {
+    // continue from the current reading in either direction
+    _now = micros();
+    _originNs = monotonicNs();
+    _speedup = speedup;
+}
+
+uint64_t VirtualClock::_realMicros() {
+    return _now + (monotonicNs() - _originNs) * _speedup / 1000;
+}
+
+void VirtualClock::_sleep(uint64_t us) {
+    uint64_t ns = us * 1000 / _speedup;
+    struct timespec duration;
+
+    duration.tv_sec = static_cast<time_t>(ns / 1000000000ULL);
+    duration.tv_nsec = static_cast<long>(ns % 1000000000ULL);
+    while (nanosleep(&duration, &duration)) {
+    }
+}
+
+TwoWire Wire;
+
+size_t Print::print(const __FlashStringHelper* text) {
+    return print(reinterpret_cast<const char*>(text));
+}
+
+size_t Print::print(const char text[]) {
+    return write(text);
+}
+
+size_t Print::print(char c) {
+    return write(static_cast<uint8_t>(c));
+}
+
+size_t Print::print(unsigned char value, int base) {
+    return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(int value, int base) {
+    return print(static_cast<long>(value), base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+    return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(long value, int base) {
+    if (base == 0) {
+        return write(static_cast<uint8_t>(value));
+    }
+    if (base == DEC && value < 0) {
+        size_t n = print('-');
+        return n + _printNumber(-static_cast<unsigned long>(value), DEC);
+    }
+    return _printNumber(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    if (base == 0) {
+        return write(static_cast<uint8_t>(value));
+    }
+    return _printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits) {
+    return _printFloat(value, digits);
+}
+
+size_t Print::println() {
+    return write("\r\n");
+}
+
+size_t Print::_printNumber(unsigned long value, uint8_t base) {
+    char buffer[8 * sizeof(long) + 1];
+    char* text = &buffer[sizeof(buffer) - 1];
+
+    *text = '\0';
+    if (base < 2) {
+        base = 10;
+    }
+    do {
+        char digit = static_cast<char>(value % base);
+        value /= base;
+        *--text = digit < 10 ? digit + '0' : digit + 'A' - 10;
+    } while (value);
+    return write(text);
+}
+
+size_t Print::_printFloat(double value, uint8_t digits) {
+    size_t n = 0;
+
+    if (isnan(value)) {
+        return print("nan");
+    }
+    if (isinf(value)) {
+        return print("inf");
+    }
+    if (value > 4294967040.0 || value < -4294967040.0) {
+        return print("ovf");
+    }
+    if (value < 0.0) {
+        n += print('-');
+        value = -value;
+    }
+
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; i++) {
+        rounding /= 10.0;
+    }
+    value += rounding;
+
+    unsigned long integer = static_cast<unsigned long>(value);
+    double remainder = value - static_cast<double>(integer);
+    n += print(integer);
+    if (digits > 0) {
+        n += print('.');
+    }
+    while (digits-- > 0) {
+        remainder *= 10.0;
+        unsigned int digit = static_cast<unsigned int>(remainder);
+        n += print(digit);
+        remainder -= digit;
+    }
+    return n;
+}
+
+unsigned long millis() {
+    return static_cast<unsigned long>(VirtualClock::micros() / 1000);
+}
+
+unsigned long micros() {
+    return static_cast<unsigned long>(VirtualClock::micros());
+}
+
+void delay(unsigned long ms) {
+    VirtualClock::advance(static_cast<uint64_t>(ms) * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    VirtualClock::advance(us);
+}
+
+void yield() {
+}
+
+static uint8_t pinLevels[64];
+static PinWriteHandler pinWriteHandler;
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < sizeof(pinLevels)) {
+        pinLevels[pin] = value ? HIGH : LOW;
+    }
+    if (pinWriteHandler) {
+        pinWriteHandler(pin, value);
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < sizeof(pinLevels) ? pinLevels[pin] : LOW;
+}
+
+void setPinWriteHandler(PinWriteHandler handler) {
+    pinWriteHandler = handler;
+}
+
+void TwoWire::attach(uint8_t address, I2cDevice* device) {
+    _devices[address & 0x7F] = device;
+}
+
+// start condition, address byte and data bytes with their ACK bit each
+void TwoWire::_transfer(size_t bytes) {
+    _transactions++;
+    if (!VirtualClock::isRealTime()) {
+        VirtualClock::advance((1 + bytes) * 9 * 1000000ULL / _frequency + 1);
+    }
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    _address = address & 0x7F;
+    _txLength = 0;
+    _txOverflow = false;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (_txLength == BUFFER_LENGTH) {
+        _txOverflow = true;
+        return 0;
+    }
+    _txBuffer[_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t data[], size_t length) {
+    size_t written = 0;
+    while (written < length && write(data[written])) {
+        written++;
+    }
+    return written;
+}
+
+uint8_t TwoWire::endTransmission(uint8_t) {
+    if (_txOverflow) {
+        return 1;
+    }
+    I2cDevice* device = _devices[_address];
+    if (!device) {
+        _transfer(0);
+        return 2;
+    }
+    uint8_t result = device->onWrite(_txBuffer, _txLength);
+    _transfer(result == 2 ? 0 : _txLength);
+    return result;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t) {
+    I2cDevice* device = _devices[address & 0x7F];
+
+    if (quantity > BUFFER_LENGTH) {
+        quantity = BUFFER_LENGTH;
+    }
+    _rxIndex = 0;
+    _rxLength = device ? device->onRead(_rxBuffer, quantity) : 0;
+    _transfer(_rxLength);
+    return _rxLength;
+}
+
+int TwoWire::available() {
+    return _rxLength - _rxIndex;
+}
+
+int TwoWire::read() {
+    return (_rxIndex < _rxLength) ? _rxBuffer[_rxIndex++] : -1;
+}
+
+int TwoWire::peek() {
+    return (_rxIndex < _rxLength) ? _rxBuffer[_rxIndex] : -1;
+}
@@ -0,0 +1,117 @@
+/*
+ * Arduino.h - Subset of the Arduino core for host builds, enough to compile
+ * the libraries in this repository unchanged. Time is virtual, see
+ * VirtualClock.h.
+ */
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "VirtualClock.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*reinterpret_cast<const uint8_t*>(address))
+#define pgm_read_word(address) (*reinterpret_cast<const uint16_t*>(address))
+#define pgm_read_dword(address) (*reinterpret_cast<const uint32_t*>(address))
+#define memcpy_P(destination, source, length) memcpy(destination, source, length)
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// host only: called on every digitalWrite(), to wire a pin to a simulated
+// device
+typedef void (*PinWriteHandler)(uint8_t pin, uint8_t value);
+void setPinWriteHandler(PinWriteHandler handler);
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// string literals stay in RAM on the host, F() only changes the type so the
+// Print overload for flash strings is chosen like on the boards
+class __FlashStringHelper;
+#define F(string) (reinterpret_cast<const __FlashStringHelper*>(string))
+
+class Print {
+  public:
+    virtual size_t write(uint8_t data) = 0;
+
+    virtual size_t write(const uint8_t buffer[], size_t size) {
+        size_t written = 0;
+        while (written < size && write(buffer[written])) {
+            written++;
+        }
+        return written;
+    }
+
+    size_t write(const char text[]) {
+        return write(reinterpret_cast<const uint8_t*>(text), strlen(text));
+    }
+
+    virtual int availableForWrite() {
+        return 0;
+    }
+
+    virtual void flush() {
+    }
+
+    // same formatting as the Arduino core
+    size_t print(const __FlashStringHelper* text);
+    size_t print(const char text[]);
+    size_t print(char c);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    template <typename T> size_t println(T value) {
+        size_t n = print(value);
+        return n + println();
+    }
+    template <typename T> size_t println(T value, int format) {
+        size_t n = print(value, format);
+        return n + println();
+    }
+
+  private:
+    size_t _printNumber(unsigned long value, uint8_t base);
+    size_t _printFloat(double value, uint8_t digits);
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+#include "HardwareSerial.h"
+
+#endif /* ARDUINO_H */
@@ -0,0 +1,101 @@
+/*
+ * Host Serial on stdio with the AVR core's transmit buffer timing.
+ */
+#include <poll.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+
+HardwareSerial Serial;
+
+void HardwareSerial::_poll() {
+    struct pollfd fd = {_inputFd, POLLIN, 0};
+    char buffer[64];
+
+    if (_inputFd < 0 || poll(&fd, 1, 0) <= 0) {
+        return;
+    }
+    ssize_t length = ::read(_inputFd, buffer, sizeof(buffer));
+    if (length > 0) {
+        _input.append(buffer, length);
+    } else {
+        _inputFd = -1;
+    }
+}
+
+int HardwareSerial::available() {
+    if (_inputIndex == _input.size()) {
+        _input.clear();
+        _inputIndex = 0;
+        _poll();
+    }
+    return static_cast<int>(_input.size() - _inputIndex);
+}
+
+int HardwareSerial::read() {
+    if (!available()) {
+        return -1;
+    }
+    return static_cast<uint8_t>(_input[_inputIndex++]);
+}
+
+int HardwareSerial::peek() {
+    if (!available()) {
+        return -1;
+    }
+    return static_cast<uint8_t>(_input[_inputIndex]);
+}
+
+// bytes in the transmit buffer and shift register
+uint64_t HardwareSerial::_queued() {
+    uint64_t now = VirtualClock::micros();
+    uint64_t byteUs = 10000000ULL / _baud;
+
+    return _txDoneUs > now ? (_txDoneUs - now + byteUs - 1) / byteUs : 0;
+}
+
+size_t HardwareSerial::write(uint8_t data) {
+    if (_baud) {
+        uint64_t byteUs = 10000000ULL / _baud;
+        uint64_t queued = _queued();
+
+        if (queued >= SERIAL_TX_BUFFER_SIZE) {
+            // wait like the AVR core until a byte has left the buffer
+            VirtualClock::advance(_txDoneUs - VirtualClock::micros() -
+                                  (SERIAL_TX_BUFFER_SIZE - 1) * byteUs);
+        }
+        uint64_t now = VirtualClock::micros();
+        _txDoneUs = (_txDoneUs > now ? _txDoneUs : now) + byteUs;
+    }
+    if (_output) {
+        fputc(data, _output);
+    }
+    _written++;
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t buffer[], size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        write(buffer[i]);
+    }
+    return size;
+}
+
+int HardwareSerial::availableForWrite() {
+    if (!_baud) {
+        return SERIAL_TX_BUFFER_SIZE - 1;
+    }
+    uint64_t queued = _queued();
+    return queued < SERIAL_TX_BUFFER_SIZE - 1
+               ? static_cast<int>(SERIAL_TX_BUFFER_SIZE - 1 - queued)
+               : 0;
+}
+
+void HardwareSerial::flush() {
+    if (_baud && _txDoneUs > VirtualClock::micros()) {
+        VirtualClock::advance(_txDoneUs - VirtualClock::micros());
+    }
+    if (_output) {
+        fflush(_output);
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * HardwareSerial.h - Serial for host builds. Output goes to a FILE, stdout
+ * by default. After begin(baud) the transmitter is modelled like the AVR
+ * core: a 64 byte buffer drained at baud / 10 bytes per second of virtual
+ * time, and write() waits for space when it is full, so sketches see the
+ * same availableForWrite() and blocking as on a board. Input comes from
+ * bytes queued with inject() and, if set, from a file descriptor which is
+ * read without blocking.
+ */
+#ifndef HARDWARE_SERIAL_H
+#define HARDWARE_SERIAL_H
+
+#include <stdio.h>
+#include <string>
+
+#define SERIAL_TX_BUFFER_SIZE 64
+
+class HardwareSerial : public Stream {
+  public:
+    void begin(unsigned long baud) {
+        _baud = baud;
+    }
+
+    void end() {
+    }
+
+    // the USB serial of some boards is false until the host opens it
+    explicit operator bool() const {
+        return true;
+    }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t buffer[], size_t size) override;
+    using Print::write;
+    int availableForWrite() override;
+    void flush() override;
+
+    // nullptr discards the output
+    void setOutput(FILE* output) {
+        _output = output;
+    }
+
+    // read input from fd as well, e.g. stdin when following real time
+    void setInput(int fd) {
+        _inputFd = fd;
+    }
+
+    // queue bytes for read()
+    void inject(const char data[], size_t length) {
+        _input.append(data, length);
+    }
+
+    uint64_t bytesWritten() const {
+        return _written;
+    }
+
+  private:
+    void _poll();
+    uint64_t _queued();
+
+    FILE* _output = stdout;
+    int _inputFd = -1;
+    std::string _input;
+    size_t _inputIndex = 0;
+    unsigned long _baud = 0;
+    uint64_t _txDoneUs = 0;  // end of the transmission of the last byte
+    uint64_t _written = 0;
+};
+
+extern HardwareSerial Serial;
+
+#endif /* HARDWARE_SERIAL_H */
@@ -0,0 +1,5 @@
+/*
+ * Print.h - The host Print class lives in Arduino.h; libraries such as
+ * U8glib include it by this name.
+ */
+#include "Arduino.h"
@@ -0,0 +1,60 @@
+/*
+ * VirtualClock - Time base of the host Arduino environment. millis(),
+ * micros() and delay() read and advance this clock instead of waiting, so a
+ * simulated day passes in milliseconds and every run sees the same times.
+ *
+ * Programs which interact with the outside world, like the scd4xd daemon,
+ * can let the clock follow the monotonic system clock instead, optionally
+ * sped up; delay() then sleeps.
+ */
+#ifndef VIRTUAL_CLOCK_H
+#define VIRTUAL_CLOCK_H
+
+#include <stdint.h>
+
+class VirtualClock {
+  public:
+    static uint64_t micros() {
+        return _speedup ? _realMicros() : _now;
+    }
+
+    static void advance(uint64_t us) {
+        if (_speedup) {
+            _sleep(us);
+        } else {
+            _now += us;
+        }
+    }
+
+    static void reset(uint64_t us = 0) {
+        uint32_t speedup = _speedup;
+
+        _speedup = 0;
+        _now = us;
+        if (speedup) {
+            followRealTime(speedup);
+        }
+    }
+
+    // follow the monotonic clock `speedup` times faster from the current
+    // time on, 0 returns to virtual time
+    static void followRealTime(uint32_t speedup);
+
+    static bool isRealTime() {
+        return _speedup != 0;
+    }
+
+    static uint32_t speedup() {
+        return _speedup;
+    }
+
+  private:
+    static uint64_t _realMicros();
+    static void _sleep(uint64_t us);
+
+    static uint64_t _now;
+    static uint64_t _originNs;
+    static uint32_t _speedup;
+};
+
+#endif /* VIRTUAL_CLOCK_H */
@@ -0,0 +1,73 @@
+/*
+ * Wire.h - Host TwoWire which routes transactions to simulated I2cDevice
+ * instances instead of a hardware bus. In virtual time each transaction
+ * advances the clock by its transfer time at the configured bus clock.
+ */
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// same as the AVR core, also limits SensirionI2CCommunication::receiveFrame
+#define BUFFER_LENGTH 32
+
+/*
+ * I2cDevice - Target on the simulated bus.
+ */
+class I2cDevice {
+  public:
+    // complete write transaction, returns the endTransmission() code:
+    // 0 success, 2 address NACK, 3 data NACK
+    virtual uint8_t onWrite(const uint8_t data[], size_t length) = 0;
+
+    // read transaction, returns the number of bytes provided, 0 is an
+    // address NACK
+    virtual size_t onRead(uint8_t data[], size_t length) = 0;
+};
+
+class TwoWire {
+  public:
+    void begin() {
+    }
+
+    void setClock(uint32_t frequency) {
+        _frequency = frequency;
+    }
+
+    // connect a device to the bus, nullptr disconnects it
+    void attach(uint8_t address, I2cDevice* device);
+
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t data[], size_t length);
+    uint8_t endTransmission(uint8_t sendStop = 1);
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity,
+                        uint8_t sendStop = 1);
+    int available();
+    int read();
+    int peek();
+
+    uint32_t transactions() const {
+        return _transactions;
+    }
+
+  private:
+    void _transfer(size_t bytes);
+
+    I2cDevice* _devices[128] = {};
+    uint32_t _frequency = 100000;
+    uint8_t _address = 0;
+    uint8_t _txBuffer[BUFFER_LENGTH];
+    uint8_t _txLength = 0;
+    bool _txOverflow = false;
+    uint8_t _rxBuffer[BUFFER_LENGTH];
+    uint8_t _rxLength = 0;
+    uint8_t _rxIndex = 0;
+    uint32_t _transactions = 0;
+};
+
+extern TwoWire Wire;
+
+#endif /* WIRE_H */
@@ -0,0 +1,125 @@
+/*
+ * adaptive_timing_bench - Bus time of the SensirionI2CScd4x command mix with
+ * the fixed datasheet waits and with adaptive timing, on the simulated
+ * sensor and virtual clock. Each round reads the serial number and the
+ * settings, changes them, persists, takes a forced recalibration and then
+ * polls data ready and reads measurements for a minute, like the sketches
+ * do. The simulated commands finish after 50 to 90 % of their datasheet
+ * time, so the gain depends on that model; the first round with adaptive
+ * timing still learns from the worst case.
+ *
+ * Usage: adaptive_timing_bench [rounds] [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Arduino.h"
+#include "IndoorTrace.h"
+#include "SensirionI2CScd4x.h"
+#include "SimScd4x.h"
+#include "TraceSource.h"
+#include "Wire.h"
+
+struct Phase {
+    const char* name;
+    uint64_t busUs;  // virtual time spent inside driver calls
+    uint32_t calls;
+    uint32_t errors;
+};
+
+enum { Configuration, Recalibration, Measurement, Phases };
+
+// runs `call` and books its virtual time to `phase`
+template <typename F> static void timed(Phase& phase, F call) {
+    uint64_t start = VirtualClock::micros();
+    if (call()) {
+        phase.errors++;
+    }
+    phase.busUs += VirtualClock::micros() - start;
+    phase.calls++;
+}
+
+static void run(bool adaptive, uint32_t rounds, uint32_t seed,
+                Phase phases[Phases]) {
+    IndoorTraceSource source(ScenarioOffice, seed, 0xFFFFFFFF);
+    SimScd4x sensor(source, seed);
+    SensirionI2CScd4x scd4x;
+
+    VirtualClock::reset();
+    Wire.attach(SIM_SCD4X_ADDRESS, &sensor);
+    Wire.begin();
+    scd4x.begin(Wire);
+    scd4x.setAdaptiveTiming(adaptive);
+
+    for (uint32_t round = 0; round < rounds; round++) {
+        Phase& config = phases[Configuration];
+        uint16_t word0, word1, word2;
+        float offset;
+
+        timed(config,
+              [&] { return scd4x.getSerialNumber(word0, word1, word2); });
+        timed(config, [&] { return scd4x.getTemperatureOffset(offset); });
+        timed(config, [&] { return scd4x.getSensorAltitude(word0); });
+        timed(config, [&] { return scd4x.getAutomaticSelfCalibration(word0); });
+        timed(config, [&] {
+            return scd4x.setTemperatureOffset(4.0f + (round & 1));
+        });
+        timed(config, [&] {
+            return scd4x.setSensorAltitude(static_cast<uint16_t>(round % 500));
+        });
+        timed(config, [&] { return scd4x.setAutomaticSelfCalibration(1); });
+        timed(config, [&] { return scd4x.persistSettings(); });
+        timed(config, [&] { return scd4x.reinit(); });
+        timed(phases[Recalibration], [&] {
+            return scd4x.performForcedRecalibration(420, word0);
+        });
+
+        Phase& measure = phases[Measurement];
+        timed(measure, [&] { return scd4x.startPeriodicMeasurement(); });
+        for (uint8_t i = 0; i < 12; i++) {
+            uint16_t dataReady = 0;
+            delay(5000);
+            timed(measure,
+                  [&] { return scd4x.getDataReadyStatus(dataReady); });
+            if (dataReady & 0x07FF) {
+                timed(measure, [&] {
+                    return scd4x.readMeasurementTicks(word0, word1, word2);
+                });
+            }
+            timed(measure, [&] { return scd4x.setAmbientPressure(1013); });
+        }
+        timed(measure, [&] { return scd4x.stopPeriodicMeasurement(); });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t rounds = (argc > 1) ? atoi(argv[1]) : 100;
+    uint32_t seed = (argc > 2) ? atoi(argv[2]) : 1;
+    Phase fixed[Phases] = {{"configuration", 0, 0, 0},
+                           {"recalibration", 0, 0, 0},
+                           {"measurement", 0, 0, 0}};
+    Phase adaptive[Phases] = {fixed[0], fixed[1], fixed[2]};
+    uint64_t fixedTotal = 0, adaptiveTotal = 0;
+    uint32_t errors = 0;
+
+    run(false, rounds, seed, fixed);
+    run(true, rounds, seed, adaptive);
+
+    printf("%-14s %6s %12s %12s %8s %8s %6s\n", "phase", "calls",
+           "fixed[us]", "adaptive[us]", "speedup", "cmd/s", "errors");
+    for (int i = 0; i < Phases; i++) {
+        double fixedUs = static_cast<double>(fixed[i].busUs) / fixed[i].calls;
+        double adaptiveUs =
+            static_cast<double>(adaptive[i].busUs) / adaptive[i].calls;
+        printf("%-14s %6u %12.0f %12.0f %7.2fx %8.1f %6u\n", fixed[i].name,
+               adaptive[i].calls, fixedUs, adaptiveUs, fixedUs / adaptiveUs,
+               1e6 / adaptiveUs, fixed[i].errors + adaptive[i].errors);
+        fixedTotal += fixed[i].busUs;
+        adaptiveTotal += adaptive[i].busUs;
+        errors += fixed[i].errors + adaptive[i].errors;
+    }
+    printf("total bus time %.1f s fixed, %.1f s adaptive, %.2fx\n",
+           fixedTotal / 1e6, adaptiveTotal / 1e6,
+           static_cast<double>(fixedTotal) / adaptiveTotal);
+    return errors ? 1 : 0;
+}
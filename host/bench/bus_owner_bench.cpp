@@ -0,0 +1,118 @@
+/*
+ * bus_owner_bench - Several threads share one simulated SCD4x through
+ * Scd4xBusOwner: reader threads wait for samples like REST handlers or a
+ * logger would, configuration threads fire groups of settings, serial
+ * number and calibration requests without waiting for each. Reported are
+ * the wall time, how many stop / start windows the idle-mode requests
+ * needed and how many bus reads answered the sample requests. The
+ * simulated sensor checks the CRC of every frame, so interleaved
+ * transactions would show up as errors.
+ *
+ * Usage: bus_owner_bench [readers] [samples per reader] [config threads]
+ *                        [rounds per config thread]
+ */
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#include "Arduino.h"
+#include "Scd4xBusOwner.h"
+#include "SimScd4x.h"
+#include "TraceSource.h"
+#include "Wire.h"
+
+int main(int argc, char* argv[]) {
+    unsigned readers = (argc > 1) ? atoi(argv[1]) : 8;
+    unsigned samples = (argc > 2) ? atoi(argv[2]) : 50;
+    unsigned configThreads = (argc > 3) ? atoi(argv[3]) : 4;
+    unsigned rounds = (argc > 4) ? atoi(argv[4]) : 20;
+
+    IndoorTraceSource trace(ScenarioOffice, 1, 0xFFFFFFFF);
+    SimScd4x sensor(trace, 1);
+    SensirionI2CScd4x scd4x;
+    VirtualClock::reset();
+    Wire.attach(SIM_SCD4X_ADDRESS, &sensor);
+    Wire.begin();
+    scd4x.begin(Wire);
+
+    Scd4xBusOwner owner(scd4x);
+    std::atomic<uint64_t> errors(0), requests(0);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    owner.start();
+    owner.startPeriodicMeasurement().get();
+
+    for (unsigned i = 0; i < readers; i++) {
+        threads.emplace_back([&] {
+            for (unsigned n = 0; n < samples; n++) {
+                Scd4xResult<Scd4xSample> sample = owner.readMeasurement().get();
+                errors += sample.error ? 1 : 0;
+                requests++;
+            }
+        });
+    }
+    for (unsigned i = 0; i < configThreads; i++) {
+        threads.emplace_back([&, i] {
+            for (unsigned n = 0; n < rounds; n++) {
+                // submitted together, answered within one window
+                auto offset = owner.setTemperatureOffset(4.0f + i);
+                auto altitude = owner.setSensorAltitude(100 * i + n);
+                auto asc = owner.getAutomaticSelfCalibration();
+                auto serial = owner.getSerialNumber();
+                auto pressure = owner.setAmbientPressure(1000 + n);
+                errors += offset.get().error ? 1 : 0;
+                errors += altitude.get().error ? 1 : 0;
+                errors += asc.get().error ? 1 : 0;
+                errors += serial.get().error ? 1 : 0;
+                errors += pressure.get().error ? 1 : 0;
+                requests += 5;
+                if (n % 10 == 9) {
+                    errors += owner.performForcedRecalibration(420)
+                                  .get()
+                                  .error
+                                  ? 1
+                                  : 0;
+                    requests++;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    owner.stopPeriodicMeasurement().get();
+    owner.stop();
+    // a request after stop() is answered at once instead of hanging
+    if (owner.setSensorAltitude(0).get().error != SCD4X_BUS_OWNER_STOPPED) {
+        errors++;
+    }
+    double wall = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+    const Scd4xBusOwnerStats& stats = owner.stats();
+    printf("threads        %u readers, %u configuration\n", readers,
+           configThreads);
+    printf("requests       %llu in %llu batches, %.3f s wall, %.1f s "
+           "simulated\n",
+           static_cast<unsigned long long>(stats.requests),
+           static_cast<unsigned long long>(stats.batches), wall,
+           VirtualClock::micros() / 1e6);
+    printf("idle mode      %llu requests in %llu stop/start windows "
+           "(%.1f per window)\n",
+           static_cast<unsigned long long>(stats.idleRequests),
+           static_cast<unsigned long long>(stats.idleWindows),
+           stats.idleWindows
+               ? static_cast<double>(stats.idleRequests) / stats.idleWindows
+               : 0.0);
+    printf("samples        %llu requests answered by %llu bus reads\n",
+           static_cast<unsigned long long>(stats.sampleWaiters),
+           static_cast<unsigned long long>(stats.sampleReads));
+    printf("errors         %llu, sensor saw %u commands\n",
+           static_cast<unsigned long long>(errors.load()), sensor.commands());
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * bus_scan_bench - Scd4xBusScanner against the classic Arduino scanner on
+ * the virtual bus with a simulated SCD4x at 0x62 and a display controller
+ * at 0x3C. Reports bus time and transactions of a full classic scan at
+ * 100 kHz, of the fingerprinting scan at 400 kHz with and without an early
+ * stop, the identification of a measuring SCD4x, and how long the watch
+ * of update() takes to notice the display being unplugged and plugged in
+ * again.
+ *
+ * Usage: bus_scan_bench [watch interval ms] [addresses per update]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Arduino.h"
+#include "Scd4xBusScanner.h"
+#include "SensirionI2CScd4x.h"
+#include "SimScd4x.h"
+#include "TraceSource.h"
+#include "Wire.h"
+
+#define DISPLAY_ADDRESS 0x3C
+
+// SSD1306 which acknowledges every write and answers reads with its status
+class SimDisplay : public I2cDevice {
+  public:
+    uint8_t onWrite(const uint8_t[], size_t) override {
+        return 0;
+    }
+    size_t onRead(uint8_t data[], size_t length) override {
+        for (size_t i = 0; i < length; i++) {
+            data[i] = on ? 0x06 : 0x46;
+        }
+        return length;
+    }
+
+    bool on = true;
+};
+
+static const char* typeName(Scd4xBusDeviceType type) {
+    switch (type) {
+        case BusDeviceScd4x:
+            return "SCD4x";
+        case BusDeviceSsd1306:
+            return "SSD1306";
+        case BusDeviceSh1106:
+            return "SH1106";
+        default:
+            return "unknown";
+    }
+}
+
+static void printTable(const Scd4xBusScanner& scanner) {
+    for (uint8_t i = 0; i < scanner.count(); i++) {
+        const Scd4xBusDevice& device = scanner.device(i);
+        printf("    0x%02X %-8s", device.address, typeName(device.type));
+        if (device.type == BusDeviceScd4x &&
+            !(device.flags & BusDeviceMeasuring)) {
+            printf(" serial %04X%04X%04X", device.serial[0], device.serial[1],
+                   device.serial[2]);
+        }
+        if (device.flags & BusDeviceMeasuring) {
+            printf(" measuring");
+        }
+        if (device.flags & BusDeviceDisplayOn) {
+            printf(" display on");
+        }
+        printf("\n");
+    }
+}
+
+static uint32_t lastEventMs;
+static bool lastAttached;
+
+static void onBusEvent(const Scd4xBusDevice&, bool attached) {
+    lastEventMs = millis();
+    lastAttached = attached;
+}
+
+// classic Test_I2C_Scanner loop, returns the devices found
+static uint8_t classicScan() {
+    uint8_t found = 0;
+
+    for (uint8_t address = 1; address < 127; address++) {
+        Wire.beginTransmission(address);
+        if (Wire.endTransmission() == 0) {
+            found++;
+        }
+    }
+    return found;
+}
+
+static void report(const char* name, uint64_t startUs, uint32_t startTx,
+                   uint8_t found) {
+    printf("%-22s %7.2f ms  %4u transactions  %u devices\n", name,
+           (VirtualClock::micros() - startUs) / 1000.0,
+           Wire.transactions() - startTx, found);
+}
+
+// runs update() every 10 ms until an event of the expected kind
+static uint32_t watchUntil(Scd4xBusScanner& scanner, bool attached) {
+    uint32_t start = millis();
+
+    lastEventMs = 0;
+    while (!lastEventMs || lastAttached != attached) {
+        scanner.update(millis());
+        delay(10);
+        if (millis() - start > 600000) {
+            return 0xFFFFFFFF;
+        }
+    }
+    return lastEventMs - start;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t intervalMs = (argc > 1) ? atoi(argv[1]) : 1000;
+    uint8_t perUpdate = (argc > 2) ? atoi(argv[2]) : 8;
+    IndoorTraceSource source(ScenarioOffice, 1, 0xFFFFFFFF);
+    SimScd4x sensor(source, 1);
+    SimDisplay display;
+    SensirionI2CScd4x scd4x;
+    Scd4xBusDevice devices[8];
+    Scd4xBusScanner scanner(devices, 8);
+    uint64_t startUs;
+    uint32_t startTx;
+    uint8_t found;
+
+    VirtualClock::reset();
+    Wire.attach(SIM_SCD4X_ADDRESS, &sensor);
+    Wire.attach(DISPLAY_ADDRESS, &display);
+    Wire.begin();
+    scd4x.begin(Wire);
+    scanner.begin(Wire, 100000, onBusEvent);
+
+    startUs = VirtualClock::micros();
+    startTx = Wire.transactions();
+    found = classicScan();
+    report("classic 100 kHz", startUs, startTx, found);
+
+    startUs = VirtualClock::micros();
+    startTx = Wire.transactions();
+    found = scanner.scan();
+    report("fingerprint 400 kHz", startUs, startTx, found);
+    printTable(scanner);
+
+    startUs = VirtualClock::micros();
+    startTx = Wire.transactions();
+    found = scanner.scan(SCD4X_SCAN_FIRST, SCD4X_SCAN_LAST, 2);
+    report("stop after 2 devices", startUs, startTx, found);
+
+    scd4x.startPeriodicMeasurement();
+    display.on = false;
+    startUs = VirtualClock::micros();
+    startTx = Wire.transactions();
+    found = scanner.scan();
+    report("measuring, display off", startUs, startTx, found);
+    printTable(scanner);
+
+    scanner.setWatchInterval(intervalMs, perUpdate);
+    delay(intervalMs);
+    Wire.attach(DISPLAY_ADDRESS, nullptr);
+    uint32_t removedMs = watchUntil(scanner, false);
+    Wire.attach(DISPLAY_ADDRESS, &display);
+    uint32_t addedMs = watchUntil(scanner, true);
+    printf("watch every %u ms, %u addresses per update: unplug seen after "
+           "%u ms, plug-in after %u ms\n",
+           intervalMs, perUpdate, removedMs, addedMs);
+
+    return (removedMs == 0xFFFFFFFF || addedMs == 0xFFFFFFFF) ? 1 : 0;
+}
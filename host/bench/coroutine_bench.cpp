@@ -0,0 +1,157 @@
+/*
+ * coroutine_bench - One thread driving many simulated SCD4x sensors, each
+ * on its own bus, through Scd4xAsync coroutines on one Scd4xExecutor. Every
+ * sensor reads its serial number, sets the temperature offset, measures
+ * for a while, stops and takes a forced recalibration. The same workload
+ * then runs sensor after sensor with the blocking driver calls for
+ * comparison. Reported are the simulated time, the wall time, executor
+ * resumptions and errors.
+ *
+ * Usage: coroutine_bench [sensors] [samples per sensor] [seed]
+ */
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "Arduino.h"
+#include "Scd4xCoroutine.h"
+#include "SimScd4x.h"
+#include "TraceSource.h"
+#include "Wire.h"
+
+struct Node {
+    Node(uint32_t seed)
+        : source(ScenarioOffice, seed, 0xFFFFFFFF), sensor(source, seed) {
+        bus.attach(SIM_SCD4X_ADDRESS, &sensor);
+        bus.begin();
+        scd4x.begin(bus);
+    }
+
+    IndoorTraceSource source;
+    SimScd4x sensor;
+    TwoWire bus;
+    SensirionI2CScd4x scd4x;
+};
+
+struct Totals {
+    uint32_t samples;
+    uint32_t errors;
+    uint64_t co2Sum;
+};
+
+static void count(Totals& totals, uint16_t error) {
+    if (error) {
+        totals.errors++;
+    }
+}
+
+static Scd4xTask<void> sensorTask(Scd4xAsync& sensor, uint32_t samples,
+                                  Totals& totals) {
+    Scd4xResult<uint64_t> serial = co_await sensor.getSerialNumberAsync();
+    count(totals, serial.error);
+    count(totals, co_await sensor.setTemperatureOffsetAsync(4.0f));
+    count(totals, co_await sensor.startPeriodicMeasurementAsync());
+    for (uint32_t i = 0; i < samples; i++) {
+        Scd4xResult<Scd4xSample> sample =
+            co_await sensor.readMeasurementAsync();
+        count(totals, sample.error);
+        if (!sample.error) {
+            totals.samples++;
+            totals.co2Sum += sample.value.co2;
+        }
+    }
+    count(totals, co_await sensor.stopPeriodicMeasurementAsync());
+    Scd4xResult<uint16_t> frc =
+        co_await sensor.performForcedRecalibrationAsync(420);
+    count(totals, frc.error);
+}
+
+static void blockingSensor(SensirionI2CScd4x& scd4x, uint32_t samples,
+                           Totals& totals) {
+    uint16_t words[3];
+    uint16_t correction;
+
+    count(totals, scd4x.getSerialNumber(words[0], words[1], words[2]));
+    count(totals, scd4x.setTemperatureOffset(4.0f));
+    count(totals, scd4x.startPeriodicMeasurement());
+    for (uint32_t i = 0; i < samples; i++) {
+        uint16_t dataReady = 0;
+        uint16_t error;
+
+        while (!(error = scd4x.getDataReadyStatus(dataReady)) &&
+               !(dataReady & 0x07FF)) {
+            delay(100);
+        }
+        if (!error) {
+            error = scd4x.readMeasurementTicks(words[0], words[1], words[2]);
+        }
+        count(totals, error);
+        if (!error) {
+            totals.samples++;
+            totals.co2Sum += words[0];
+        }
+    }
+    count(totals, scd4x.stopPeriodicMeasurement());
+    count(totals, scd4x.performForcedRecalibration(420, correction));
+}
+
+static void report(const char* name, uint32_t sensors, const Totals& totals,
+                   uint64_t simulatedUs, double wall) {
+    printf("%-10s %3u sensors  %6u samples  %8.1f s simulated  "
+           "%7.3f s wall  %u errors\n",
+           name, sensors, totals.samples, simulatedUs / 1e6, wall,
+           totals.errors);
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t sensors = (argc > 1) ? atoi(argv[1]) : 32;
+    uint32_t samples = (argc > 2) ? atoi(argv[2]) : 24;
+    uint32_t seed = (argc > 3) ? atoi(argv[3]) : 1;
+    std::vector<std::unique_ptr<Node>> nodes;
+
+    Totals async = {};
+    VirtualClock::reset();
+    for (uint32_t i = 0; i < sensors; i++) {
+        nodes.emplace_back(new Node(seed + i));
+    }
+    {
+        Scd4xExecutor executor;
+        std::vector<std::unique_ptr<Scd4xAsync>> handles;
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::unique_ptr<Node>& node : nodes) {
+            handles.emplace_back(new Scd4xAsync(node->scd4x, executor));
+            executor.spawn(sensorTask(*handles.back(), samples, async));
+        }
+        executor.run();
+        double wall = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+        report("coroutine", sensors, async, VirtualClock::micros(), wall);
+        printf("           %llu resumptions, %zu tasks left\n",
+               static_cast<unsigned long long>(executor.resumptions()),
+               executor.tasks());
+    }
+
+    Totals blocking = {};
+    nodes.clear();
+    VirtualClock::reset();
+    for (uint32_t i = 0; i < sensors; i++) {
+        nodes.emplace_back(new Node(seed + i));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (std::unique_ptr<Node>& node : nodes) {
+        blockingSensor(node->scd4x, samples, blocking);
+    }
+    double wall = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+    report("blocking", sensors, blocking, VirtualClock::micros(), wall);
+
+    return (async.errors || blocking.errors ||
+            async.samples != sensors * samples)
+               ? 1
+               : 0;
+}
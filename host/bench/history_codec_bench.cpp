@@ -0,0 +1,154 @@
+/*
+ * history_codec_bench - Compression ratio and encode/decode cost of
+ * Scd4xHistoryEncoder on synthetic indoor traces.
+ *
+ * Usage: history_codec_bench [days] [seed]
+ */
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "IndoorTrace.h"
+#include "Scd4xHistoryCodec.h"
+
+struct Result {
+    size_t records;
+    size_t blocks;
+    size_t bytes;
+    double encodeNs;
+    double decodeNs;
+};
+
+static std::vector<Scd4xHistoryRecord> makeTrace(IndoorScenario scenario,
+                                                 uint32_t interval,
+                                                 uint32_t days, uint32_t seed) {
+    std::vector<Scd4xHistoryRecord> trace;
+    IndoorTrace generator(scenario, seed);
+    uint32_t count = days * 86400 / interval;
+
+    trace.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        Scd4xHistoryRecord record;
+        record.timestamp = 1600000000 + i * interval;
+        generator.step(interval, record.co2, record.temperatureTicks,
+                       record.humidityTicks);
+        trace.push_back(record);
+    }
+    return trace;
+}
+
+static Result run(const std::vector<Scd4xHistoryRecord>& trace,
+                  size_t blockSize) {
+    std::vector<uint8_t> storage;
+    std::vector<uint8_t> block(blockSize);
+    Scd4xHistoryEncoder encoder(block.data(), blockSize);
+    Result result = {trace.size(), 0, 0, 0, 0};
+
+    auto start = std::chrono::steady_clock::now();
+    for (const Scd4xHistoryRecord& record : trace) {
+        if (!encoder.append(record)) {
+            storage.insert(storage.end(), block.begin(), block.end());
+            result.bytes += encoder.size();
+            encoder.reset();
+            encoder.append(record);
+        }
+    }
+    storage.insert(storage.end(), block.begin(), block.end());
+    result.bytes += encoder.size();
+    auto end = std::chrono::steady_clock::now();
+    result.encodeNs =
+        std::chrono::duration<double, std::nano>(end - start).count() /
+        trace.size();
+    result.blocks = storage.size() / blockSize;
+
+    size_t index = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < result.blocks; b++) {
+        Scd4xHistoryDecoder decoder(&storage[b * blockSize], blockSize);
+        Scd4xHistoryRecord record;
+        while (decoder.next(record)) {
+            const Scd4xHistoryRecord& expected = trace[index++];
+            if (record.timestamp != expected.timestamp ||
+                record.co2 != expected.co2 ||
+                record.temperatureTicks != expected.temperatureTicks ||
+                record.humidityTicks != expected.humidityTicks) {
+                fprintf(stderr, "mismatch at record %zu\n", index - 1);
+                exit(1);
+            }
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    result.decodeNs =
+        std::chrono::duration<double, std::nano>(end - start).count() /
+        trace.size();
+    if (index != trace.size()) {
+        fprintf(stderr, "decoded %zu of %zu records\n", index, trace.size());
+        exit(1);
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t days = (argc > 1) ? atoi(argv[1]) : 7;
+    uint32_t seed = (argc > 2) ? atoi(argv[2]) : 1;
+    const char* names[] = {"office", "bedroom", "classroom"};
+    const uint32_t intervals[] = {5, 30};
+    const size_t blockSizes[] = {64, 128, 256};
+
+    // a block without room for the header and a record is never written
+    uint8_t tiny[SCD4X_HISTORY_HEADER_SIZE] = {};
+    Scd4xHistoryEncoder rejected(tiny, sizeof(tiny));
+    if (rejected.isValid() || rejected.append(Scd4xHistoryRecord()) ||
+        tiny[0]) {
+        fprintf(stderr, "%zu byte block not rejected\n", sizeof(tiny));
+        return 1;
+    }
+
+    // timestamp jumps beyond 2^31 round-trip, truncated blocks decode nothing
+    uint8_t block[64];
+    Scd4xHistoryEncoder encoder(block, sizeof(block));
+    Scd4xHistoryRecord jumps[3] = {{5, 400, 1, 2}, {0xF0000000u, 401, 1, 2},
+                                   {3, 402, 1, 2}};
+    for (const Scd4xHistoryRecord& record : jumps) {
+        encoder.append(record);
+    }
+    Scd4xHistoryDecoder decoder(block, sizeof(block));
+    Scd4xHistoryDecoder truncated(block, SCD4X_HISTORY_HEADER_SIZE - 1);
+    Scd4xHistoryRecord record;
+    for (const Scd4xHistoryRecord& expected : jumps) {
+        if (!decoder.next(record) || record.timestamp != expected.timestamp ||
+            record.co2 != expected.co2) {
+            fprintf(stderr, "timestamp jump not decoded\n");
+            return 1;
+        }
+    }
+    if (truncated.next(record)) {
+        fprintf(stderr, "truncated block decoded\n");
+        return 1;
+    }
+
+    printf("%-10s %4s %5s %8s %9s %9s %7s %8s %7s %7s\n", "scenario", "intv",
+           "block", "records", "raw10[B]", "stored[B]", "B/rec", "ratio",
+           "enc[ns]", "dec[ns]");
+    for (int s = 0; s < 3; s++) {
+        for (uint32_t interval : intervals) {
+            std::vector<Scd4xHistoryRecord> trace = makeTrace(
+                static_cast<IndoorScenario>(s), interval, days, seed);
+            for (size_t blockSize : blockSizes) {
+                Result r = run(trace, blockSize);
+                // raw: 4 byte timestamp + 3 x 2 byte ticks per record;
+                // stored: whole blocks as they occupy flash
+                size_t raw = r.records * 10;
+                size_t stored = r.blocks * blockSize;
+                printf("%-10s %3us %5zu %8zu %9zu %9zu %7.2f %7.2fx %7.1f "
+                       "%7.1f\n",
+                       names[s], interval, blockSize, r.records, raw, stored,
+                       static_cast<double>(r.bytes) / r.records,
+                       static_cast<double>(raw) / stored, r.encodeNs,
+                       r.decodeNs);
+            }
+        }
+    }
+    return 0;
+}
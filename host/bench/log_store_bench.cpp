@@ -0,0 +1,197 @@
+/*
+ * log_store_bench - Throughput, write amplification and wear spread of
+ * Scd4xLogStore on a file-backed flash simulation, plus a power-fail test
+ * which cuts writes at random points and checks the log after remounting.
+ *
+ * Usage: log_store_bench [records] [seed]
+ */
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "FileFlash.h"
+#include "IndoorTrace.h"
+#include "Scd4xLogStore.h"
+
+// sequence number, then the sample as the sketches keep it
+static const uint8_t RECORD_SIZE = 10;
+
+static void makeRecord(uint32_t index, IndoorTrace& trace,
+                       uint8_t record[RECORD_SIZE]) {
+    uint16_t co2, temperatureTicks, humidityTicks;
+
+    trace.step(5, co2, temperatureTicks, humidityTicks);
+    memcpy(record, &index, 4);
+    memcpy(record + 4, &co2, 2);
+    memcpy(record + 6, &temperatureTicks, 2);
+    memcpy(record + 8, &humidityTicks, 2);
+}
+
+static uint32_t recordIndex(const uint8_t record[]) {
+    uint32_t index;
+    memcpy(&index, record, 4);
+    return index;
+}
+
+// reads the whole log, returns the number of records or -1 if the sequence
+// numbers are not consecutive or do not end at `last`
+static long readBack(Scd4xLogStore& store, uint32_t last) {
+    uint8_t record[SCD4X_LOG_MAX_PAYLOAD];
+    uint8_t length;
+    long count = 0;
+    uint32_t previous = 0;
+
+    store.rewind();
+    while (store.readNext(record, sizeof(record), length)) {
+        uint32_t index = recordIndex(record);
+        if (length != RECORD_SIZE || (count && index != previous + 1)) {
+            return -1;
+        }
+        previous = index;
+        count++;
+    }
+    return (count && previous != last) ? -1 : count;
+}
+
+static bool throughput(const char* path, const char* name, uint32_t size,
+                       uint16_t segmentSize, uint32_t records, uint32_t seed) {
+    unlink(path);
+    FileFlash flash(path, size, segmentSize);
+    Scd4xLogStore store(flash);
+    IndoorTrace trace(ScenarioOffice, seed);
+    uint8_t record[RECORD_SIZE];
+
+    if (!flash.isOpen() || !store.mount()) {
+        fprintf(stderr, "%s: mount failed\n", name);
+        return false;
+    }
+    uint64_t formatBytes = flash.programmedBytes();
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < records; i++) {
+        makeRecord(i, trace, record);
+        if (!store.append(record, RECORD_SIZE)) {
+            fprintf(stderr, "%s: append %u failed\n", name, i);
+            return false;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double appendUs =
+        std::chrono::duration<double, std::micro>(end - start).count() /
+        records;
+
+    start = std::chrono::steady_clock::now();
+    long stored = readBack(store, records - 1);
+    end = std::chrono::steady_clock::now();
+    if (stored <= 0) {
+        fprintf(stderr, "%s: read-back failed\n", name);
+        return false;
+    }
+    double readUs =
+        std::chrono::duration<double, std::micro>(end - start).count() /
+        stored;
+
+    // records too large for the buffer are skipped, not taken as the end
+    uint8_t small[RECORD_SIZE - 1];
+    uint8_t length;
+    store.rewind();
+    if (store.readNext(small, sizeof(small), length) ||
+        store.skippedRecords() != static_cast<uint32_t>(stored)) {
+        fprintf(stderr, "%s: oversized records not skipped\n", name);
+        return false;
+    }
+
+    uint32_t minErase = flash.erases()[0], maxErase = flash.erases()[0];
+    for (uint32_t erases : flash.erases()) {
+        minErase = erases < minErase ? erases : minErase;
+        maxErase = erases > maxErase ? erases : maxErase;
+    }
+    // programmed bytes per payload byte; each erase also costs a full
+    // segment of wear, reported separately as erased bytes per payload byte
+    double payload = static_cast<double>(records) * RECORD_SIZE;
+    double programmed = (flash.programmedBytes() - formatBytes) / payload;
+    double erased =
+        static_cast<double>(store.erasedSegments()) * segmentSize / payload;
+
+    printf("%-14s %6u %5u %8u %8ld %6.3f %6.3f %5u %5u %8.2f %8.2f %3s\n",
+           name, size, segmentSize, records, stored, programmed, erased,
+           minErase, maxErase, appendUs, readUs,
+           flash.violations() ? "NOK" : "ok");
+    return flash.violations() == 0;
+}
+
+static bool powerFail(const char* path, uint32_t trials, uint32_t seed) {
+    unlink(path);
+    FileFlash flash(path, 1024, 128);
+    IndoorTrace trace(ScenarioBedroom, seed);
+    uint8_t record[RECORD_SIZE];
+    uint32_t state = seed * 2654435761u + 1;
+    uint32_t next = 0;
+    uint32_t torn = 0;
+
+    {
+        Scd4xLogStore store(flash);
+        if (!store.mount()) {
+            return false;
+        }
+    }
+    for (uint32_t trial = 0; trial < trials; trial++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        // cut power within the next record or segment header
+        flash.powerFailAfter(state % (RECORD_SIZE + 12));
+        Scd4xLogStore store(flash);
+        if (!store.mount()) {
+            fprintf(stderr, "power fail: mount failed in trial %u\n", trial);
+            return false;
+        }
+        makeRecord(next, trace, record);
+        bool appended = store.append(record, RECORD_SIZE);
+        flash.powerOn();
+
+        // after the restart the record is either complete or absent, and
+        // everything appended before is still there
+        Scd4xLogStore restarted(flash);
+        if (!restarted.mount()) {
+            fprintf(stderr, "power fail: remount failed in trial %u\n", trial);
+            return false;
+        }
+        long ok = readBack(restarted, appended ? next : next - 1);
+        if (ok < 0) {
+            fprintf(stderr, "power fail: log broken in trial %u\n", trial);
+            return false;
+        }
+        if (appended) {
+            next++;
+        } else {
+            torn++;
+        }
+    }
+    printf("power fail: %u trials, %u appends completed, %u torn, %s\n",
+           trials, next, torn, flash.violations() ? "NOK" : "ok");
+    return flash.violations() == 0;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t records = (argc > 1) ? atoi(argv[1]) : 200000;
+    uint32_t seed = (argc > 2) ? atoi(argv[2]) : 1;
+    char path[64];
+    bool ok = true;
+
+    snprintf(path, sizeof(path), "/tmp/log_store_bench.%d", getpid());
+    printf("%-14s %6s %5s %8s %8s %6s %6s %5s %5s %8s %8s %3s\n", "storage",
+           "size", "seg", "appended", "stored", "prog", "erased", "min", "max",
+           "app[us]", "read[us]", "ok");
+    ok &= throughput(path, "eeprom 1k", 1024, 64, records, seed);
+    ok &= throughput(path, "eeprom 1k", 1024, 128, records, seed);
+    ok &= throughput(path, "eeprom 4k", 4096, 256, records, seed);
+    ok &= throughput(path, "flash 64k", 65536, 4096, records, seed);
+    ok &= powerFail(path, 5000, seed);
+    unlink(path);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+/*
+ * pressure_feed_bench - Scd4xPressureFeed on the simulated sensor and virtual
+ * clock. A synthetic barometer is read once a second: 1013 hPa with a slow
+ * weather cycle, a front dropping 8 hPa within two hours and a few Pa of
+ * noise. The loop polls data ready every 50 ms like the sketches, reads the
+ * samples and lets the feed forward the pressure in the idle bus time.
+ * Reports the writes against one per sample and how far the pressure the
+ * sensor compensates with lags behind the barometer.
+ *
+ * Usage: pressure_feed_bench [hours] [seed]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Arduino.h"
+#include "Scd4xPressureFeed.h"
+#include "SensirionI2CScd4x.h"
+#include "SimScd4x.h"
+#include "TraceSource.h"
+#include "Wire.h"
+
+// barometer in Pa at `seconds`, `state` drives the noise
+static uint32_t barometer(double seconds, uint32_t& state) {
+    const double front = 20 * 3600.0;
+    const double cycle = 3 * 86400.0;
+    double pressure = 101300.0 + 600.0 * sin(seconds / cycle * 2 * M_PI);
+
+    if (seconds > front) {
+        pressure -= 800.0 * fmin((seconds - front) / 7200.0, 1.0);
+    }
+    state = state * 1664525u + 1013904223u;
+    pressure += static_cast<int32_t>(state >> 24) % 17 - 8;
+    return static_cast<uint32_t>(pressure);
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t hours = (argc > 1) ? atoi(argv[1]) : 48;
+    uint32_t seed = (argc > 2) ? atoi(argv[2]) : 1;
+    IndoorTraceSource source(ScenarioOffice, seed, 0xFFFFFFFF);
+    SimScd4x sensor(source, seed);
+    SensirionI2CScd4x scd4x;
+    Scd4xPressureFeed feed;
+    uint32_t state = seed;
+    uint32_t samples = 0, errors = 0, nextReading = 0;
+    uint64_t writeUs = 0;
+    double errorSum = 0, errorMax = 0;
+
+    VirtualClock::reset();
+    Wire.attach(SIM_SCD4X_ADDRESS, &sensor);
+    Wire.begin();
+    scd4x.begin(Wire);
+    feed.begin(scd4x);
+    if (scd4x.startPeriodicMeasurement()) {
+        fprintf(stderr, "start failed\n");
+        return 1;
+    }
+
+    uint32_t end = hours * 3600000UL;
+    uint32_t pressurePa = 0;
+    while (millis() < end) {
+        uint32_t now = millis();
+        uint16_t dataReady = 0;
+
+        if (static_cast<int32_t>(now - nextReading) >= 0) {
+            pressurePa = barometer(now / 1000.0, state);
+            feed.addReading(pressurePa);
+            nextReading += 1000;
+        }
+        if (scd4x.getDataReadyStatus(dataReady)) {
+            errors++;
+        } else if (dataReady & 0x07FF) {
+            uint16_t co2, temperatureTicks, humidityTicks;
+            if (scd4x.readMeasurementTicks(co2, temperatureTicks,
+                                           humidityTicks)) {
+                errors++;
+            } else {
+                feed.measurementRead(millis(), 5000);
+                samples++;
+                if (sensor.ambientPressure()) {
+                    double lag =
+                        fabs(sensor.ambientPressure() - pressurePa / 100.0);
+                    errorSum += lag;
+                    errorMax = lag > errorMax ? lag : errorMax;
+                }
+            }
+        }
+
+        uint16_t writes = feed.writeCount();
+        uint64_t start = VirtualClock::micros();
+        if (feed.update(millis())) {
+            errors++;
+        }
+        if (feed.writeCount() != writes) {
+            writeUs += VirtualClock::micros() - start;
+        }
+        delay(50);
+    }
+    scd4x.stopPeriodicMeasurement();
+
+    printf("simulated      %u h, %u samples, %u driver errors\n", hours,
+           samples, errors);
+    printf("writes         %u (%.1f per hour), %u with one per sample\n",
+           feed.writeCount(), feed.writeCount() / static_cast<double>(hours),
+           samples);
+    printf("bus time       %.1f ms in pressure writes\n", writeUs / 1000.0);
+    printf("lag            %.2f hPa mean, %.2f hPa max behind the barometer\n",
+           samples ? errorSum / samples : 0.0, errorMax);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * seqlock_bench - Contention of Scd4xLatestSample with 1 to 64 reader
+ * threads against one writer publishing as fast as it can, compared with
+ * the same snapshot behind a std::mutex. Every copy a reader gets is
+ * checked for torn values. Reported are the writer's publications and the
+ * readers' consistent reads per second, and the share of seqlock reads
+ * which had to be retried.
+ *
+ * The results depend on the number of cores: with fewer cores than threads
+ * the threads take turns and the mutex numbers mostly show scheduling.
+ *
+ * Usage: seqlock_bench [ms per run] [max readers]
+ */
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#include "Scd4xLatestSample.h"
+
+struct Result {
+    double writes;
+    double reads;
+    double retries;
+    uint64_t torn;
+};
+
+// the writer derives every field from the sample number, so a copy mixing
+// two publications is detected
+static void makeSample(uint32_t number, Scd4xSample& sample) {
+    sample.timestamp = number;
+    sample.co2 = static_cast<uint16_t>(number);
+    sample.temperatureTicks = static_cast<uint16_t>(number * 7);
+    sample.humidityTicks = static_cast<uint16_t>(number >> 16);
+    sample.temperature = static_cast<float>(number & 0xFFFF);
+    sample.humidity = static_cast<float>(number >> 16);
+    sample.flags = static_cast<uint8_t>(number);
+}
+
+static bool consistent(const Scd4xSnapshot& snapshot) {
+    Scd4xSample expected;
+
+    if (!snapshot.count) {
+        return true;
+    }
+    makeSample(snapshot.count, expected);
+    return snapshot.sample.timestamp == expected.timestamp &&
+           snapshot.sample.co2 == expected.co2 &&
+           snapshot.sample.temperatureTicks == expected.temperatureTicks &&
+           snapshot.sample.humidityTicks == expected.humidityTicks &&
+           snapshot.sample.temperature == expected.temperature &&
+           snapshot.sample.humidity == expected.humidity &&
+           snapshot.sample.flags == expected.flags;
+}
+
+static Result runSeqlock(unsigned readers, unsigned ms) {
+    Scd4xLatestSample latest;
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> reads(0), retries(0), torn(0);
+    uint32_t written = 0;
+    std::vector<std::thread> threads;
+
+    for (unsigned i = 0; i < readers; i++) {
+        threads.emplace_back([&] {
+            uint64_t ok = 0, failed = 0, bad = 0;
+            Scd4xSnapshot snapshot;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (latest.tryRead(snapshot)) {
+                    ok++;
+                    bad += consistent(snapshot) ? 0 : 1;
+                } else {
+                    failed++;
+                }
+            }
+            reads += ok;
+            retries += failed;
+            torn += bad;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::milliseconds(ms);
+    Scd4xSample sample;
+    while (std::chrono::steady_clock::now() < end) {
+        for (int i = 0; i < 64; i++) {
+            makeSample(++written, sample);
+            latest.onSample(sample);
+        }
+    }
+    stop = true;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    uint64_t attempts = reads + retries;
+    return {written / seconds, reads / seconds,
+            attempts ? 100.0 * retries / attempts : 0.0, torn};
+}
+
+static Result runMutex(unsigned readers, unsigned ms) {
+    std::mutex mutex;
+    Scd4xSnapshot shared = {};
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> reads(0), torn(0);
+    uint32_t written = 0;
+    std::vector<std::thread> threads;
+
+    for (unsigned i = 0; i < readers; i++) {
+        threads.emplace_back([&] {
+            uint64_t ok = 0, bad = 0;
+            Scd4xSnapshot snapshot;
+            while (!stop.load(std::memory_order_relaxed)) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    snapshot = shared;
+                }
+                ok++;
+                bad += consistent(snapshot) ? 0 : 1;
+            }
+            reads += ok;
+            torn += bad;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::milliseconds(ms);
+    while (std::chrono::steady_clock::now() < end) {
+        for (int i = 0; i < 64; i++) {
+            std::lock_guard<std::mutex> lock(mutex);
+            makeSample(++written, shared.sample);
+            shared.count = written;
+        }
+    }
+    stop = true;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    return {written / seconds, reads / seconds, 0.0, torn};
+}
+
+int main(int argc, char* argv[]) {
+    unsigned ms = (argc > 1) ? atoi(argv[1]) : 300;
+    unsigned maxReaders = (argc > 2) ? atoi(argv[2]) : 64;
+    uint64_t torn = 0;
+
+    printf("%u hardware threads, %u ms per run\n",
+           std::thread::hardware_concurrency(), ms);
+    printf("%7s | %12s %12s %7s %5s | %12s %12s %5s\n", "readers",
+           "seq writes/s", "reads/s", "retry%", "torn", "mtx writes/s",
+           "reads/s", "torn");
+    for (unsigned readers = 1; readers <= maxReaders; readers *= 2) {
+        Result seqlock = runSeqlock(readers, ms);
+        Result locked = runMutex(readers, ms);
+        printf("%7u | %12.3g %12.3g %7.2f %5llu | %12.3g %12.3g %5llu\n",
+               readers, seqlock.writes, seqlock.reads, seqlock.retries,
+               static_cast<unsigned long long>(seqlock.torn), locked.writes,
+               locked.reads, static_cast<unsigned long long>(locked.torn));
+        torn += seqlock.torn + locked.torn;
+    }
+    return torn ? 1 : 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * SketchMain - main() for sketches built for the host with ino2cpp.awk. It
+ * wires the host Arduino environment the way the boards are wired: a
+ * simulated SCD4x at 0x62 on Wire, Serial on stdout and a simulated SSD1306
+ * behind U8glib's software SPI, reset from pin 8. Then it calls setup() and
+ * loop() on the virtual clock until the requested device time has passed,
+ * so hours of firmware run in seconds.
+ *
+ * Usage: emu_<sketch> [-t hours] [-S scenario] [-s seed] [-i script]
+ *                     [-x speedup] [-l loopUs] [-r pin] [-f frame.pbm]
+ *                     [-a] [-q] [-T trace.json] [-n events] [-w seconds]
+ *
+ *   -t  device time to run in hours (default 1)
+ *   -S  office, bedroom or classroom trace for the sensor (default office)
+ *   -s  seed for trace and sensor timing (default 1)
+ *   -i  serial input script, lines of "<seconds> <text>": the text and a
+ *       newline arrive at that device time
+ *   -x  follow real time sped up by this factor and read serial input from
+ *       stdin, for interactive sessions
+ *   -l  time one loop() pass takes when it did not wait itself (default
+ *       1000 us)
+ *   -r  pin wired to the display reset (default 8)
+ *   -f  save the display as PBM image at the end
+ *   -a  print the display as text at the end
+ *   -q  discard the serial output
+ *   -T  record Scd4xTrace spans and write the last ones as Chrome trace
+ *       JSON at the end; a sketch which attaches its own ring replaces this
+ *   -n  spans kept for -T (default 16384, at most 65535)
+ *   -w  start warm, as after a watchdog reset: the sensor has been
+ *       measuring for that many seconds when setup() runs, the display
+ *       keeps the setup from the sketch's constructors and the
+ *       Scd4xWarmStart marker is set
+ */
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Arduino.h"
+#include "Scd4xMemory.h"
+#include "Scd4xTrace.h"
+#include "Scd4xWarmStart.h"
+#include "SensirionI2CScd4x.h"
+#include "SimScd4x.h"
+#include "SimSsd1306.h"
+#include "TraceSource.h"
+#include "Wire.h"
+
+void setup();
+void loop();
+
+static uint8_t displayResetPin = 8;
+
+static void onPinWrite(uint8_t pin, uint8_t value) {
+    // the controller resets on the falling edge of its reset line
+    if (pin == displayResetPin && value == LOW) {
+        SimSsd1306::instance().reset();
+    }
+}
+
+// Print to a file, for the trace
+class FilePrint : public Print {
+  public:
+    explicit FilePrint(FILE* file) : _file(file) {
+    }
+
+    size_t write(uint8_t data) override {
+        return fputc(data, _file) != EOF;
+    }
+
+    size_t write(const uint8_t buffer[], size_t size) override {
+        return fwrite(buffer, 1, size, _file);
+    }
+    using Print::write;
+
+  private:
+    FILE* _file;
+};
+
+// serial input script: injects every line whose time has come
+class InputScript {
+  public:
+    explicit InputScript(FILE* file) : _file(file) {
+        _next();
+    }
+
+    void update() {
+        while (_pending && VirtualClock::micros() >= _atUs) {
+            Serial.inject(_text, strlen(_text));
+            _next();
+        }
+    }
+
+  private:
+    void _next() {
+        char line[128];
+        double seconds;
+        int offset;
+
+        _pending = false;
+        while (_file && fgets(line, sizeof(line), _file)) {
+            if (sscanf(line, "%lf %n", &seconds, &offset) != 1) {
+                continue;
+            }
+            snprintf(_text, sizeof(_text), "%s", line + offset);
+            if (!strchr(_text, '\n')) {
+                strcat(_text, "\n");
+            }
+            _atUs = static_cast<uint64_t>(seconds * 1e6);
+            _pending = true;
+            return;
+        }
+    }
+
+    FILE* _file;
+    bool _pending;
+    uint64_t _atUs = 0;
+    char _text[130];
+};
+
+int main(int argc, char* argv[]) {
+    double hours = 1;
+    IndoorScenario scenario = ScenarioOffice;
+    uint32_t seed = 1;
+    const char* script = nullptr;
+    uint32_t speedup = 0;
+    uint32_t loopUs = 1000;
+    const char* frame = nullptr;
+    bool ascii = false;
+    bool quiet = false;
+    const char* trace = nullptr;
+    uint32_t traceEvents = 16384;
+    double warmSeconds = -1;
+    int option;
+
+    // paint before setup() so the sketch's probes work as on the boards
+    Scd4xMemory::paintStack();
+
+    while ((option = getopt(argc, argv, "t:S:s:i:x:l:r:f:aqT:n:w:")) != -1) {
+        switch (option) {
+            case 't':
+                hours = atof(optarg);
+                break;
+            case 'S':
+                scenario = !strcmp(optarg, "bedroom")     ? ScenarioBedroom
+                           : !strcmp(optarg, "classroom") ? ScenarioClassroom
+                                                          : ScenarioOffice;
+                break;
+            case 's':
+                seed = strtoul(optarg, nullptr, 0);
+                break;
+            case 'i':
+                script = optarg;
+                break;
+            case 'x':
+                speedup = strtoul(optarg, nullptr, 0);
+                break;
+            case 'l':
+                loopUs = strtoul(optarg, nullptr, 0);
+                break;
+            case 'r':
+                displayResetPin = strtoul(optarg, nullptr, 0);
+                break;
+            case 'f':
+                frame = optarg;
+                break;
+            case 'a':
+                ascii = true;
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            case 'T':
+                trace = optarg;
+                break;
+            case 'n':
+                traceEvents = std::min(strtoul(optarg, nullptr, 0), 65535UL);
+                break;
+            case 'w':
+                warmSeconds = atof(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-t hours] [-S scenario] "
+                                "[-s seed] [-i script] [-x speedup] "
+                                "[-l loopUs] [-r pin] [-f frame.pbm] "
+                                "[-a] [-q] [-T trace.json] [-n events] "
+                                "[-w seconds]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    FILE* scriptFile = script ? fopen(script, "r") : nullptr;
+    if (script && !scriptFile) {
+        perror(script);
+        return 1;
+    }
+    InputScript input(scriptFile);
+
+    FILE* traceFile = trace ? fopen(trace, "w") : nullptr;
+    if (trace && !traceFile) {
+        perror(trace);
+        return 1;
+    }
+    std::vector<Scd4xTraceEvent> traceRing(trace ? traceEvents : 0);
+    if (trace) {
+        Scd4xTrace::attach(traceRing.data(), traceRing.size());
+    }
+
+    // one trace value per 5 s, with room for restarted measurements
+    IndoorTraceSource source(scenario, seed,
+                             static_cast<uint32_t>(hours * 3600 / 5) + 1000);
+    SimScd4x sensor(source, seed);
+    SimSsd1306& display = SimSsd1306::instance();
+
+    VirtualClock::reset();
+    Wire.attach(SIM_SCD4X_ADDRESS, &sensor);
+    setPinWriteHandler(onPinWrite);
+    if (quiet) {
+        Serial.setOutput(nullptr);
+    }
+    if (speedup) {
+        VirtualClock::followRealTime(speedup);
+        Serial.setInput(STDIN_FILENO);
+    }
+
+    uint64_t endUs = static_cast<uint64_t>(hours * 3600e6);
+    uint64_t passes = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    if (warmSeconds >= 0) {
+        // what the firmware before the reset left behind
+        SensirionI2CScd4x before;
+
+        Wire.begin();
+        before.begin(Wire);
+        before.startPeriodicMeasurement();
+        VirtualClock::advance(static_cast<uint64_t>(warmSeconds * 1e6));
+        Scd4xWarmStart::mark();
+    }
+
+    setup();
+    while (VirtualClock::micros() < endUs) {
+        uint64_t before = VirtualClock::micros();
+
+        input.update();
+        loop();
+        passes++;
+        if (VirtualClock::micros() == before) {
+            VirtualClock::advance(loopUs);
+        }
+    }
+    fflush(stdout);
+
+    double wall = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+    double device = VirtualClock::micros() / 1e6;
+    fprintf(stderr,
+            "device time %.1f s, wall time %.3f s, speed-up %.0f\n"
+            "loop passes %llu, measurements %u, sensor commands %u, "
+            "I2C transactions %u\n"
+            "display     %u commands, %u data bytes, %u resets\n"
+            "serial      %llu bytes\n",
+            device, wall, wall > 0 ? device / wall : 0,
+            static_cast<unsigned long long>(passes), sensor.measurements(),
+            sensor.commands(), Wire.transactions(), display.commands(),
+            display.dataBytes(), display.resets(),
+            static_cast<unsigned long long>(Serial.bytesWritten()));
+
+    if (frame) {
+        FILE* file = fopen(frame, "w");
+        if (!file) {
+            perror(frame);
+            return 1;
+        }
+        display.writePbm(file);
+        fclose(file);
+    }
+    if (ascii) {
+        display.printText(stderr);
+    }
+    if (traceFile) {
+        FilePrint output(traceFile);
+        fprintf(stderr, "trace       %u spans, %u overwritten\n",
+                Scd4xTrace::count(), Scd4xTrace::overwritten());
+        Scd4xTrace::writeJson(output);
+        fclose(traceFile);
+    }
+    return 0;
+}
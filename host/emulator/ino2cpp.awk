@@ -0,0 +1,48 @@
+# ino2cpp.awk - Turns an Arduino sketch into a C++ translation unit the way
+# the Arduino builder does: includes Arduino.h and declares every top level
+# function before the first function definition, so functions can be used
+# above their definition. Line endings are normalised and #line directives
+# keep compiler messages pointing into the sketch.
+#
+# Usage: awk -f ino2cpp.awk Sketch.ino > Sketch.cpp
+
+BEGIN {
+    type = "^[A-Za-z_][A-Za-z0-9_:<>*& ]*[ *&]+"
+    name = "[A-Za-z_][A-Za-z0-9_]*"
+    definition = type name "\\(.*\\)[ \t]*\\{[ \t]*$"
+    keyword = "^(if|for|while|switch|else|do|return|class|struct|enum|" \
+              "union|namespace|typedef)[ (]"
+}
+
+# a function definition starts in column 0 and ends its line with the brace
+function isDefinition(line) {
+    if (line !~ definition || line ~ keyword)
+        return 0
+    # members defined outside their class are declared by the class
+    return line !~ /::[A-Za-z_~][A-Za-z0-9_]*\(/
+}
+
+{
+    sub(/\r$/, "")
+    lines[NR] = $0
+    if (!first && isDefinition($0))
+        first = NR
+}
+
+END {
+    print "#include <Arduino.h>"
+    printf "#line 1 \"%s\"\n", FILENAME
+    for (n = 1; n <= NR; n++) {
+        if (n == first) {
+            for (m = first; m <= NR; m++) {
+                if (isDefinition(lines[m])) {
+                    prototype = lines[m]
+                    sub(/[ \t]*\{[ \t]*$/, ";", prototype)
+                    print prototype
+                }
+            }
+            printf "#line %d \"%s\"\n", n, FILENAME
+        }
+        print lines[n]
+    }
+}
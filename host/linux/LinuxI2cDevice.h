@@ -0,0 +1,66 @@
+/*
+ * LinuxI2cDevice - I2cDevice forwarding the transactions of the host Wire
+ * bus to a real target through the Linux i2c-dev interface, so the driver
+ * runs unchanged on e.g. a Raspberry Pi. Use it with the VirtualClock
+ * following real time.
+ */
+#ifndef LINUX_I2C_DEVICE_H
+#define LINUX_I2C_DEVICE_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "Wire.h"
+
+class LinuxI2cDevice final : public I2cDevice {
+  public:
+    LinuxI2cDevice(const char* path, uint8_t address) : _address(address) {
+        _fd = open(path, O_RDWR | O_CLOEXEC);
+        if (_fd >= 0 && ioctl(_fd, I2C_SLAVE, address) < 0) {
+            close(_fd);
+            _fd = -1;
+        }
+    }
+
+    ~LinuxI2cDevice() {
+        if (_fd >= 0) {
+            close(_fd);
+        }
+    }
+
+    bool isOpen() const {
+        return _fd >= 0;
+    }
+
+    uint8_t onWrite(const uint8_t data[], size_t length) override {
+        if (!length) {
+            // address probe, write() cannot send zero bytes
+            struct i2c_msg message = {_address, 0, 0, nullptr};
+            struct i2c_rdwr_ioctl_data transfer = {&message, 1};
+            return ioctl(_fd, I2C_RDWR, &transfer) < 0 ? _nackCode() : 0;
+        }
+        ssize_t written = write(_fd, data, length);
+        return written == static_cast<ssize_t>(length) ? 0 : _nackCode();
+    }
+
+    size_t onRead(uint8_t data[], size_t length) override {
+        ssize_t received = read(_fd, data, length);
+        return received > 0 ? static_cast<size_t>(received) : 0;
+    }
+
+  private:
+    // adapters report a NACK as ENXIO or EREMOTEIO without telling whether
+    // the address or a data byte was refused; 4 is "other error"
+    static uint8_t _nackCode() {
+        return (errno == ENXIO || errno == EREMOTEIO) ? 2 : 4;
+    }
+
+    int _fd;
+    uint16_t _address;
+};
+
+#endif /* LINUX_I2C_DEVICE_H */
@@ -0,0 +1,356 @@
+#include "Scd4xBusOwner.h"
+
+#include "Arduino.h"
+
+void Scd4xMpscQueue::push(Scd4xQueueNode* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    // sequentially consistent, pairs with the owner's sleep check
+    Scd4xQueueNode* previous = _head.exchange(node, std::memory_order_seq_cst);
+    previous->next.store(node, std::memory_order_release);
+}
+
+Scd4xQueueNode* Scd4xMpscQueue::pop() {
+    Scd4xQueueNode* tail = _tail;
+    Scd4xQueueNode* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &_stub) {
+        if (!next) {
+            return nullptr;
+        }
+        _tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        _tail = next;
+        return tail;
+    }
+    if (tail != _head.load(std::memory_order_acquire)) {
+        // a producer swapped the head but has not linked its node yet
+        return nullptr;
+    }
+    // tail is the last node, put the stub behind it to release it
+    push(&_stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        _tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+bool Scd4xMpscQueue::empty() const {
+    return _head.load(std::memory_order_seq_cst) == _tail &&
+           !_tail->next.load(std::memory_order_acquire);
+}
+
+static Scd4xResult<Scd4xSample> readSample(SensirionI2CScd4x& scd4x) {
+    Scd4xResult<Scd4xSample> result = {};
+    Scd4xSample& sample = result.value;
+
+    result.error = scd4x.readMeasurementTicks(
+        sample.co2, sample.temperatureTicks, sample.humidityTicks);
+    sample.timestamp = millis();
+    sample.temperature = static_cast<float>(
+        sample.temperatureTicks * 175.0 / 65536.0 - 45.0);
+    sample.humidity =
+        static_cast<float>(sample.humidityTicks * 100.0 / 65536.0);
+    sample.flags = (sample.co2 == 0) ? SampleInvalidCo2 : 0;
+    return result;
+}
+
+void Scd4xSampleRequest::run(SensirionI2CScd4x& scd4x) {
+    answer(readSample(scd4x));
+}
+
+Scd4xBusOwner::Scd4xBusOwner(SensirionI2CScd4x& scd4x, uint32_t samplePollMs)
+    : _scd4x(scd4x), _samplePollMs(samplePollMs) {
+}
+
+Scd4xBusOwner::~Scd4xBusOwner() {
+    stop();
+}
+
+void Scd4xBusOwner::start() {
+    if (_running.exchange(true)) {
+        return;
+    }
+    _thread = std::thread(&Scd4xBusOwner::_loop, this);
+}
+
+void Scd4xBusOwner::stop() {
+    if (!_running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _wakeUp.notify_one();
+    }
+    _thread.join();
+
+    // producers that saw the owner running finish their push, later ones
+    // fail in _enqueue()
+    while (_producers.load(std::memory_order_seq_cst)) {
+        std::this_thread::yield();
+    }
+    // everything still queued or waiting
+    while (Scd4xQueueNode* node = _queue.pop()) {
+        Scd4xRequest* request = static_cast<Scd4xRequest*>(node);
+        request->fail(SCD4X_BUS_OWNER_STOPPED);
+        delete request;
+    }
+    _finish(_anyMode, SCD4X_BUS_OWNER_STOPPED);
+    _finish(_idleMode, SCD4X_BUS_OWNER_STOPPED);
+    _finish(_sampleWaiters, SCD4X_BUS_OWNER_STOPPED);
+}
+
+void Scd4xBusOwner::_enqueue(Scd4xRequest* request) {
+    // sequentially consistent, pairs with the flag and the wait in stop()
+    _producers.fetch_add(1, std::memory_order_seq_cst);
+    if (!_running.load(std::memory_order_seq_cst)) {
+        _producers.fetch_sub(1, std::memory_order_release);
+        request->fail(SCD4X_BUS_OWNER_STOPPED);
+        delete request;
+        return;
+    }
+    _queue.push(request);
+    if (_sleeping.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _wakeUp.notify_one();
+    }
+    _producers.fetch_sub(1, std::memory_order_release);
+}
+
+void Scd4xBusOwner::_finish(std::vector<Scd4xRequest*>& requests,
+                            uint16_t error) {
+    for (Scd4xRequest* request : requests) {
+        if (error) {
+            request->fail(error);
+        } else {
+            request->run(_scd4x);
+        }
+        delete request;
+    }
+    requests.clear();
+}
+
+void Scd4xBusOwner::_loop() {
+    while (_running.load(std::memory_order_relaxed)) {
+        bool received = false;
+
+        while (Scd4xQueueNode* node = _queue.pop()) {
+            Scd4xRequest* request = static_cast<Scd4xRequest*>(node);
+            received = true;
+            _stats.requests++;
+            switch (request->mode) {
+                case Scd4xAnyMode:
+                    _anyMode.push_back(request);
+                    break;
+                case Scd4xIdleMode:
+                    _idleMode.push_back(request);
+                    break;
+                case Scd4xSampleWait:
+                    _sampleWaiters.push_back(request);
+                    break;
+                case Scd4xModeChange:
+                    // everything queued before runs in the old mode
+                    _runBatch();
+                    request->run(_scd4x);
+                    delete request;
+                    break;
+            }
+        }
+        if (received) {
+            _runBatch();
+        }
+        if (!_sampleWaiters.empty()) {
+            _serveSampleWaiters();
+            continue;
+        }
+        if (received) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _sleeping.store(true, std::memory_order_seq_cst);
+        if (_queue.empty() && _running.load(std::memory_order_relaxed)) {
+            _wakeUp.wait(lock);
+        }
+        _sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+void Scd4xBusOwner::_runBatch() {
+    if (_anyMode.empty() && _idleMode.empty()) {
+        return;
+    }
+    _stats.batches++;
+    _finish(_anyMode, NoError);
+    if (_idleMode.empty()) {
+        return;
+    }
+
+    bool restart = _measuring.load(std::memory_order_relaxed);
+    if (restart) {
+        uint16_t error = _scd4x.stopPeriodicMeasurement();
+        if (error) {
+            _finish(_idleMode, error);
+            return;
+        }
+        _stats.idleWindows++;
+    }
+    _stats.idleRequests += _idleMode.size();
+    _finish(_idleMode, NoError);
+    if (restart && _scd4x.startPeriodicMeasurement()) {
+        _measuring.store(false, std::memory_order_relaxed);
+    }
+}
+
+void Scd4xBusOwner::_serveSampleWaiters() {
+    uint16_t dataReady = 0;
+
+    if (!_measuring.load(std::memory_order_relaxed)) {
+        _finish(_sampleWaiters, SCD4X_BUS_OWNER_NOT_MEASURING);
+        return;
+    }
+    if (_scd4x.getDataReadyStatus(dataReady) || !(dataReady & 0x07FF)) {
+        // on the VirtualClock delay() lets simulated time pass
+        delay(_samplePollMs);
+        return;
+    }
+
+    Scd4xResult<Scd4xSample> result = readSample(_scd4x);
+    _stats.sampleReads++;
+    _stats.sampleWaiters += _sampleWaiters.size();
+
+    // one read answers everybody waiting
+    for (Scd4xRequest* request : _sampleWaiters) {
+        static_cast<Scd4xSampleRequest*>(request)->answer(result);
+        delete request;
+    }
+    _sampleWaiters.clear();
+}
+
+std::future<Scd4xResult<bool>> Scd4xBusOwner::startPeriodicMeasurement() {
+    return submit<bool>(Scd4xModeChange,
+                        [this](SensirionI2CScd4x& scd4x, bool& started) {
+                            uint16_t error = scd4x.startPeriodicMeasurement();
+                            started = !error;
+                            if (started) {
+                                _measuring.store(true);
+                            }
+                            return error;
+                        });
+}
+
+std::future<Scd4xResult<bool>> Scd4xBusOwner::stopPeriodicMeasurement() {
+    return submit<bool>(Scd4xModeChange,
+                        [this](SensirionI2CScd4x& scd4x, bool& stopped) {
+                            uint16_t error = scd4x.stopPeriodicMeasurement();
+                            stopped = !error;
+                            if (stopped) {
+                                _measuring.store(false);
+                            }
+                            return error;
+                        });
+}
+
+std::future<Scd4xResult<Scd4xSample>> Scd4xBusOwner::readMeasurement() {
+    auto* request = new Scd4xSampleRequest();
+    std::future<Scd4xResult<Scd4xSample>> future = request->future();
+    _enqueue(request);
+    return future;
+}
+
+std::future<Scd4xResult<bool>> Scd4xBusOwner::setAmbientPressure(uint16_t hPa) {
+    return submit<bool>(Scd4xAnyMode,
+                        [hPa](SensirionI2CScd4x& scd4x, bool& done) {
+                            uint16_t error = scd4x.setAmbientPressure(hPa);
+                            done = !error;
+                            return error;
+                        });
+}
+
+std::future<Scd4xResult<float>> Scd4xBusOwner::getTemperatureOffset() {
+    return submit<float>(Scd4xIdleMode,
+                         [](SensirionI2CScd4x& scd4x, float& offset) {
+                             return scd4x.getTemperatureOffset(offset);
+                         });
+}
+
+std::future<Scd4xResult<bool>>
+Scd4xBusOwner::setTemperatureOffset(float offset) {
+    return submit<bool>(Scd4xIdleMode,
+                        [offset](SensirionI2CScd4x& scd4x, bool& done) {
+                            uint16_t error = scd4x.setTemperatureOffset(offset);
+                            done = !error;
+                            return error;
+                        });
+}
+
+std::future<Scd4xResult<uint16_t>> Scd4xBusOwner::getSensorAltitude() {
+    return submit<uint16_t>(Scd4xIdleMode,
+                            [](SensirionI2CScd4x& scd4x, uint16_t& altitude) {
+                                return scd4x.getSensorAltitude(altitude);
+                            });
+}
+
+std::future<Scd4xResult<bool>>
+Scd4xBusOwner::setSensorAltitude(uint16_t altitude) {
+    return submit<bool>(Scd4xIdleMode,
+                        [altitude](SensirionI2CScd4x& scd4x, bool& done) {
+                            uint16_t error = scd4x.setSensorAltitude(altitude);
+                            done = !error;
+                            return error;
+                        });
+}
+
+std::future<Scd4xResult<uint16_t>>
+Scd4xBusOwner::getAutomaticSelfCalibration() {
+    return submit<uint16_t>(Scd4xIdleMode,
+                            [](SensirionI2CScd4x& scd4x, uint16_t& enabled) {
+                                return scd4x.getAutomaticSelfCalibration(
+                                    enabled);
+                            });
+}
+
+std::future<Scd4xResult<bool>>
+Scd4xBusOwner::setAutomaticSelfCalibration(bool enabled) {
+    return submit<bool>(Scd4xIdleMode,
+                        [enabled](SensirionI2CScd4x& scd4x, bool& done) {
+                            uint16_t error =
+                                scd4x.setAutomaticSelfCalibration(enabled);
+                            done = !error;
+                            return error;
+                        });
+}
+
+std::future<Scd4xResult<uint16_t>>
+Scd4xBusOwner::performForcedRecalibration(uint16_t targetCo2) {
+    return submit<uint16_t>(
+        Scd4xIdleMode,
+        [targetCo2](SensirionI2CScd4x& scd4x, uint16_t& correction) {
+            return scd4x.performForcedRecalibration(targetCo2, correction);
+        });
+}
+
+std::future<Scd4xResult<bool>> Scd4xBusOwner::persistSettings() {
+    return submit<bool>(Scd4xIdleMode,
+                        [](SensirionI2CScd4x& scd4x, bool& done) {
+                            uint16_t error = scd4x.persistSettings();
+                            done = !error;
+                            return error;
+                        });
+}
+
+std::future<Scd4xResult<uint64_t>> Scd4xBusOwner::getSerialNumber() {
+    return submit<uint64_t>(
+        Scd4xIdleMode, [](SensirionI2CScd4x& scd4x, uint64_t& serialNumber) {
+            uint16_t words[3];
+            uint16_t error =
+                scd4x.getSerialNumber(words[0], words[1], words[2]);
+            serialNumber = static_cast<uint64_t>(words[0]) << 32 |
+                           static_cast<uint64_t>(words[1]) << 16 | words[2];
+            return error;
+        });
+}
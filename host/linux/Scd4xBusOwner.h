@@ -0,0 +1,229 @@
+/*
+ * Scd4xBusOwner - Runs every SensirionI2CScd4x call on one thread, so any
+ * number of threads (REST handlers, calibration, logging) can use a sensor
+ * without interleaving transactions on the bus. Requests are pushed into a
+ * lock-free multi-producer/single-consumer queue and answered through
+ * std::future.
+ *
+ * The owner thread takes everything queued at once and runs it as a batch:
+ * - requests allowed during periodic measurement run first, in order;
+ * - requests which need idle mode (settings, calibration, serial number)
+ *   then share a single stop / start window instead of one each;
+ * - readMeasurement() requests wait for the next sample and are answered
+ *   together with one bus read.
+ * Starting and stopping the measurement are barriers: everything queued
+ * before runs first.
+ */
+#ifndef SCD4X_BUS_OWNER_H
+#define SCD4X_BUS_OWNER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Scd4xResult.h"
+#include "SensirionI2CScd4x.h"
+
+// answer to requests left when the owner stops or made while it is stopped
+#define SCD4X_BUS_OWNER_STOPPED (ExecutionError | NoDataError)
+// answer to readMeasurement() without periodic measurement
+#define SCD4X_BUS_OWNER_NOT_MEASURING (ReadError | NoDataError)
+
+enum Scd4xRequestMode : uint8_t {
+    Scd4xAnyMode,    // also during periodic measurement
+    Scd4xIdleMode,   // needs idle mode, batched into a stop / start window
+    Scd4xModeChange, // starts or stops the measurement, a barrier
+    Scd4xSampleWait, // waits for the next measurement
+};
+
+/*
+ * Scd4xQueueNode - Link of the intrusive MPSC queue (Vyukov): producers
+ * swap themselves into the head with one atomic exchange, the single
+ * consumer follows the links from the tail.
+ */
+struct Scd4xQueueNode {
+    std::atomic<Scd4xQueueNode*> next{nullptr};
+};
+
+class Scd4xMpscQueue {
+  public:
+    Scd4xMpscQueue() : _head(&_stub), _tail(&_stub) {
+    }
+
+    // any thread
+    void push(Scd4xQueueNode* node);
+
+    // owner thread only; nullptr if empty or a push is half done
+    Scd4xQueueNode* pop();
+
+    // owner thread only
+    bool empty() const;
+
+  private:
+    Scd4xQueueNode _stub;
+    std::atomic<Scd4xQueueNode*> _head;
+    Scd4xQueueNode* _tail;
+};
+
+class Scd4xRequest : public Scd4xQueueNode {
+  public:
+    explicit Scd4xRequest(Scd4xRequestMode mode) : mode(mode) {
+    }
+    virtual ~Scd4xRequest() {
+    }
+
+    // executes the command on the owner thread and fulfills the promise
+    virtual void run(SensirionI2CScd4x& scd4x) = 0;
+    virtual void fail(uint16_t error) = 0;
+
+    const Scd4xRequestMode mode;
+};
+
+template <typename T, typename F>
+class Scd4xValueRequest : public Scd4xRequest {
+  public:
+    Scd4xValueRequest(Scd4xRequestMode mode, F call)
+        : Scd4xRequest(mode), _call(call) {
+    }
+
+    std::future<Scd4xResult<T>> future() {
+        return _promise.get_future();
+    }
+
+    void run(SensirionI2CScd4x& scd4x) override {
+        Scd4xResult<T> result = {};
+        result.error = _call(scd4x, result.value);
+        _promise.set_value(result);
+    }
+
+    void fail(uint16_t error) override {
+        Scd4xResult<T> result = {};
+        result.error = error;
+        _promise.set_value(result);
+    }
+
+  private:
+    F _call;
+    std::promise<Scd4xResult<T>> _promise;
+};
+
+// readMeasurement(), answered by the owner together with all other waiters
+class Scd4xSampleRequest : public Scd4xRequest {
+  public:
+    Scd4xSampleRequest() : Scd4xRequest(Scd4xSampleWait) {
+    }
+
+    std::future<Scd4xResult<Scd4xSample>> future() {
+        return _promise.get_future();
+    }
+
+    void answer(const Scd4xResult<Scd4xSample>& result) {
+        _promise.set_value(result);
+    }
+
+    // reads once without waiting for data
+    void run(SensirionI2CScd4x& scd4x) override;
+
+    void fail(uint16_t error) override {
+        Scd4xResult<Scd4xSample> result = {};
+        result.error = error;
+        _promise.set_value(result);
+    }
+
+  private:
+    std::promise<Scd4xResult<Scd4xSample>> _promise;
+};
+
+struct Scd4xBusOwnerStats {
+    uint64_t requests;
+    uint64_t batches;
+    uint64_t idleWindows;   // stop / start windows opened for idle requests
+    uint64_t idleRequests;  // requests served in those windows
+    uint64_t sampleReads;   // bus reads answering readMeasurement()
+    uint64_t sampleWaiters; // readMeasurement() requests answered
+};
+
+class Scd4xBusOwner {
+  public:
+    explicit Scd4xBusOwner(SensirionI2CScd4x& scd4x,
+                           uint32_t samplePollMs = 100);
+    ~Scd4xBusOwner();
+
+    // starts the owner thread; the driver must not be used directly after
+    void start();
+    // answers all open requests with SCD4X_BUS_OWNER_STOPPED and joins;
+    // requests made while the owner is not running fail at once
+    void stop();
+
+    /**
+     * submit() - Run any driver call on the owner thread.
+     *
+     * @param mode Mode the call needs, see Scd4xRequestMode.
+     * @param call Callable uint16_t(SensirionI2CScd4x&, T&) returning the
+     *             driver's error code and storing its result.
+     *
+     * @return Future of the error code and result
+     */
+    template <typename T, typename F>
+    std::future<Scd4xResult<T>> submit(Scd4xRequestMode mode, F call) {
+        auto* request = new Scd4xValueRequest<T, F>(mode, call);
+        std::future<Scd4xResult<T>> future = request->future();
+        _enqueue(request);
+        return future;
+    }
+
+    std::future<Scd4xResult<bool>> startPeriodicMeasurement();
+    std::future<Scd4xResult<bool>> stopPeriodicMeasurement();
+    std::future<Scd4xResult<Scd4xSample>> readMeasurement();
+    std::future<Scd4xResult<bool>> setAmbientPressure(uint16_t hPa);
+    std::future<Scd4xResult<float>> getTemperatureOffset();
+    std::future<Scd4xResult<bool>> setTemperatureOffset(float offset);
+    std::future<Scd4xResult<uint16_t>> getSensorAltitude();
+    std::future<Scd4xResult<bool>> setSensorAltitude(uint16_t altitude);
+    std::future<Scd4xResult<uint16_t>> getAutomaticSelfCalibration();
+    std::future<Scd4xResult<bool>> setAutomaticSelfCalibration(bool enabled);
+    std::future<Scd4xResult<uint16_t>>
+    performForcedRecalibration(uint16_t targetCo2);
+    std::future<Scd4xResult<bool>> persistSettings();
+    std::future<Scd4xResult<uint64_t>> getSerialNumber();
+
+    bool isMeasuring() const {
+        return _measuring.load(std::memory_order_relaxed);
+    }
+
+    // consistent after stop()
+    const Scd4xBusOwnerStats& stats() const {
+        return _stats;
+    }
+
+  private:
+    void _enqueue(Scd4xRequest* request);
+    void _loop();
+    void _runBatch();
+    void _serveSampleWaiters();
+    void _finish(std::vector<Scd4xRequest*>& requests, uint16_t error);
+
+    SensirionI2CScd4x& _scd4x;
+    uint32_t _samplePollMs;
+    Scd4xMpscQueue _queue;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _measuring{false};
+    std::atomic<unsigned> _producers{0};  // inside _enqueue()
+
+    // wake-up of an idle owner; producers only lock while it sleeps
+    std::mutex _mutex;
+    std::condition_variable _wakeUp;
+    std::atomic<bool> _sleeping{false};
+
+    // owner thread only
+    std::vector<Scd4xRequest*> _anyMode;
+    std::vector<Scd4xRequest*> _idleMode;
+    std::vector<Scd4xRequest*> _sampleWaiters;
+    Scd4xBusOwnerStats _stats = {};
+};
+
+#endif /* SCD4X_BUS_OWNER_H */
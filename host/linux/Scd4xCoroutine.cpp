@@ -0,0 +1,174 @@
+#include "Scd4xCoroutine.h"
+
+#include "VirtualClock.h"
+
+/*
+ * Scd4xDetachedTask - Coroutine wrapping a spawned task: it starts from the
+ * executor's timer queue and destroys itself when the task has finished.
+ */
+struct Scd4xDetachedTask {
+    struct promise_type {
+        Scd4xDetachedTask get_return_object() {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() {
+        }
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+
+    static Scd4xDetachedTask run(Scd4xExecutor& executor,
+                                 Scd4xTask<void> task) {
+        co_await task;
+        executor._tasks--;
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+Scd4xExecutor::Sleep Scd4xExecutor::sleep(uint64_t us) {
+    return Sleep(*this, VirtualClock::micros() + us);
+}
+
+void Scd4xExecutor::schedule(uint64_t deadlineUs,
+                             std::coroutine_handle<> handle) {
+    _timers.push(Timer{deadlineUs, _sequence++, handle});
+}
+
+void Scd4xExecutor::spawn(Scd4xTask<void> task) {
+    _tasks++;
+    schedule(VirtualClock::micros(),
+             Scd4xDetachedTask::run(*this, std::move(task)).handle);
+}
+
+void Scd4xExecutor::run() {
+    while (!_timers.empty()) {
+        Timer timer = _timers.top();
+        _timers.pop();
+
+        uint64_t now = VirtualClock::micros();
+        if (timer.deadline > now) {
+            // jumps in virtual time, sleeps when following real time
+            VirtualClock::advance(timer.deadline - now);
+        }
+        _resumptions++;
+        timer.handle.resume();
+    }
+}
+
+Scd4xAsync::Scd4xAsync(SensirionI2CScd4x& scd4x, Scd4xExecutor& executor,
+                       uint16_t dataReadyPollMs)
+    : _scd4x(scd4x), _executor(executor), _dataReadyPollMs(dataReadyPollMs) {
+}
+
+Scd4xTask<Scd4xResult<Scd4xResponse>>
+Scd4xAsync::commandAsync(Scd4xCommandId command, uint16_t argument) {
+    Scd4xResult<Scd4xResponse> result = {};
+
+    result.error = _scd4x.sendCommand(command, &argument);
+    if (result.error) {
+        co_return result;
+    }
+    co_await _executor.sleep(SensirionI2CScd4x::executionTime(command) *
+                             1000ULL);
+    if (SensirionI2CScd4x::responseWords(command)) {
+        result.error = _scd4x.readResponse(command, result.value.words);
+    }
+    co_return result;
+}
+
+Scd4xTask<uint16_t> Scd4xAsync::_run(Scd4xCommandId command,
+                                     uint16_t argument) {
+    Scd4xResult<Scd4xResponse> result =
+        co_await commandAsync(command, argument);
+    co_return result.error;
+}
+
+Scd4xTask<uint16_t> Scd4xAsync::startPeriodicMeasurementAsync() {
+    return _run(Scd4xCmdStartPeriodicMeasurement);
+}
+
+Scd4xTask<uint16_t> Scd4xAsync::startLowPowerPeriodicMeasurementAsync() {
+    return _run(Scd4xCmdStartLowPowerPeriodicMeasurement);
+}
+
+Scd4xTask<uint16_t> Scd4xAsync::stopPeriodicMeasurementAsync() {
+    return _run(Scd4xCmdStopPeriodicMeasurement);
+}
+
+Scd4xTask<Scd4xResult<Scd4xSample>> Scd4xAsync::readMeasurementAsync() {
+    Scd4xResult<Scd4xSample> result = {};
+    Scd4xResult<Scd4xResponse> response;
+
+    for (;;) {
+        response = co_await commandAsync(Scd4xCmdGetDataReadyStatus);
+        if (response.error) {
+            result.error = response.error;
+            co_return result;
+        }
+        if (response.value.words[0] & 0x07FF) {
+            break;
+        }
+        co_await _executor.sleep(_dataReadyPollMs * 1000ULL);
+    }
+
+    response = co_await commandAsync(Scd4xCmdReadMeasurement);
+    result.error = response.error;
+    if (!result.error) {
+        Scd4xSample& sample = result.value;
+        sample.timestamp = static_cast<uint32_t>(VirtualClock::micros() / 1000);
+        sample.co2 = response.value.words[0];
+        sample.temperatureTicks = response.value.words[1];
+        sample.humidityTicks = response.value.words[2];
+        sample.temperature = static_cast<float>(
+            sample.temperatureTicks * 175.0 / 65536.0 - 45.0);
+        sample.humidity =
+            static_cast<float>(sample.humidityTicks * 100.0 / 65536.0);
+        sample.flags = (sample.co2 == 0) ? SampleInvalidCo2 : 0;
+    }
+    co_return result;
+}
+
+Scd4xTask<uint16_t> Scd4xAsync::measureSingleShotAsync() {
+    return _run(Scd4xCmdMeasureSingleShot);
+}
+
+Scd4xTask<uint16_t> Scd4xAsync::setAmbientPressureAsync(uint16_t hPa) {
+    return _run(Scd4xCmdSetAmbientPressure, hPa);
+}
+
+Scd4xTask<uint16_t> Scd4xAsync::setTemperatureOffsetAsync(float offset) {
+    return _run(Scd4xCmdSetTemperatureOffset,
+                static_cast<uint16_t>(offset * 65536.0 / 175.0 + 0.5f));
+}
+
+Scd4xTask<uint16_t> Scd4xAsync::setSensorAltitudeAsync(uint16_t altitude) {
+    return _run(Scd4xCmdSetSensorAltitude, altitude);
+}
+
+Scd4xTask<Scd4xResult<uint16_t>>
+Scd4xAsync::performForcedRecalibrationAsync(uint16_t targetCo2) {
+    Scd4xResult<Scd4xResponse> response =
+        co_await commandAsync(Scd4xCmdPerformForcedRecalibration, targetCo2);
+    co_return Scd4xResult<uint16_t>{response.error, response.value.words[0]};
+}
+
+Scd4xTask<uint16_t> Scd4xAsync::persistSettingsAsync() {
+    return _run(Scd4xCmdPersistSettings);
+}
+
+Scd4xTask<Scd4xResult<uint64_t>> Scd4xAsync::getSerialNumberAsync() {
+    Scd4xResult<Scd4xResponse> response =
+        co_await commandAsync(Scd4xCmdGetSerialNumber);
+    const uint16_t* words = response.value.words;
+    co_return Scd4xResult<uint64_t>{
+        response.error, static_cast<uint64_t>(words[0]) << 32 |
+                            static_cast<uint64_t>(words[1]) << 16 | words[2]};
+}
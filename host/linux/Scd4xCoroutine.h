@@ -0,0 +1,266 @@
+/*
+ * Scd4xCoroutine - C++20 coroutine interface to SensirionI2CScd4x for host
+ * builds. Commands are awaited instead of blocking:
+ *
+ *     Scd4xTask<void> logger(Scd4xAsync& sensor) {
+ *         co_await sensor.startPeriodicMeasurementAsync();
+ *         for (;;) {
+ *             Scd4xResult<Scd4xSample> sample =
+ *                 co_await sensor.readMeasurementAsync();
+ *             ...
+ *         }
+ *     }
+ *
+ * Each command is sent with sendCommand(), the coroutine then suspends on
+ * the Scd4xExecutor timer for the command's execution time and collects
+ * the response with readResponse(). No thread blocks while a sensor is
+ * busy, so one thread running Scd4xExecutor::run() drives any number of
+ * sensors, each on its own bus or mux channel.
+ *
+ * Waiting follows VirtualClock: in virtual time run() jumps to the next
+ * timer, with followRealTime() it sleeps until then.
+ */
+#ifndef SCD4X_COROUTINE_H
+#define SCD4X_COROUTINE_H
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "Scd4xResult.h"
+#include "SensirionI2CScd4x.h"
+
+template <typename T> class Scd4xTask;
+
+// common part of the Scd4xTask promises: lazy start, and on completion
+// transfer to the awaiting coroutine
+struct Scd4xTaskPromiseBase {
+    struct FinalAwaiter {
+        bool await_ready() noexcept {
+            return false;
+        }
+        template <typename P>
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<P> handle) noexcept {
+            std::coroutine_handle<> next = handle.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {
+        }
+    };
+
+    std::suspend_always initial_suspend() noexcept {
+        return {};
+    }
+    FinalAwaiter final_suspend() noexcept {
+        return {};
+    }
+    // built without exception handling in mind, like the driver
+    void unhandled_exception() noexcept {
+        std::terminate();
+    }
+
+    std::coroutine_handle<> continuation;
+};
+
+template <typename T> struct Scd4xTaskPromise : Scd4xTaskPromiseBase {
+    void return_value(T result) {
+        value = std::move(result);
+    }
+    T result() {
+        return std::move(value);
+    }
+
+    T value{};
+};
+
+template <> struct Scd4xTaskPromise<void> : Scd4xTaskPromiseBase {
+    void return_void() {
+    }
+    void result() {
+    }
+};
+
+/*
+ * Scd4xTask - Coroutine returning T. It starts when awaited, or when handed
+ * to Scd4xExecutor::spawn(), and owns its frame.
+ */
+template <typename T> class Scd4xTask {
+  public:
+    struct promise_type : Scd4xTaskPromise<T> {
+        Scd4xTask get_return_object() {
+            return Scd4xTask(
+                std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    Scd4xTask(Scd4xTask&& other) noexcept
+        : _handle(std::exchange(other._handle, nullptr)) {
+    }
+    Scd4xTask(const Scd4xTask&) = delete;
+    Scd4xTask& operator=(const Scd4xTask&) = delete;
+    ~Scd4xTask() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return _handle.done();
+    }
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        _handle.promise().continuation = awaiting;
+        return _handle;
+    }
+    T await_resume() {
+        return _handle.promise().result();
+    }
+
+  private:
+    explicit Scd4xTask(std::coroutine_handle<promise_type> handle)
+        : _handle(handle) {
+    }
+
+    std::coroutine_handle<promise_type> _handle;
+};
+
+/*
+ * Scd4xExecutor - Single-threaded timer loop resuming suspended coroutines
+ * in deadline order.
+ */
+class Scd4xExecutor {
+  public:
+    class Sleep {
+      public:
+        Sleep(Scd4xExecutor& executor, uint64_t deadlineUs)
+            : _executor(executor), _deadline(deadlineUs) {
+        }
+        bool await_ready() const noexcept {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            _executor.schedule(_deadline, handle);
+        }
+        void await_resume() noexcept {
+        }
+
+      private:
+        Scd4xExecutor& _executor;
+        uint64_t _deadline;
+    };
+
+    // co_await sleep(us) suspends for `us` microseconds
+    Sleep sleep(uint64_t us);
+
+    // resumes `handle` from run() once the clock reaches `deadlineUs`;
+    // equal deadlines resume in scheduling order
+    void schedule(uint64_t deadlineUs, std::coroutine_handle<> handle);
+
+    // starts `task` from run(); the executor owns it until it finishes
+    void spawn(Scd4xTask<void> task);
+
+    // resumes coroutines until no timer is left, which is when all spawned
+    // tasks have finished
+    void run();
+
+    size_t tasks() const {
+        return _tasks;
+    }
+
+    uint64_t resumptions() const {
+        return _resumptions;
+    }
+
+  private:
+    struct Timer {
+        uint64_t deadline;
+        uint64_t sequence;
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline
+                                              : sequence > other.sequence;
+        }
+    };
+
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>>
+        _timers;
+    uint64_t _sequence = 0;
+    uint64_t _resumptions = 0;
+    size_t _tasks = 0;
+
+    friend struct Scd4xDetachedTask;
+};
+
+// response words of any command
+struct Scd4xResponse {
+    uint16_t words[3];
+};
+
+/*
+ * Scd4xAsync - Awaitable commands of one sensor. The driver must not be
+ * called directly while a command of this object is in flight, and only one
+ * coroutine may use the object at a time.
+ */
+class Scd4xAsync {
+  public:
+    Scd4xAsync(SensirionI2CScd4x& scd4x, Scd4xExecutor& executor,
+               uint16_t dataReadyPollMs = 100);
+
+    /**
+     * commandAsync() - Send a command, suspend for its execution time and
+     * read the response, if any.
+     *
+     * @param command  Command to run
+     * @param argument Argument word for commands which take one
+     *
+     * @return Error code and response words
+     */
+    Scd4xTask<Scd4xResult<Scd4xResponse>>
+    commandAsync(Scd4xCommandId command, uint16_t argument = 0);
+
+    Scd4xTask<uint16_t> startPeriodicMeasurementAsync();
+    Scd4xTask<uint16_t> startLowPowerPeriodicMeasurementAsync();
+    Scd4xTask<uint16_t> stopPeriodicMeasurementAsync();
+
+    /**
+     * readMeasurementAsync() - Wait for the next measurement and read it.
+     * Polls the data ready status every dataReadyPollMs, suspending in
+     * between. Works in periodic measurement and after
+     * measureSingleShotAsync().
+     *
+     * @return Error code and sample
+     */
+    Scd4xTask<Scd4xResult<Scd4xSample>> readMeasurementAsync();
+
+    Scd4xTask<uint16_t> measureSingleShotAsync();
+    Scd4xTask<uint16_t> setAmbientPressureAsync(uint16_t hPa);
+    Scd4xTask<uint16_t> setTemperatureOffsetAsync(float offset);
+    Scd4xTask<uint16_t> setSensorAltitudeAsync(uint16_t altitude);
+
+    /**
+     * performForcedRecalibrationAsync() - Forced recalibration to
+     * `targetCo2` ppm. The sensor must have been measuring at that
+     * concentration and then stopped, see performForcedRecalibration().
+     *
+     * @return Error code and FRC correction, 0xFFFF if it failed
+     */
+    Scd4xTask<Scd4xResult<uint16_t>>
+    performForcedRecalibrationAsync(uint16_t targetCo2);
+
+    Scd4xTask<uint16_t> persistSettingsAsync();
+    Scd4xTask<Scd4xResult<uint64_t>> getSerialNumberAsync();
+
+  private:
+    Scd4xTask<uint16_t> _run(Scd4xCommandId command, uint16_t argument = 0);
+
+    SensirionI2CScd4x& _scd4x;
+    Scd4xExecutor& _executor;
+    uint16_t _dataReadyPollMs;
+};
+
+#endif /* SCD4X_COROUTINE_H */
@@ -0,0 +1,15 @@
+/*
+ * Scd4xResult - Error code and value of a driver call answered later, by
+ * Scd4xBusOwner futures or Scd4xAsync coroutines.
+ */
+#ifndef SCD4X_RESULT_H
+#define SCD4X_RESULT_H
+
+#include <stdint.h>
+
+template <typename T> struct Scd4xResult {
+    uint16_t error;
+    T value;
+};
+
+#endif /* SCD4X_RESULT_H */
@@ -0,0 +1,236 @@
+/*
+ * Scd4xShmRing - Ring of SCD4x samples in POSIX shared memory, written by
+ * the scd4xd daemon and read by any number of local processes straight from
+ * their mapping, without a copy through the kernel or a lock.
+ *
+ * The writer never waits for readers. Each slot carries a sequence number
+ * which is odd while the slot is written and 2 * (index + 1) afterwards; a
+ * reader copies the slot between two reads of that number and discards the
+ * copy if they differ or do not match the index it wanted, i.e. if the
+ * writer lapped it. All shared fields are lock-free atomics, so the copy is
+ * free of data races as well. Readers poll head() for new samples.
+ */
+#ifndef SCD4X_SHM_RING_H
+#define SCD4X_SHM_RING_H
+
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SCD4X_SHM_MAGIC 0x53434434  // "SCD4"
+#define SCD4X_SHM_VERSION 1
+#define SCD4X_SHM_DEFAULT_NAME "/scd4x"
+
+// sample as read from the shared memory
+struct Scd4xShmSample {
+    uint64_t index;
+    uint64_t timestampUs;  // CLOCK_REALTIME of the read-out
+    uint16_t co2;
+    uint16_t temperatureTicks;
+    uint16_t humidityTicks;
+    uint8_t flags;
+
+    float temperature() const {
+        return static_cast<float>(temperatureTicks * 175.0 / 65536.0 - 45.0);
+    }
+
+    float humidity() const {
+        return static_cast<float>(humidityTicks * 100.0 / 65536.0);
+    }
+};
+
+struct Scd4xShmSlot {
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> timestampUs;
+    std::atomic<uint64_t> measurement;  // co2, temperature, humidity, flags
+};
+
+struct Scd4xShmHeader {
+    std::atomic<uint32_t> magic;
+    uint16_t version;
+    uint16_t slotSize;
+    uint32_t capacity;
+    uint32_t intervalMs;
+    uint64_t serialNumber;
+    std::atomic<uint64_t> head;  // number of samples published
+    std::atomic<uint32_t> running;
+    uint32_t reserved;
+    Scd4xShmSlot slots[1];
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "the ring needs lock-free 64 bit atomics to be shared");
+
+static inline size_t scd4xShmSize(uint32_t capacity) {
+    return sizeof(Scd4xShmHeader) + (capacity - 1) * sizeof(Scd4xShmSlot);
+}
+
+class Scd4xShmWriter {
+  public:
+    ~Scd4xShmWriter() {
+        close();
+    }
+
+    // creates or replaces the segment; returns false with errno set
+    bool create(const char* name, uint32_t capacity, uint32_t intervalMs,
+                uint64_t serialNumber) {
+        size_t size = scd4xShmSize(capacity);
+
+        // a stale segment may still be mapped by readers, never resize it
+        shm_unlink(name);
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+
+        if (fd < 0) {
+            return false;
+        }
+        if (ftruncate(fd, size) < 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapping =
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+        // fresh pages are zero, so every sequence number starts unwritten
+        _header = static_cast<Scd4xShmHeader*>(mapping);
+        _size = size;
+        _header->version = SCD4X_SHM_VERSION;
+        _header->slotSize = sizeof(Scd4xShmSlot);
+        _header->capacity = capacity;
+        _header->intervalMs = intervalMs;
+        _header->serialNumber = serialNumber;
+        _header->running.store(1, std::memory_order_relaxed);
+        _header->magic.store(SCD4X_SHM_MAGIC, std::memory_order_release);
+        strncpy(_name, name, sizeof(_name) - 1);
+        return true;
+    }
+
+    void publish(uint64_t timestampUs, uint16_t co2, uint16_t temperatureTicks,
+                 uint16_t humidityTicks, uint8_t flags) {
+        uint64_t index = _header->head.load(std::memory_order_relaxed);
+        Scd4xShmSlot& slot = _header->slots[index % _header->capacity];
+        uint64_t measurement = static_cast<uint64_t>(co2) << 48 |
+                               static_cast<uint64_t>(temperatureTicks) << 32 |
+                               static_cast<uint64_t>(humidityTicks) << 16 |
+                               flags;
+
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timestampUs.store(timestampUs, std::memory_order_relaxed);
+        slot.measurement.store(measurement, std::memory_order_relaxed);
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+        _header->head.store(index + 1, std::memory_order_release);
+    }
+
+    // marks the ring as stopped and removes the name; mapped readers keep
+    // their view
+    void close() {
+        if (!_header) {
+            return;
+        }
+        _header->running.store(0, std::memory_order_release);
+        munmap(_header, _size);
+        shm_unlink(_name);
+        _header = nullptr;
+    }
+
+  private:
+    Scd4xShmHeader* _header = nullptr;
+    size_t _size = 0;
+    char _name[64] = {};
+};
+
+class Scd4xShmReader {
+  public:
+    ~Scd4xShmReader() {
+        if (_header) {
+            munmap(const_cast<Scd4xShmHeader*>(_header), _size);
+        }
+    }
+
+    // maps an existing ring read-only; returns false with errno set
+    bool open(const char* name) {
+        int fd = shm_open(name, O_RDONLY, 0);
+        struct stat status;
+
+        if (fd < 0) {
+            return false;
+        }
+        if (fstat(fd, &status) < 0 ||
+            static_cast<size_t>(status.st_size) < sizeof(Scd4xShmHeader)) {
+            ::close(fd);
+            errno = EINVAL;
+            return false;
+        }
+        void* mapping =
+            mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+        _header = static_cast<const Scd4xShmHeader*>(mapping);
+        _size = status.st_size;
+        if (_header->magic.load(std::memory_order_acquire) != SCD4X_SHM_MAGIC ||
+            _header->version != SCD4X_SHM_VERSION ||
+            _header->slotSize != sizeof(Scd4xShmSlot) ||
+            scd4xShmSize(_header->capacity) > _size) {
+            errno = EPROTO;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t head() const {
+        return _header->head.load(std::memory_order_acquire);
+    }
+
+    // oldest index which may still be read
+    uint64_t tail() const {
+        uint64_t head = this->head();
+        return head > _header->capacity ? head - _header->capacity : 0;
+    }
+
+    bool running() const {
+        return _header->running.load(std::memory_order_acquire) != 0;
+    }
+
+    const Scd4xShmHeader& header() const {
+        return *_header;
+    }
+
+    // false if the sample was not written yet or already overwritten
+    bool read(uint64_t index, Scd4xShmSample& sample) const {
+        const Scd4xShmSlot& slot = _header->slots[index % _header->capacity];
+        uint64_t expected = 2 * index + 2;
+
+        if (slot.sequence.load(std::memory_order_acquire) != expected) {
+            return false;
+        }
+        uint64_t timestampUs = slot.timestampUs.load(std::memory_order_relaxed);
+        uint64_t measurement = slot.measurement.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected) {
+            return false;
+        }
+        sample.index = index;
+        sample.timestampUs = timestampUs;
+        sample.co2 = static_cast<uint16_t>(measurement >> 48);
+        sample.temperatureTicks = static_cast<uint16_t>(measurement >> 32);
+        sample.humidityTicks = static_cast<uint16_t>(measurement >> 16);
+        sample.flags = static_cast<uint8_t>(measurement);
+        return true;
+    }
+
+  private:
+    const Scd4xShmHeader* _header = nullptr;
+    size_t _size = 0;
+};
+
+#endif /* SCD4X_SHM_RING_H */
@@ -0,0 +1,127 @@
+/*
+ * FileFlash - Scd4xStorage backed by a file which behaves like NOR flash:
+ * erase sets a whole segment to 0xFF, programming can only clear bits.
+ * Programmed bytes and erases are counted per segment so write amplification
+ * and wear can be measured, and a byte budget simulates a power failure by
+ * letting a write stop part way through.
+ */
+#ifndef FILE_FLASH_H
+#define FILE_FLASH_H
+
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Scd4xLogStore.h"
+
+class FileFlash : public Scd4xStorage {
+  public:
+    // opens or creates the file, a new file starts fully erased
+    FileFlash(const char* path, uint32_t size, uint16_t segmentSize)
+        : _size(size), _segmentSize(segmentSize),
+          _erases(size / segmentSize, 0) {
+        _file = fopen(path, "r+b");
+        if (!_file) {
+            _file = fopen(path, "w+b");
+            std::vector<uint8_t> blank(size, 0xFF);
+            fwrite(blank.data(), 1, size, _file);
+            fflush(_file);
+        }
+    }
+
+    ~FileFlash() {
+        if (_file) {
+            fclose(_file);
+        }
+    }
+
+    bool isOpen() const {
+        return _file != nullptr;
+    }
+
+    uint32_t size() const override {
+        return _size;
+    }
+
+    uint16_t segmentSize() const override {
+        return _segmentSize;
+    }
+
+    bool read(uint32_t address, uint8_t data[], size_t length) override {
+        if (address + length > _size) {
+            return false;
+        }
+        return pread(fileno(_file), data, length, address) ==
+               static_cast<ssize_t>(length);
+    }
+
+    bool write(uint32_t address, const uint8_t data[],
+               size_t length) override {
+        std::vector<uint8_t> cells(length);
+
+        if (_dead || !read(address, cells.data(), length)) {
+            return false;
+        }
+        size_t count = length;
+        if (count > _budget) {
+            count = _budget;
+            _dead = true;
+        }
+        _budget -= count;
+        for (size_t i = 0; i < count; i++) {
+            if (data[i] & ~cells[i]) {
+                _violations++;
+            }
+            cells[i] &= data[i];
+        }
+        _programmed += count;
+        pwrite(fileno(_file), cells.data(), count, address);
+        return !_dead;
+    }
+
+    bool erase(uint32_t segmentAddress) override {
+        if (_dead || segmentAddress % _segmentSize ||
+            segmentAddress + _segmentSize > _size) {
+            return false;
+        }
+        std::vector<uint8_t> blank(_segmentSize, 0xFF);
+        pwrite(fileno(_file), blank.data(), _segmentSize, segmentAddress);
+        _erases[segmentAddress / _segmentSize]++;
+        return true;
+    }
+
+    // fail after another `bytes` programmed bytes, until powerOn()
+    void powerFailAfter(size_t bytes) {
+        _budget = bytes;
+    }
+
+    void powerOn() {
+        _budget = static_cast<size_t>(-1);
+        _dead = false;
+    }
+
+    uint64_t programmedBytes() const {
+        return _programmed;
+    }
+
+    // writes which tried to set a bit without erasing first
+    uint64_t violations() const {
+        return _violations;
+    }
+
+    const std::vector<uint32_t>& erases() const {
+        return _erases;
+    }
+
+  private:
+    FILE* _file;
+    uint32_t _size;
+    uint16_t _segmentSize;
+    std::vector<uint32_t> _erases;
+    uint64_t _programmed = 0;
+    uint64_t _violations = 0;
+    size_t _budget = static_cast<size_t>(-1);
+    bool _dead = false;
+};
+
+#endif /* FILE_FLASH_H */
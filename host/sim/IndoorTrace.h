@@ -0,0 +1,120 @@
+/*
+ * IndoorTrace - Deterministic generator of realistic indoor CO2, temperature
+ * and humidity traces in SCD4x ticks, used by the host benchmarks and the
+ * simulated sensor. The noise comes from a self-contained xorshift generator,
+ * so a seed reproduces the same trace on every platform.
+ *
+ * CO2 follows a single-zone mass balance: occupants exhale into the room,
+ * ventilation pulls the concentration back towards outdoor level. Temperature
+ * follows a daily cycle plus occupant heat, humidity falls as the room warms
+ * and rises with occupancy. Sensor noise is added on top.
+ */
+#ifndef INDOOR_TRACE_H
+#define INDOOR_TRACE_H
+
+#include <math.h>
+#include <stdint.h>
+
+enum IndoorScenario {
+    ScenarioOffice,     // 6 people on weekdays 8-17h with lunch break
+    ScenarioBedroom,    // 2 people at night, door closed
+    ScenarioClassroom,  // 25 people in 45 minute lessons, windows opened
+};
+
+class IndoorTrace {
+  public:
+    IndoorTrace(IndoorScenario scenario, uint32_t seed)
+        : _scenario(scenario), _state(seed * 0x9E3779B97F4A7C15ULL + 1) {
+    }
+
+    // advance by dtSeconds and return the sensor reading in ticks
+    void step(double dtSeconds, uint16_t& co2, uint16_t& temperatureTicks,
+              uint16_t& humidityTicks) {
+        _time += dtSeconds;
+        double hour = fmod(_time / 3600.0, 24.0);
+        int day = static_cast<int>(_time / 86400.0) % 7;
+        double occupants = _occupants(hour, day);
+        double airChanges = _airChanges(hour);
+
+        // 0.0052 l/s CO2 per person, room volume 60 m^3
+        const double volume = 60.0;
+        double generation = occupants * 0.0052 / 1000.0 / volume * 1e6;
+        double decay = airChanges / 3600.0 * (_co2 - 420.0);
+        _co2 += (generation - decay) * dtSeconds;
+
+        double outdoor = 21.0 + 1.5 * sin((hour - 9.0) / 24.0 * 2 * M_PI);
+        double target = outdoor + 0.08 * occupants;
+        _temperature += (target - _temperature) * dtSeconds / 1800.0;
+        _humidity += ((45.0 - 2.0 * (_temperature - 21.0) + 0.3 * occupants) -
+                      _humidity) *
+                     dtSeconds / 2400.0;
+
+        double co2Reading = _co2 + _noise(5.0);
+        double temperatureReading = _temperature + _noise(0.02);
+        double humidityReading = _humidity + _noise(0.08);
+
+        co2 = _clamp(co2Reading);
+        temperatureTicks = _clamp((temperatureReading + 45.0) * 65536.0 / 175.0);
+        humidityTicks = _clamp(humidityReading * 65536.0 / 100.0);
+    }
+
+  private:
+    double _occupants(double hour, int day) {
+        switch (_scenario) {
+            case ScenarioOffice:
+                if (day >= 5 || hour < 8.0 || hour >= 17.0) {
+                    return 0;
+                }
+                return (hour >= 12.0 && hour < 13.0) ? 2 : 6;
+            case ScenarioBedroom:
+                return (hour >= 22.5 || hour < 6.5) ? 2 : 0;
+            case ScenarioClassroom:
+                if (day >= 5 || hour < 8.0 || hour >= 15.0) {
+                    return 0;
+                }
+                return (fmod(hour * 60.0, 60.0) < 45.0) ? 25 : 0;
+        }
+        return 0;
+    }
+
+    double _airChanges(double hour) {
+        if (_scenario == ScenarioClassroom &&
+            fmod(hour * 60.0, 60.0) >= 45.0) {
+            return 8.0;  // windows open during the break
+        }
+        return (_scenario == ScenarioBedroom) ? 0.4 : 1.2;
+    }
+
+    uint64_t _next() {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return _state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // Box-Muller transform of two uniform numbers in (0, 1]
+    double _noise(double sigma) {
+        double u1 = ((_next() >> 11) + 1.0) / 9007199254740992.0;
+        double u2 = ((_next() >> 11) + 1.0) / 9007199254740992.0;
+        return sigma * sqrt(-2.0 * log(u1)) * cos(2 * M_PI * u2);
+    }
+
+    static uint16_t _clamp(double value) {
+        if (value < 0) {
+            return 0;
+        }
+        if (value > 65535.0) {
+            return 65535;
+        }
+        return static_cast<uint16_t>(value + 0.5);
+    }
+
+    IndoorScenario _scenario;
+    uint64_t _state;
+    double _time = 0;
+    double _co2 = 430.0;
+    double _temperature = 21.0;
+    double _humidity = 45.0;
+};
+
+#endif /* INDOOR_TRACE_H */
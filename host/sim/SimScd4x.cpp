@@ -0,0 +1,258 @@
+#include "SimScd4x.h"
+
+#include "VirtualClock.h"
+
+static uint8_t crc8(const uint8_t data[], size_t count) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < count; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 8; bit > 0; --bit) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+SimScd4x::SimScd4x(SimScd4xSource& source, uint32_t seed)
+    : _source(source), _state(seed * 2654435761u + 0x6D2B79F5u) {
+    if (!_state) {
+        _state = 1;
+    }
+    _serial = _random();
+}
+
+uint32_t SimScd4x::_random() {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+}
+
+bool SimScd4x::_chance(uint16_t rate) {
+    return rate && (_random() & 0xFFFF) < rate;
+}
+
+// commands finish after 50 to 90 % of the datasheet maximum
+uint64_t SimScd4x::_executionTime(uint32_t maxUs) {
+    return maxUs / 2 + (static_cast<uint64_t>(maxUs) * (_random() % 41)) / 100;
+}
+
+void SimScd4x::_measure() {
+    if (_source.next(_co2, _temperatureTicks, _humidityTicks)) {
+        _dataReady = true;
+        _measurements++;
+    } else {
+        _exhausted = true;
+    }
+}
+
+void SimScd4x::_update() {
+    uint64_t now = VirtualClock::micros();
+
+    if (_mode == Periodic || _mode == LowPower) {
+        while (now >= _nextMeasurement && !_exhausted) {
+            _measure();
+            _nextMeasurement += _interval;
+        }
+    } else if (_mode == SingleShot && now >= _nextMeasurement) {
+        _measure();
+        _mode = Idle;
+    }
+}
+
+void SimScd4x::_respond(const uint16_t words[], uint8_t count,
+                        uint32_t maxUs) {
+    for (uint8_t i = 0; i < count; i++) {
+        _response[i] = words[i];
+    }
+    _responseWords = count;
+    _responseAt = VirtualClock::micros() + _executionTime(maxUs);
+}
+
+uint8_t SimScd4x::_execute(uint16_t command, const uint16_t args[],
+                           uint8_t count) {
+    uint64_t now = VirtualClock::micros();
+    bool idle = (_mode == Idle);
+    bool measuring = (_mode == Periodic || _mode == LowPower);
+    uint16_t words[3];
+
+    switch (command) {
+        case 0x21B1:  // start_periodic_measurement
+        case 0x21AC:  // start_low_power_periodic_measurement
+            if (!idle) {
+                return 3;
+            }
+            _mode = (command == 0x21B1) ? Periodic : LowPower;
+            _interval = (command == 0x21B1) ? 5000000 : 30000000;
+            _nextMeasurement = now + _interval;
+            _dataReady = false;
+            return 0;
+        case 0xEC05:  // read_measurement
+            if (_dataReady) {
+                words[0] = _co2;
+                words[1] = _temperatureTicks;
+                words[2] = _humidityTicks;
+                _respond(words, 3, 1000);
+                _dataReady = false;
+            }
+            return 0;
+        case 0x3F86:  // stop_periodic_measurement
+            // acknowledged in idle mode as well, like the real sensor
+            if (!measuring && !idle) {
+                return 3;
+            }
+            _mode = Idle;
+            _dataReady = false;
+            _busyUntil = now + _executionTime(500000);
+            return 0;
+        case 0xE4B8:  // get_data_ready_status
+            words[0] = _dataReady ? 0x8006 : 0x8000;
+            _respond(words, 1, 1000);
+            return 0;
+        case 0xE000:  // set_ambient_pressure
+            if (count != 1) {
+                return 3;
+            }
+            _ambientPressure = args[0];
+            return 0;
+        default:
+            break;
+    }
+
+    if (!idle) {
+        return 3;
+    }
+    switch (command) {
+        case 0x2318:  // get_temperature_offset
+            _respond(&_temperatureOffset, 1, 1000);
+            return 0;
+        case 0x241D:  // set_temperature_offset
+            _temperatureOffset = args[0];
+            return 0;
+        case 0x2322:  // get_sensor_altitude
+            _respond(&_altitude, 1, 1000);
+            return 0;
+        case 0x2427:  // set_sensor_altitude
+            _altitude = args[0];
+            return 0;
+        case 0x2313:  // get_automatic_self_calibration_enabled
+            _respond(&_asc, 1, 1000);
+            return 0;
+        case 0x2416:  // set_automatic_self_calibration_enabled
+            _asc = args[0];
+            return 0;
+        case 0x362F:  // perform_forced_recalibration
+            words[0] = 0x8000 + args[0] - _co2;
+            _respond(words, 1, 400000);
+            _busyUntil = _responseAt;
+            return 0;
+        case 0x3615:  // persist_settings
+            _persisted[0] = _temperatureOffset;
+            _persisted[1] = _altitude;
+            _persisted[2] = _asc;
+            _busyUntil = now + _executionTime(800000);
+            return 0;
+        case 0x3682:  // get_serial_number
+            words[0] = 0xB7A1;
+            words[1] = static_cast<uint16_t>(_serial >> 16);
+            words[2] = static_cast<uint16_t>(_serial);
+            _respond(words, 3, 1000);
+            return 0;
+        case 0x3639:  // perform_self_test
+            words[0] = 0;
+            _respond(words, 1, 5500000);
+            _busyUntil = _responseAt;
+            return 0;
+        case 0x3632:  // perform_factory_reset
+            _persisted[0] = _temperatureOffset = 1498;
+            _persisted[1] = _altitude = 0;
+            _persisted[2] = _asc = 1;
+            _busyUntil = now + _executionTime(800000);
+            return 0;
+        case 0x3646:  // reinit
+            _temperatureOffset = _persisted[0];
+            _altitude = _persisted[1];
+            _asc = _persisted[2];
+            _busyUntil = now + _executionTime(20000);
+            return 0;
+        case 0x219D:  // measure_single_shot
+        case 0x2196:  // measure_single_shot_rht_only
+            _mode = SingleShot;
+            _nextMeasurement =
+                now + _executionTime(command == 0x219D ? 5000000 : 50000);
+            return 0;
+        case 0x36E0:  // power_down
+            _mode = SleepMode;
+            _dataReady = false;
+            return 0;
+        default:
+            return 3;
+    }
+}
+
+uint8_t SimScd4x::onWrite(const uint8_t data[], size_t length) {
+    uint64_t now = VirtualClock::micros();
+    uint16_t args[3];
+    uint8_t count = 0;
+
+    _update();
+    if (_mode == SleepMode) {
+        // wake_up is not acknowledged either
+        if (length == 2 && data[0] == 0x36 && data[1] == 0xF6) {
+            _mode = Idle;
+            _busyUntil = now + _executionTime(20000);
+        }
+        return 2;
+    }
+    if (now < _busyUntil) {
+        return 2;
+    }
+    if (_chance(_nackRate)) {
+        _injectedFaults++;
+        return 2;
+    }
+    if (length == 0) {
+        // address probe
+        return 0;
+    }
+    if (length < 2 || (length - 2) % 3 || length > 2 + 3 * 3) {
+        return 3;
+    }
+    for (size_t i = 2; i < length; i += 3) {
+        if (crc8(&data[i], 2) != data[i + 2]) {
+            return 3;
+        }
+        args[count++] = (data[i] << 8) | data[i + 1];
+    }
+    _commands++;
+    // a new command discards an unread response
+    _responseWords = 0;
+    return _execute((data[0] << 8) | data[1], args, count);
+}
+
+size_t SimScd4x::onRead(uint8_t data[], size_t length) {
+    uint64_t now = VirtualClock::micros();
+    size_t count = 0;
+
+    _update();
+    if (_mode == SleepMode || now < _busyUntil || !_responseWords ||
+        now < _responseAt) {
+        return 0;
+    }
+    if (_chance(_nackRate)) {
+        _injectedFaults++;
+        return 0;
+    }
+    for (uint8_t i = 0; i < _responseWords && count + 3 <= length; i++) {
+        data[count] = static_cast<uint8_t>(_response[i] >> 8);
+        data[count + 1] = static_cast<uint8_t>(_response[i]);
+        data[count + 2] = crc8(&data[count], 2);
+        count += 3;
+    }
+    if (count && _chance(_crcErrorRate)) {
+        data[count - 1] ^= 0x01;
+        _injectedFaults++;
+    }
+    _responseWords = 0;
+    return count;
+}
@@ -0,0 +1,111 @@
+/*
+ * SimScd4x - Simulated SCD4x on the host Wire bus. It decodes the I2C
+ * commands the driver sends, checks their CRCs, keeps the measurement mode
+ * state and answers reads with CRC protected words like the sensor does.
+ *
+ * Measurements are taken from a SimScd4xSource every 5 s (30 s in low power
+ * mode) of virtual time. Commands take a seeded fraction of their datasheet
+ * execution time; while the sensor is busy it NACKs its address, and a
+ * measurement read without new data is NACKed as well. Optional fault
+ * injection corrupts CRCs or NACKs transactions, also from the seed, so a
+ * seed reproduces a run exactly.
+ */
+#ifndef SIM_SCD4X_H
+#define SIM_SCD4X_H
+
+#include <stdint.h>
+
+#include "Wire.h"
+
+#define SIM_SCD4X_ADDRESS 0x62
+
+/*
+ * SimScd4xSource - Supplies the raw readings the simulated sensor measures.
+ */
+class SimScd4xSource {
+  public:
+    // returns false when the trace is exhausted
+    virtual bool next(uint16_t& co2, uint16_t& temperatureTicks,
+                      uint16_t& humidityTicks) = 0;
+};
+
+class SimScd4x : public I2cDevice {
+  public:
+    SimScd4x(SimScd4xSource& source, uint32_t seed);
+
+    uint8_t onWrite(const uint8_t data[], size_t length) override;
+    size_t onRead(uint8_t data[], size_t length) override;
+
+    // probabilities in 1/65536 per transaction
+    void setFaults(uint16_t crcErrorRate, uint16_t nackRate) {
+        _crcErrorRate = crcErrorRate;
+        _nackRate = nackRate;
+    }
+
+    // no measurement left in the source
+    bool exhausted() const {
+        return _exhausted;
+    }
+
+    uint32_t measurements() const {
+        return _measurements;
+    }
+
+    uint32_t commands() const {
+        return _commands;
+    }
+
+    uint32_t injectedFaults() const {
+        return _injectedFaults;
+    }
+
+    // last set_ambient_pressure value in hPa, 0 before the first one
+    uint16_t ambientPressure() const {
+        return _ambientPressure;
+    }
+
+  private:
+    enum Mode { Idle, Periodic, LowPower, SingleShot, SleepMode };
+
+    uint32_t _random();
+    bool _chance(uint16_t rate);
+    uint64_t _executionTime(uint32_t maxUs);
+    void _update();
+    void _measure();
+    void _respond(const uint16_t words[], uint8_t count, uint32_t maxUs);
+    uint8_t _execute(uint16_t command, const uint16_t args[], uint8_t count);
+
+    SimScd4xSource& _source;
+    uint32_t _state;
+    uint32_t _serial;
+    uint16_t _crcErrorRate = 0;
+    uint16_t _nackRate = 0;
+
+    Mode _mode = Idle;
+    uint64_t _busyUntil = 0;
+    uint64_t _nextMeasurement = 0;
+    uint32_t _interval = 0;
+    bool _dataReady = false;
+    bool _exhausted = false;
+    uint16_t _co2 = 0;
+    uint16_t _temperatureTicks = 0;
+    uint16_t _humidityTicks = 0;
+
+    // settings as RAM / EEPROM copy
+    uint16_t _temperatureOffset = 1498;  // 4 °C
+    uint16_t _altitude = 0;
+    uint16_t _asc = 1;
+    uint16_t _ambientPressure = 0;
+    uint16_t _persisted[3] = {1498, 0, 1};
+
+    // response of the last read command, valid from _responseAt
+    uint16_t _response[3];
+    uint8_t _responseWords = 0;
+    uint64_t _responseAt = 0;
+
+    uint32_t _measurements = 0;
+    uint32_t _commands = 0;
+    uint32_t _injectedFaults = 0;
+};
+
+#endif /* SIM_SCD4X_H */
@@ -0,0 +1,195 @@
+#include "SimSsd1306.h"
+
+#include "VirtualClock.h"
+#include "clib/u8g.h"
+
+SimSsd1306& SimSsd1306::instance() {
+    static SimSsd1306 display;
+    return display;
+}
+
+void SimSsd1306::reset() {
+    SimSsd1306 cleared(_byteUs);
+
+    cleared._commands = _commands;
+    cleared._dataBytes = _dataBytes;
+    cleared._resets = _resets + 1;
+    // the display RAM is not cleared by a reset
+    for (uint8_t page = 0; page < SIM_SSD1306_PAGES; page++) {
+        for (uint8_t column = 0; column < SIM_SSD1306_WIDTH; column++) {
+            cleared._ram[page][column] = _ram[page][column];
+        }
+    }
+    *this = cleared;
+}
+
+// number of argument bytes following a command byte
+static uint8_t argumentCount(uint8_t command) {
+    switch (command) {
+        case 0x20:  // memory addressing mode
+        case 0x81:  // contrast
+        case 0x8D:  // charge pump
+        case 0xA8:  // multiplex ratio
+        case 0xD3:  // display offset
+        case 0xD5:  // clock divide
+        case 0xD9:  // pre-charge period
+        case 0xDA:  // COM pins
+        case 0xDB:  // VCOMH level
+            return 1;
+        case 0x21:  // column range
+        case 0x22:  // page range
+        case 0xA3:  // vertical scroll area
+            return 2;
+        case 0x29:  // vertical and horizontal scroll setup
+        case 0x2A:
+            return 5;
+        case 0x26:  // horizontal scroll setup
+        case 0x27:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+void SimSsd1306::command(uint8_t byte) {
+    VirtualClock::advance(_byteUs);
+    if (_arguments) {
+        _argument[_received++] = byte;
+        if (--_arguments) {
+            return;
+        }
+        switch (_command) {
+            case 0x20:
+                _addressing = _argument[0] & 0x03;
+                break;
+            case 0x21:
+                _columnStart = _argument[0] & 0x7F;
+                _columnEnd = _argument[1] & 0x7F;
+                _column = _columnStart;
+                break;
+            case 0x22:
+                _pageStart = _argument[0] & 0x07;
+                _pageEnd = _argument[1] & 0x07;
+                _page = _pageStart;
+                break;
+        }
+        return;
+    }
+
+    _commands++;
+    if (byte < 0x10) {
+        _column = (_column & 0xF0) | byte;
+    } else if (byte < 0x20) {
+        _column = (_column & 0x0F) | ((byte & 0x07) << 4);
+    } else if (byte >= 0xB0 && byte <= 0xB7) {
+        _page = byte & 0x07;
+    } else if (byte == 0xA0 || byte == 0xA1) {
+        _segmentRemap = byte & 0x01;
+    } else if (byte == 0xC0 || byte == 0xC8) {
+        _comReverse = byte & 0x08;
+    } else if (byte == 0xAE || byte == 0xAF) {
+        _displayOn = byte & 0x01;
+    } else {
+        _command = byte;
+        _arguments = argumentCount(byte);
+        _received = 0;
+    }
+}
+
+void SimSsd1306::data(uint8_t byte) {
+    VirtualClock::advance(_byteUs);
+    _dataBytes++;
+    _ram[_page][_column] = byte;
+
+    if (_addressing == 2) {
+        // page addressing wraps within the page
+        _column = (_column + 1) & 0x7F;
+    } else if (_addressing == 0) {
+        if (_column == _columnEnd) {
+            _column = _columnStart;
+            _page = (_page == _pageEnd) ? _pageStart : _page + 1;
+        } else {
+            _column++;
+        }
+    } else {
+        if (_page == _pageEnd) {
+            _page = _pageStart;
+            _column = (_column == _columnEnd) ? _columnStart : _column + 1;
+        } else {
+            _page++;
+        }
+    }
+}
+
+// the usual 128x64 modules mount the glass turned by 180 degrees: with
+// segment remap and reversed COM scan, column 0 of page 0 is top left
+bool SimSsd1306::pixel(uint8_t x, uint8_t y) const {
+    uint8_t column = _segmentRemap ? x : SIM_SSD1306_WIDTH - 1 - x;
+    uint8_t row = _comReverse ? y : SIM_SSD1306_PAGES * 8 - 1 - y;
+
+    return _displayOn && (_ram[row / 8][column] >> (row % 8) & 0x01);
+}
+
+void SimSsd1306::writePbm(FILE* file) const {
+    fprintf(file, "P1\n%d %d\n", SIM_SSD1306_WIDTH, SIM_SSD1306_PAGES * 8);
+    for (uint8_t y = 0; y < SIM_SSD1306_PAGES * 8; y++) {
+        for (uint8_t x = 0; x < SIM_SSD1306_WIDTH; x++) {
+            fputc(pixel(x, y) ? '1' : '0', file);
+        }
+        fputc('\n', file);
+    }
+}
+
+// two rows per text line, drawn with half block characters
+void SimSsd1306::printText(FILE* file) const {
+    static const char* const blocks[] = {" ", "▀", "▄", "█"};
+
+    for (uint8_t y = 0; y < SIM_SSD1306_PAGES * 8; y += 2) {
+        for (uint8_t x = 0; x < SIM_SSD1306_WIDTH; x++) {
+            fputs(blocks[pixel(x, y) | pixel(x, y + 1) << 1], file);
+        }
+        fputc('\n', file);
+    }
+}
+
+/*
+ * U8glib's software SPI com procedure for host builds, in place of
+ * u8g_com_arduino_sw_spi.c: the bytes go to the simulated controller. The
+ * sketches wire the display reset to their own pin, so U8glib's reset
+ * messages go nowhere, as on the board.
+ */
+uint8_t u8g_com_arduino_sw_spi_fn(u8g_t*, uint8_t msg, uint8_t arg_val,
+                                  void* arg_ptr) {
+    SimSsd1306& display = SimSsd1306::instance();
+    static bool dataMode = false;
+    const uint8_t* bytes = static_cast<const uint8_t*>(arg_ptr);
+
+    switch (msg) {
+        case U8G_COM_MSG_ADDRESS:
+            dataMode = arg_val;
+            break;
+        case U8G_COM_MSG_WRITE_BYTE:
+            dataMode ? display.data(arg_val) : display.command(arg_val);
+            break;
+        case U8G_COM_MSG_WRITE_SEQ:
+        case U8G_COM_MSG_WRITE_SEQ_P:
+            for (uint8_t i = 0; i < arg_val; i++) {
+                dataMode ? display.data(bytes[i]) : display.command(bytes[i]);
+            }
+            break;
+    }
+    return 1;
+}
+
+// U8glib delays on the virtual clock, in place of u8g_delay.c
+void u8g_Delay(uint16_t val) {
+    VirtualClock::advance(val * 1000ULL);
+}
+
+void u8g_MicroDelay(void) {
+    VirtualClock::advance(1);
+}
+
+void u8g_10MicroDelay(void) {
+    VirtualClock::advance(10);
+}
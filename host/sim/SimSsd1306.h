@@ -0,0 +1,81 @@
+/*
+ * SimSsd1306 - Simulated SSD1306 128x64 OLED controller. It decodes the
+ * command and data stream U8glib sends and keeps the display RAM, so a
+ * sketch's drawing ends up in a framebuffer which can be saved as PBM or
+ * printed as text.
+ *
+ * Page and horizontal addressing, column / page start and range commands,
+ * segment remap and COM scan direction are modelled; scrolling, start line
+ * and display offset are accepted and ignored. Every byte costs `byteUs`
+ * of virtual time, the software SPI transfer time on the board.
+ */
+#ifndef SIM_SSD1306_H
+#define SIM_SSD1306_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SIM_SSD1306_WIDTH 128
+#define SIM_SSD1306_PAGES 8
+
+class SimSsd1306 {
+  public:
+    explicit SimSsd1306(uint32_t byteUs = 5) : _byteUs(byteUs) {
+    }
+
+    // the controller U8glib's software SPI talks to
+    static SimSsd1306& instance();
+
+    void reset();
+    void command(uint8_t byte);
+    void data(uint8_t byte);
+
+    void setByteTime(uint32_t byteUs) {
+        _byteUs = byteUs;
+    }
+
+    // pixel as seen on the panel, with remap and scan direction applied
+    bool pixel(uint8_t x, uint8_t y) const;
+
+    void writePbm(FILE* file) const;
+    void printText(FILE* file) const;
+
+    bool displayOn() const {
+        return _displayOn;
+    }
+
+    uint32_t commands() const {
+        return _commands;
+    }
+
+    uint32_t dataBytes() const {
+        return _dataBytes;
+    }
+
+    uint32_t resets() const {
+        return _resets;
+    }
+
+  private:
+    uint8_t _ram[SIM_SSD1306_PAGES][SIM_SSD1306_WIDTH] = {};
+    uint32_t _byteUs;
+    uint8_t _page = 0;
+    uint8_t _column = 0;
+    uint8_t _columnStart = 0;
+    uint8_t _columnEnd = SIM_SSD1306_WIDTH - 1;
+    uint8_t _pageStart = 0;
+    uint8_t _pageEnd = SIM_SSD1306_PAGES - 1;
+    uint8_t _addressing = 2;  // 0 horizontal, 1 vertical, 2 page
+    uint8_t _command = 0;     // command waiting for arguments
+    uint8_t _arguments = 0;   // arguments still expected
+    uint8_t _argument[6] = {};
+    uint8_t _received = 0;
+    bool _segmentRemap = false;
+    bool _comReverse = false;
+    bool _displayOn = false;
+    uint32_t _commands = 0;
+    uint32_t _dataBytes = 0;
+    uint32_t _resets = 0;
+};
+
+#endif /* SIM_SSD1306_H */
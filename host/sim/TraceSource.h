@@ -0,0 +1,68 @@
+/*
+ * TraceSource - SimScd4xSource implementations: a synthetic IndoorTrace of a
+ * given length, or a recorded raw tick log. Tick logs are CSV lines
+ *
+ *     timestamp_ms,co2,temperature_ticks,humidity_ticks
+ *
+ * with '#' comment lines. The timestamps are kept for reference only; the
+ * simulated sensor serves one line per measurement interval.
+ */
+#ifndef TRACE_SOURCE_H
+#define TRACE_SOURCE_H
+
+#include <stdio.h>
+
+#include "IndoorTrace.h"
+#include "SimScd4x.h"
+
+class IndoorTraceSource : public SimScd4xSource {
+  public:
+    IndoorTraceSource(IndoorScenario scenario, uint32_t seed, uint32_t count,
+                      double intervalSeconds = 5)
+        : _trace(scenario, seed), _left(count), _interval(intervalSeconds) {
+    }
+
+    bool next(uint16_t& co2, uint16_t& temperatureTicks,
+              uint16_t& humidityTicks) override {
+        if (!_left) {
+            return false;
+        }
+        _left--;
+        _trace.step(_interval, co2, temperatureTicks, humidityTicks);
+        return true;
+    }
+
+  private:
+    IndoorTrace _trace;
+    uint32_t _left;
+    double _interval;
+};
+
+class CsvTraceSource : public SimScd4xSource {
+  public:
+    explicit CsvTraceSource(FILE* file) : _file(file) {
+    }
+
+    bool next(uint16_t& co2, uint16_t& temperatureTicks,
+              uint16_t& humidityTicks) override {
+        char line[128];
+        unsigned long timestamp;
+        unsigned int c, t, h;
+
+        while (fgets(line, sizeof(line), _file)) {
+            if (line[0] != '#' &&
+                sscanf(line, "%lu,%u,%u,%u", &timestamp, &c, &t, &h) == 4) {
+                co2 = static_cast<uint16_t>(c);
+                temperatureTicks = static_cast<uint16_t>(t);
+                humidityTicks = static_cast<uint16_t>(h);
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    FILE* _file;
+};
+
+#endif /* TRACE_SOURCE_H */
@@ -0,0 +1,116 @@
+/*
+ * u8g_host_font.c - Stand-in for the U8glib fonts the sketches use, for
+ * host builds. The U8glib copy in this repository comes without the font
+ * data (u8g_font_data.c), so u8g_font_9x18B and u8g_font_unifont both map
+ * to this classic 5x8 ASCII font in U8glib's format 0. Text is smaller than
+ * on the display, but takes the same path through U8glib.
+ */
+#include "clib/u8g.h"
+
+/*
+ * font header, see u8g_font.c: format, bounding box width, height, x and y
+ * offset, capital A height, no index for 'A' and 'a', encodings 32 to 126,
+ * descent of 'g', ascent, descent, x ascent, x descent
+ */
+const u8g_fntpgm_uint8_t u8g_font_9x18B[] = {
+    0, 5, 8, 0, -1, 7, 0, 0, 0, 0, 32, 126, -1, 7, -1, 5, -1,
+    /* glyphs: width, height, data size, advance, x and y offset, rows */
+    /* ' ' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* '!' */ 5, 8, 8, 6, 0, -1, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x20, 0x00,
+    /* '"' */ 5, 8, 8, 6, 0, -1, 0x50, 0x50, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* '#' */ 5, 8, 8, 6, 0, -1, 0x50, 0x50, 0xF8, 0x50, 0xF8, 0x50, 0x50, 0x00,
+    /* '$' */ 5, 8, 8, 6, 0, -1, 0x20, 0x78, 0xA0, 0x70, 0x28, 0xF0, 0x20, 0x00,
+    /* '%' */ 5, 8, 8, 6, 0, -1, 0xC0, 0xC8, 0x10, 0x20, 0x40, 0x98, 0x18, 0x00,
+    /* '&' */ 5, 8, 8, 6, 0, -1, 0x40, 0xA0, 0xA0, 0x40, 0xA8, 0x90, 0x68, 0x00,
+    /* ''' */ 5, 8, 8, 6, 0, -1, 0x30, 0x30, 0x20, 0x40, 0x00, 0x00, 0x00, 0x00,
+    /* '(' */ 5, 8, 8, 6, 0, -1, 0x10, 0x20, 0x40, 0x40, 0x40, 0x20, 0x10, 0x00,
+    /* ')' */ 5, 8, 8, 6, 0, -1, 0x40, 0x20, 0x10, 0x10, 0x10, 0x20, 0x40, 0x00,
+    /* '*' */ 5, 8, 8, 6, 0, -1, 0x20, 0xA8, 0x70, 0xF8, 0x70, 0xA8, 0x20, 0x00,
+    /* '+' */ 5, 8, 8, 6, 0, -1, 0x00, 0x20, 0x20, 0xF8, 0x20, 0x20, 0x00, 0x00,
+    /* ',' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x20, 0x40,
+    /* '-' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x00, 0xF8, 0x00, 0x00, 0x00, 0x00,
+    /* '.' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x00,
+    /* '/' */ 5, 8, 8, 6, 0, -1, 0x00, 0x08, 0x10, 0x20, 0x40, 0x80, 0x00, 0x00,
+    /* '0' */ 5, 8, 8, 6, 0, -1, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    /* '1' */ 5, 8, 8, 6, 0, -1, 0x20, 0x60, 0x20, 0x20, 0x20, 0x20, 0x70, 0x00,
+    /* '2' */ 5, 8, 8, 6, 0, -1, 0x70, 0x88, 0x08, 0x70, 0x80, 0x80, 0xF8, 0x00,
+    /* '3' */ 5, 8, 8, 6, 0, -1, 0xF8, 0x08, 0x10, 0x30, 0x08, 0x88, 0x70, 0x00,
+    /* '4' */ 5, 8, 8, 6, 0, -1, 0x10, 0x30, 0x50, 0x90, 0xF8, 0x10, 0x10, 0x00,
+    /* '5' */ 5, 8, 8, 6, 0, -1, 0xF8, 0x80, 0xF0, 0x08, 0x08, 0x88, 0x70, 0x00,
+    /* '6' */ 5, 8, 8, 6, 0, -1, 0x38, 0x40, 0x80, 0xF0, 0x88, 0x88, 0x70, 0x00,
+    /* '7' */ 5, 8, 8, 6, 0, -1, 0xF8, 0x08, 0x08, 0x10, 0x20, 0x40, 0x80, 0x00,
+    /* '8' */ 5, 8, 8, 6, 0, -1, 0x70, 0x88, 0x88, 0x70, 0x88, 0x88, 0x70, 0x00,
+    /* '9' */ 5, 8, 8, 6, 0, -1, 0x70, 0x88, 0x88, 0x78, 0x08, 0x10, 0xE0, 0x00,
+    /* ':' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x20, 0x00, 0x20, 0x00, 0x00, 0x00,
+    /* ';' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x20, 0x00, 0x20, 0x20, 0x40, 0x00,
+    /* '<' */ 5, 8, 8, 6, 0, -1, 0x08, 0x10, 0x20, 0x40, 0x20, 0x10, 0x08, 0x00,
+    /* '=' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0xF8, 0x00, 0xF8, 0x00, 0x00, 0x00,
+    /* '>' */ 5, 8, 8, 6, 0, -1, 0x40, 0x20, 0x10, 0x08, 0x10, 0x20, 0x40, 0x00,
+    /* '?' */ 5, 8, 8, 6, 0, -1, 0x70, 0x88, 0x08, 0x30, 0x20, 0x00, 0x20, 0x00,
+    /* '@' */ 5, 8, 8, 6, 0, -1, 0x70, 0x88, 0xA8, 0xB8, 0xB0, 0x80, 0x78, 0x00,
+    /* 'A' */ 5, 8, 8, 6, 0, -1, 0x20, 0x50, 0x88, 0x88, 0xF8, 0x88, 0x88, 0x00,
+    /* 'B' */ 5, 8, 8, 6, 0, -1, 0xF0, 0x88, 0x88, 0xF0, 0x88, 0x88, 0xF0, 0x00,
+    /* 'C' */ 5, 8, 8, 6, 0, -1, 0x70, 0x88, 0x80, 0x80, 0x80, 0x88, 0x70, 0x00,
+    /* 'D' */ 5, 8, 8, 6, 0, -1, 0xF0, 0x88, 0x88, 0x88, 0x88, 0x88, 0xF0, 0x00,
+    /* 'E' */ 5, 8, 8, 6, 0, -1, 0xF8, 0x80, 0x80, 0xF0, 0x80, 0x80, 0xF8, 0x00,
+    /* 'F' */ 5, 8, 8, 6, 0, -1, 0xF8, 0x80, 0x80, 0xF0, 0x80, 0x80, 0x80, 0x00,
+    /* 'G' */ 5, 8, 8, 6, 0, -1, 0x78, 0x88, 0x80, 0x80, 0x98, 0x88, 0x78, 0x00,
+    /* 'H' */ 5, 8, 8, 6, 0, -1, 0x88, 0x88, 0x88, 0xF8, 0x88, 0x88, 0x88, 0x00,
+    /* 'I' */ 5, 8, 8, 6, 0, -1, 0x70, 0x20, 0x20, 0x20, 0x20, 0x20, 0x70, 0x00,
+    /* 'J' */ 5, 8, 8, 6, 0, -1, 0x38, 0x10, 0x10, 0x10, 0x10, 0x90, 0x60, 0x00,
+    /* 'K' */ 5, 8, 8, 6, 0, -1, 0x88, 0x90, 0xA0, 0xC0, 0xA0, 0x90, 0x88, 0x00,
+    /* 'L' */ 5, 8, 8, 6, 0, -1, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0xF8, 0x00,
+    /* 'M' */ 5, 8, 8, 6, 0, -1, 0x88, 0xD8, 0xA8, 0xA8, 0xA8, 0x88, 0x88, 0x00,
+    /* 'N' */ 5, 8, 8, 6, 0, -1, 0x88, 0x88, 0xC8, 0xA8, 0x98, 0x88, 0x88, 0x00,
+    /* 'O' */ 5, 8, 8, 6, 0, -1, 0x70, 0x88, 0x88, 0x88, 0x88, 0x88, 0x70, 0x00,
+    /* 'P' */ 5, 8, 8, 6, 0, -1, 0xF0, 0x88, 0x88, 0xF0, 0x80, 0x80, 0x80, 0x00,
+    /* 'Q' */ 5, 8, 8, 6, 0, -1, 0x70, 0x88, 0x88, 0x88, 0xA8, 0x90, 0x68, 0x00,
+    /* 'R' */ 5, 8, 8, 6, 0, -1, 0xF0, 0x88, 0x88, 0xF0, 0xA0, 0x90, 0x88, 0x00,
+    /* 'S' */ 5, 8, 8, 6, 0, -1, 0x70, 0x88, 0x80, 0x70, 0x08, 0x88, 0x70, 0x00,
+    /* 'T' */ 5, 8, 8, 6, 0, -1, 0xF8, 0xA8, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00,
+    /* 'U' */ 5, 8, 8, 6, 0, -1, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x70, 0x00,
+    /* 'V' */ 5, 8, 8, 6, 0, -1, 0x88, 0x88, 0x88, 0x88, 0x88, 0x50, 0x20, 0x00,
+    /* 'W' */ 5, 8, 8, 6, 0, -1, 0x88, 0x88, 0x88, 0xA8, 0xA8, 0xA8, 0x50, 0x00,
+    /* 'X' */ 5, 8, 8, 6, 0, -1, 0x88, 0x88, 0x50, 0x20, 0x50, 0x88, 0x88, 0x00,
+    /* 'Y' */ 5, 8, 8, 6, 0, -1, 0x88, 0x88, 0x50, 0x20, 0x20, 0x20, 0x20, 0x00,
+    /* 'Z' */ 5, 8, 8, 6, 0, -1, 0xF8, 0x08, 0x10, 0x70, 0x40, 0x80, 0xF8, 0x00,
+    /* '[' */ 5, 8, 8, 6, 0, -1, 0x78, 0x40, 0x40, 0x40, 0x40, 0x40, 0x78, 0x00,
+    /* '\' */ 5, 8, 8, 6, 0, -1, 0x00, 0x80, 0x40, 0x20, 0x10, 0x08, 0x00, 0x00,
+    /* ']' */ 5, 8, 8, 6, 0, -1, 0x78, 0x08, 0x08, 0x08, 0x08, 0x08, 0x78, 0x00,
+    /* '^' */ 5, 8, 8, 6, 0, -1, 0x20, 0x50, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00,
+    /* '_' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x00,
+    /* '`' */ 5, 8, 8, 6, 0, -1, 0x60, 0x60, 0x20, 0x10, 0x00, 0x00, 0x00, 0x00,
+    /* 'a' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x60, 0x10, 0x70, 0x90, 0x78, 0x00,
+    /* 'b' */ 5, 8, 8, 6, 0, -1, 0x80, 0x80, 0xB0, 0xC8, 0x88, 0xC8, 0xB0, 0x00,
+    /* 'c' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x70, 0x88, 0x80, 0x88, 0x70, 0x00,
+    /* 'd' */ 5, 8, 8, 6, 0, -1, 0x08, 0x08, 0x68, 0x98, 0x88, 0x98, 0x68, 0x00,
+    /* 'e' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x70, 0x88, 0xF8, 0x80, 0x70, 0x00,
+    /* 'f' */ 5, 8, 8, 6, 0, -1, 0x10, 0x28, 0x20, 0x70, 0x20, 0x20, 0x20, 0x00,
+    /* 'g' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x70, 0x98, 0x98, 0x68, 0x08, 0x70,
+    /* 'h' */ 5, 8, 8, 6, 0, -1, 0x80, 0x80, 0xB0, 0xC8, 0x88, 0x88, 0x88, 0x00,
+    /* 'i' */ 5, 8, 8, 6, 0, -1, 0x20, 0x00, 0x60, 0x20, 0x20, 0x20, 0x70, 0x00,
+    /* 'j' */ 5, 8, 8, 6, 0, -1, 0x10, 0x00, 0x10, 0x10, 0x10, 0x90, 0x60, 0x00,
+    /* 'k' */ 5, 8, 8, 6, 0, -1, 0x80, 0x80, 0x90, 0xA0, 0xC0, 0xA0, 0x90, 0x00,
+    /* 'l' */ 5, 8, 8, 6, 0, -1, 0x60, 0x20, 0x20, 0x20, 0x20, 0x20, 0x70, 0x00,
+    /* 'm' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0xD0, 0xA8, 0xA8, 0xA8, 0xA8, 0x00,
+    /* 'n' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0xB0, 0xC8, 0x88, 0x88, 0x88, 0x00,
+    /* 'o' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x70, 0x88, 0x88, 0x88, 0x70, 0x00,
+    /* 'p' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0xB0, 0xC8, 0xC8, 0xB0, 0x80, 0x80,
+    /* 'q' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x68, 0x98, 0x98, 0x68, 0x08, 0x08,
+    /* 'r' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0xB0, 0xC8, 0x80, 0x80, 0x80, 0x00,
+    /* 's' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x78, 0x80, 0x70, 0x08, 0xF0, 0x00,
+    /* 't' */ 5, 8, 8, 6, 0, -1, 0x20, 0x20, 0xF8, 0x20, 0x20, 0x28, 0x10, 0x00,
+    /* 'u' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x88, 0x88, 0x88, 0x98, 0x68, 0x00,
+    /* 'v' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x88, 0x88, 0x88, 0x50, 0x20, 0x00,
+    /* 'w' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x88, 0x88, 0xA8, 0xA8, 0x50, 0x00,
+    /* 'x' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x88, 0x50, 0x20, 0x50, 0x88, 0x00,
+    /* 'y' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0x88, 0x88, 0x78, 0x08, 0x88, 0x70,
+    /* 'z' */ 5, 8, 8, 6, 0, -1, 0x00, 0x00, 0xF8, 0x10, 0x20, 0x40, 0xF8, 0x00,
+    /* '{' */ 5, 8, 8, 6, 0, -1, 0x10, 0x20, 0x20, 0x40, 0x20, 0x20, 0x10, 0x00,
+    /* '|' */ 5, 8, 8, 6, 0, -1, 0x20, 0x20, 0x20, 0x00, 0x20, 0x20, 0x20, 0x00,
+    /* '}' */ 5, 8, 8, 6, 0, -1, 0x40, 0x20, 0x20, 0x10, 0x20, 0x20, 0x40, 0x00,
+    /* '~' */ 5, 8, 8, 6, 0, -1, 0x40, 0xA8, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+extern const u8g_fntpgm_uint8_t u8g_font_unifont[sizeof(u8g_font_9x18B)]
+    __attribute__((alias("u8g_font_9x18B")));
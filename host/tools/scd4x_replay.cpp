@@ -0,0 +1,315 @@
+/*
+ * scd4x_replay - Replays a raw tick log or a synthetic trace through the real
+ * SensirionI2CScd4x / SensirionI2CCommunication code on the simulated bus and
+ * virtual clock, feeding the same sample ring, outlier filter and window
+ * statistics as Test_SCD40_v4. A month of 5 s samples runs in seconds.
+ *
+ * The run is fully determined by the input and the seed; the printed digest
+ * covers every sample, its flags and the statistics, so two runs can be
+ * compared for regressions by their digest alone.
+ *
+ * Usage: scd4x_replay [-i log.csv] [-d days] [-S scenario] [-s seed]
+ *                     [-p pollMs] [-c crcPer64k] [-n nackPer64k]
+ *                     [-o out.csv] [-t out.bin] [-v]
+ *
+ *   -i  replay a tick log instead of a synthetic trace
+ *   -d  length of the synthetic trace in days (default 30)
+ *   -S  office, bedroom or classroom (default office)
+ *   -s  seed for trace, sensor timing and faults (default 1)
+ *   -p  data ready polling interval (default 1000 ms)
+ *   -c  injected CRC errors and -n NACKs per 65536 transactions, whole
+ *       numbers from 0 to 65535 (e.g. 655 for 1 %)
+ *   -o  write every read sample as tick log
+ *   -t  write every read sample, with its flags, and every read error as
+ *       binary telemetry frames (Scd4xTelemetry.h) like the sketches
+ *   -v  print the STAT> lines of the sketch
+ */
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "Scd4xMemory.h"
+#include "Scd4xOutlierFilter.h"
+#include "Scd4xSampleRing.h"
+#include "Scd4xTelemetry.h"
+#include "Scd4xWindowStats.h"
+#include "SensirionI2CScd4x.h"
+#include "SimScd4x.h"
+#include "TraceSource.h"
+#include "Wire.h"
+
+// FNV-1a over everything the pipeline produces
+class Digest {
+  public:
+    void add(const void* data, size_t length) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < length; i++) {
+            _hash = (_hash ^ bytes[i]) * 0x100000001B3ULL;
+        }
+    }
+
+    template <typename T> void add(T value) {
+        add(&value, sizeof(value));
+    }
+
+    uint64_t value() const {
+        return _hash;
+    }
+
+  private:
+    uint64_t _hash = 0xCBF29CE484222325ULL;
+};
+
+static void addAggregate(Digest& digest, const Scd4xAggregate& aggregate) {
+    digest.add(aggregate.count);
+    if (aggregate.count) {
+        digest.add(aggregate.min);
+        digest.add(aggregate.max);
+        digest.add(aggregate.sum);
+    }
+}
+
+// fault rate per 65536 transactions, the whole argument must be a number
+static bool parseRate(const char* text, uint16_t& rate) {
+    char* end;
+    unsigned long value = strtoul(text, &end, 10);
+
+    if (!*text || *end || value > 0xFFFF) {
+        fprintf(stderr, "invalid rate '%s', expected 0 to 65535 per 65536 "
+                        "transactions\n",
+                text);
+        return false;
+    }
+    rate = static_cast<uint16_t>(value);
+    return true;
+}
+
+static float identity(float value) {
+    return value;
+}
+
+static void addStats(Digest& digest, const char* name,
+                     const Scd4xWindowStats& stats, float (*toUnit)(float),
+                     bool verbose) {
+    Scd4xAggregate minute, quarter, hour;
+
+    stats.minute(minute);
+    stats.quarterHour(quarter);
+    stats.hour(hour);
+    addAggregate(digest, minute);
+    addAggregate(digest, quarter);
+    addAggregate(digest, hour);
+    if (verbose) {
+        printf("STAT> %lu %s 1m %.2f 15m %.2f 1h %.2f\n", millis(), name,
+               toUnit(minute.mean()), toUnit(quarter.mean()),
+               toUnit(hour.mean()));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* input = nullptr;
+    const char* output = nullptr;
+    const char* telemetry = nullptr;
+    double days = 30;
+    IndoorScenario scenario = ScenarioOffice;
+    uint32_t seed = 1;
+    uint32_t pollMs = 1000;
+    uint16_t crcErrorRate = 0;
+    uint16_t nackRate = 0;
+    bool verbose = false;
+    int option;
+
+    // the same stack and heap probes as on the boards
+    Scd4xMemory::paintStack();
+
+    while ((option = getopt(argc, argv, "i:d:S:s:p:c:n:o:t:v")) != -1) {
+        switch (option) {
+            case 'i':
+                input = optarg;
+                break;
+            case 'd':
+                days = atof(optarg);
+                break;
+            case 'S':
+                scenario = !strcmp(optarg, "bedroom")     ? ScenarioBedroom
+                           : !strcmp(optarg, "classroom") ? ScenarioClassroom
+                                                          : ScenarioOffice;
+                break;
+            case 's':
+                seed = strtoul(optarg, nullptr, 0);
+                break;
+            case 'p':
+                pollMs = strtoul(optarg, nullptr, 0);
+                break;
+            case 'c':
+                if (!parseRate(optarg, crcErrorRate)) {
+                    return 2;
+                }
+                break;
+            case 'n':
+                if (!parseRate(optarg, nackRate)) {
+                    return 2;
+                }
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            case 't':
+                telemetry = optarg;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-i log.csv] [-d days] "
+                                "[-S scenario] [-s seed] [-p pollMs] "
+                                "[-c crcPer64k] [-n nackPer64k] "
+                                "[-o out.csv] [-t out.bin] [-v]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    FILE* inputFile = input ? fopen(input, "r") : nullptr;
+    FILE* outputFile = output ? fopen(output, "w") : nullptr;
+    FILE* telemetryFile = telemetry ? fopen(telemetry, "wb") : nullptr;
+    if ((input && !inputFile) || (output && !outputFile)) {
+        perror(input && !inputFile ? input : output);
+        return 1;
+    }
+    if (telemetry && !telemetryFile) {
+        perror(telemetry);
+        return 1;
+    }
+    IndoorTraceSource synthetic(scenario, seed,
+                                static_cast<uint32_t>(days * 86400 / 5));
+    CsvTraceSource recorded(inputFile);
+    SimScd4xSource& source =
+        inputFile ? static_cast<SimScd4xSource&>(recorded) : synthetic;
+
+    VirtualClock::reset();
+    SimScd4x sensor(source, seed);
+    sensor.setFaults(crcErrorRate, nackRate);
+    Wire.attach(SIM_SCD4X_ADDRESS, &sensor);
+
+    static Scd4xSample ringBuffer[8];
+    Scd4xSampleRing sampleRing(ringBuffer, 8);
+    Scd4xSampleFilter<> sampleFilter;
+    Scd4xMeasurementStats stats;
+    SensirionI2CScd4x scd4x;
+    Scd4xTelemetryEncoder telemetryEncoder;
+    uint8_t frame[SCD4X_TELEMETRY_MAX_FRAME];
+    Digest digest;
+    uint32_t samples = 0, rejected = 0, errors = 0;
+    uint32_t flagCounts[4] = {};
+    unsigned long lastStats = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    Wire.begin();
+    scd4x.begin(Wire);
+    scd4x.attachSampleRing(&sampleRing);
+    scd4x.stopPeriodicMeasurement();
+    if (scd4x.startPeriodicMeasurement()) {
+        fprintf(stderr, "startPeriodicMeasurement failed\n");
+        return 1;
+    }
+
+    while (!sensor.exhausted()) {
+        uint16_t dataReady;
+        uint16_t co2, temperature, humidity;
+
+        delay(pollMs);
+        if (scd4x.getDataReadyStatus(dataReady)) {
+            errors++;
+            continue;
+        }
+        if (!(dataReady & 0x07FF)) {
+            continue;
+        }
+        uint16_t error =
+            scd4x.readMeasurementTicks(co2, temperature, humidity);
+        if (error) {
+            errors++;
+            if (telemetryFile) {
+                fwrite(frame, 1,
+                       telemetryEncoder.encodeError(millis(), error, frame),
+                       telemetryFile);
+            }
+        }
+
+        Scd4xSample sample;
+        while (sampleRing.pop(sample)) {
+            if (!sampleFilter.apply(sample)) {
+                rejected++;
+            }
+            for (uint8_t bit = 0; bit < 4; bit++) {
+                flagCounts[bit] += (sample.flags >> bit) & 1;
+            }
+            stats.add(sample);
+            samples++;
+            digest.add(sample.timestamp);
+            digest.add(sample.co2);
+            digest.add(sample.temperatureTicks);
+            digest.add(sample.humidityTicks);
+            digest.add(sample.flags);
+            if (outputFile) {
+                fprintf(outputFile, "%u,%u,%u,%u\n", sample.timestamp,
+                        sample.co2, sample.temperatureTicks,
+                        sample.humidityTicks);
+            }
+            if (telemetryFile) {
+                fwrite(frame, 1, telemetryEncoder.encodeSample(sample, frame),
+                       telemetryFile);
+            }
+        }
+        if (millis() - lastStats >= 60000) {
+            lastStats = millis();
+            stats.expire(lastStats);
+            addStats(digest, "CO2", stats.co2, identity, verbose);
+            addStats(digest, "TMP", stats.temperature,
+                     Scd4xMeasurementStats::toTemperature, verbose);
+            addStats(digest, "HUM", stats.humidity,
+                     Scd4xMeasurementStats::toHumidity, verbose);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double wall = std::chrono::duration<double>(end - start).count();
+    double simulated = VirtualClock::micros() / 1e6;
+    printf("simulated   %.1f days, %u measurements, %u commands, "
+           "%u transactions\n",
+           simulated / 86400, sensor.measurements(), sensor.commands(),
+           Wire.transactions());
+    printf("samples     %u read, %u rejected (invalid %u, overrun %u, "
+           "outlier %u, rate %u)\n",
+           samples, rejected, flagCounts[0], flagCounts[1], flagCounts[2],
+           flagCounts[3]);
+    printf("bus errors  %u, injected faults %u\n", errors,
+           sensor.injectedFaults());
+    printf("wall time   %.3f s, %.0fx real time, %.2f us per sample\n", wall,
+           simulated / wall, samples ? wall * 1e6 / samples : 0.0);
+    printf("digest      %016llx\n",
+           static_cast<unsigned long long>(digest.value()));
+    if (verbose) {
+        Scd4xHeapStats heap;
+        Scd4xMemory::heapStats(heap);
+        printf("memory      stack high water %zu B, static %zu B, "
+               "heap %zu B\n",
+               Scd4xMemory::stackHighWater(), Scd4xMemory::staticRam(),
+               heap.heapSize);
+    }
+
+    if (inputFile) {
+        fclose(inputFile);
+    }
+    if (outputFile) {
+        fclose(outputFile);
+    }
+    if (telemetryFile) {
+        fclose(telemetryFile);
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * scd4x_shm_read - Reads the samples scd4xd publishes in shared memory and
+ * prints them as CSV: index, wall clock in us, CO2 in ppm, temperature in
+ * °C, humidity in %RH and the sample flags.
+ *
+ * Usage: scd4x_shm_read [-m name] [-n last] [-f] [-p pollMs]
+ *
+ *   -m  shared memory name (default /scd4x)
+ *   -n  start with the last n samples (default all in the ring)
+ *   -f  follow: keep printing new samples until the daemon stops
+ *   -p  polling interval while following (default 100 ms)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Scd4xShmRing.h"
+
+static void print(const Scd4xShmSample& sample) {
+    printf("%llu,%llu,%u,%.2f,%.2f,%u\n",
+           static_cast<unsigned long long>(sample.index),
+           static_cast<unsigned long long>(sample.timestampUs), sample.co2,
+           sample.temperature(), sample.humidity(), sample.flags);
+}
+
+int main(int argc, char* argv[]) {
+    const char* name = SCD4X_SHM_DEFAULT_NAME;
+    uint64_t last = 0;
+    bool follow = false;
+    uint32_t pollMs = 100;
+    int option;
+
+    while ((option = getopt(argc, argv, "m:n:fp:")) != -1) {
+        switch (option) {
+            case 'm':
+                name = optarg;
+                break;
+            case 'n':
+                last = strtoull(optarg, nullptr, 0);
+                break;
+            case 'f':
+                follow = true;
+                break;
+            case 'p':
+                pollMs = strtoul(optarg, nullptr, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-m name] [-n last] [-f] "
+                                "[-p pollMs]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    Scd4xShmReader ring;
+    if (!ring.open(name)) {
+        perror(name);
+        return 1;
+    }
+
+    uint64_t next = ring.tail();
+    uint64_t skipped = 0;
+    if (last && ring.head() - next > last) {
+        next = ring.head() - last;
+    }
+    for (;;) {
+        // read the running flag first so that no final sample is missed
+        bool running = ring.running();
+        uint64_t head = ring.head();
+        Scd4xShmSample sample;
+
+        while (next < head) {
+            if (ring.read(next, sample)) {
+                print(sample);
+                next++;
+            } else {
+                // overwritten while we were behind, continue at the oldest
+                uint64_t tail = ring.tail();
+                skipped += tail > next ? tail - next : 1;
+                next = tail > next ? tail : next + 1;
+            }
+        }
+        fflush(stdout);
+        if (!follow || !running) {
+            break;
+        }
+        usleep(pollMs * 1000);
+    }
+    if (skipped) {
+        fprintf(stderr, "%llu samples overwritten before they were read\n",
+                static_cast<unsigned long long>(skipped));
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * scd4x_telemetry - Decodes the binary telemetry stream of the sketches
+ * (Scd4xTelemetry.h) from a serial port, a file or stdin and prints one
+ * line per frame as CSV or JSON:
+ *
+ *   sequence,timestamp_ms,type,co2,temperature,humidity,temperature_ticks,
+ *   humidity_ticks,flags,error
+ *
+ * Frames with a wrong CRC and text between frames are skipped and counted,
+ * gaps in the sequence numbers are counted as lost frames.
+ *
+ * Usage: scd4x_telemetry [-i input] [-b baud] [-j] [-s]
+ *
+ *   -i  file or serial device (default stdin)
+ *   -b  set a serial device to raw mode at this baud rate (default 115200)
+ *   -j  print JSON lines instead of CSV
+ *   -s  print frame, error and throughput counts to stderr at the end
+ */
+#include <chrono>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "Scd4xTelemetry.h"
+
+static speed_t baudConstant(unsigned long baud) {
+    switch (baud) {
+        case 9600:
+            return B9600;
+        case 19200:
+            return B19200;
+        case 38400:
+            return B38400;
+        case 57600:
+            return B57600;
+        case 230400:
+            return B230400;
+        case 460800:
+            return B460800;
+        case 921600:
+            return B921600;
+        default:
+            return B115200;
+    }
+}
+
+static bool setRaw(int fd, unsigned long baud) {
+    struct termios tty;
+
+    if (tcgetattr(fd, &tty)) {
+        return false;
+    }
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, baudConstant(baud));
+    cfsetospeed(&tty, baudConstant(baud));
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+    return tcsetattr(fd, TCSANOW, &tty) == 0;
+}
+
+static void print(const Scd4xTelemetryRecord& record, bool json) {
+    bool sample = record.type == TelemetrySample;
+    double temperature = record.temperatureTicks * 175.0 / 65536.0 - 45.0;
+    double humidity = record.humidityTicks * 100.0 / 65536.0;
+
+    if (json && sample) {
+        printf("{\"sequence\":%u,\"timestamp_ms\":%u,\"type\":\"sample\","
+               "\"co2\":%u,\"temperature\":%.2f,\"humidity\":%.2f,"
+               "\"temperature_ticks\":%u,\"humidity_ticks\":%u,"
+               "\"flags\":%u}\n",
+               record.sequence, record.timestamp, record.co2, temperature,
+               humidity, record.temperatureTicks, record.humidityTicks,
+               record.flags);
+    } else if (json) {
+        printf("{\"sequence\":%u,\"timestamp_ms\":%u,\"type\":\"error\","
+               "\"error\":%u}\n",
+               record.sequence, record.timestamp, record.error);
+    } else if (sample) {
+        printf("%u,%u,sample,%u,%.2f,%.2f,%u,%u,%u,\n", record.sequence,
+               record.timestamp, record.co2, temperature, humidity,
+               record.temperatureTicks, record.humidityTicks, record.flags);
+    } else {
+        printf("%u,%u,error,,,,,,,%u\n", record.sequence, record.timestamp,
+               record.error);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* input = nullptr;
+    unsigned long baud = 115200;
+    bool json = false;
+    bool statistics = false;
+    int option;
+
+    while ((option = getopt(argc, argv, "i:b:js")) != -1) {
+        switch (option) {
+            case 'i':
+                input = optarg;
+                break;
+            case 'b':
+                baud = strtoul(optarg, nullptr, 0);
+                break;
+            case 'j':
+                json = true;
+                break;
+            case 's':
+                statistics = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-i input] [-b baud] [-j] [-s]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    int fd = input ? open(input, O_RDONLY | O_NOCTTY) : STDIN_FILENO;
+    if (fd < 0) {
+        perror(input);
+        return 1;
+    }
+    bool live = isatty(fd);
+    if (live && !setRaw(fd, baud)) {
+        perror("tcsetattr");
+        return 1;
+    }
+
+    static char outputBuffer[1 << 20];
+    setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+    if (!json) {
+        printf("sequence,timestamp_ms,type,co2,temperature,humidity,"
+               "temperature_ticks,humidity_ticks,flags,error\n");
+    }
+
+    Scd4xTelemetryDecoder decoder;
+    Scd4xTelemetryRecord record;
+    static uint8_t buffer[1 << 16];
+    uint64_t bytes = 0;
+    ssize_t length;
+
+    auto start = std::chrono::steady_clock::now();
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        bytes += length;
+        for (ssize_t i = 0; i < length; i++) {
+            if (decoder.feed(buffer[i], record)) {
+                print(record, json);
+            }
+        }
+        if (live) {
+            fflush(stdout);
+        }
+    }
+    fflush(stdout);
+    double wall = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+    if (statistics) {
+        fprintf(stderr,
+                "%u frames, %u CRC errors, %u invalid, %u lost, "
+                "%llu bytes in %.3f s (%.1f MB/s)\n",
+                decoder.frames(), decoder.crcErrors(),
+                decoder.invalidFrames(), decoder.lostFrames(),
+                static_cast<unsigned long long>(bytes), wall,
+                wall > 0 ? bytes / wall / 1e6 : 0.0);
+    }
+    if (input) {
+        close(fd);
+    }
+    return 0;
+}
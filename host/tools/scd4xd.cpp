@@ -0,0 +1,304 @@
+/*
+ * scd4xd - Runs SensirionI2CScd4x as a Linux daemon and publishes every
+ * sample into a POSIX shared memory ring (linux/Scd4xShmRing.h) which any
+ * number of local processes read without copies or locks, e.g. with
+ * scd4x_shm_read.
+ *
+ * The event loop is epoll on a timerfd and a signalfd. The timer fires a
+ * guard time after the predicted data-ready moment of the sensor. If data is
+ * not ready yet it retries shortly after, and the moment it became ready is
+ * then known to within one retry interval. If data was ready at the first
+ * poll, the prediction moves earlier by one retry interval to find the edge
+ * again. The daemon thereby stays locked to the sensor's own measurement
+ * clock, reading each sample within a few tens of ms, with about one and a
+ * half bus polls per sample instead of polling every second.
+ *
+ * Without -D the sensor is a SimScd4x on the host Wire bus, with the virtual
+ * clock following real time, optionally sped up with -x for tests.
+ *
+ * Usage: scd4xd [-D /dev/i2c-N] [-m name] [-n capacity] [-l] [-x speedup]
+ *               [-s seed] [-S scenario] [-g guardMs] [-r retryMs]
+ *               [-c samples] [-v]
+ *
+ *   -D  use the sensor on this i2c-dev bus instead of the simulation
+ *   -m  shared memory name (default /scd4x)
+ *   -n  ring capacity in samples (default 4096)
+ *   -l  low power periodic measurement (30 s instead of 5 s)
+ *   -x  run the simulation this many times faster than real time
+ *   -s  seed, -S office, bedroom or classroom for the simulated trace
+ *   -g  poll this long after the predicted data ready (default 20 ms)
+ *   -r  retry interval while data is not ready (default 25 ms)
+ *   -c  exit after this many samples
+ *   -v  print every sample
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "LinuxI2cDevice.h"
+#include "Scd4xOutlierFilter.h"
+#include "Scd4xSampleRing.h"
+#include "Scd4xShmRing.h"
+#include "SensirionI2CScd4x.h"
+#include "SimScd4x.h"
+#include "TraceSource.h"
+#include "Wire.h"
+
+struct Options {
+    const char* device = nullptr;
+    const char* name = SCD4X_SHM_DEFAULT_NAME;
+    uint32_t capacity = 4096;
+    bool lowPower = false;
+    uint32_t speedup = 1;
+    uint32_t seed = 1;
+    IndoorScenario scenario = ScenarioOffice;
+    uint32_t guardMs = 20;
+    uint32_t retryMs = 25;
+    uint64_t samples = 0;
+    bool verbose = false;
+};
+
+struct Stats {
+    uint64_t samples = 0;
+    uint64_t polls = 0;
+    uint64_t notReady = 0;
+    uint64_t errors = 0;
+};
+
+static uint64_t realtimeUs() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+// arms the timer for a point on the VirtualClock
+static void armAt(int timerFd, uint64_t targetUs) {
+    uint64_t now = VirtualClock::micros();
+    uint64_t ns = targetUs > now ? (targetUs - now) * 1000 : 0;
+    struct itimerspec timer = {};
+
+    // an all-zero value would disarm the timer
+    ns = ns ? ns / VirtualClock::speedup() : 1;
+    ns = ns ? ns : 1;
+    timer.it_value.tv_sec = static_cast<time_t>(ns / 1000000000ULL);
+    timer.it_value.tv_nsec = static_cast<long>(ns % 1000000000ULL);
+    timerfd_settime(timerFd, 0, &timer, nullptr);
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+    int option;
+
+    while ((option = getopt(argc, argv, "D:m:n:lx:s:S:g:r:c:v")) != -1) {
+        switch (option) {
+            case 'D':
+                options.device = optarg;
+                break;
+            case 'm':
+                options.name = optarg;
+                break;
+            case 'n':
+                options.capacity = strtoul(optarg, nullptr, 0);
+                break;
+            case 'l':
+                options.lowPower = true;
+                break;
+            case 'x':
+                options.speedup = strtoul(optarg, nullptr, 0);
+                break;
+            case 's':
+                options.seed = strtoul(optarg, nullptr, 0);
+                break;
+            case 'S':
+                options.scenario = !strcmp(optarg, "bedroom") ? ScenarioBedroom
+                                   : !strcmp(optarg, "classroom")
+                                       ? ScenarioClassroom
+                                       : ScenarioOffice;
+                break;
+            case 'g':
+                options.guardMs = strtoul(optarg, nullptr, 0);
+                break;
+            case 'r':
+                options.retryMs = strtoul(optarg, nullptr, 0);
+                break;
+            case 'c':
+                options.samples = strtoull(optarg, nullptr, 0);
+                break;
+            case 'v':
+                options.verbose = true;
+                break;
+            default:
+                return false;
+        }
+    }
+    if (!options.capacity || !options.speedup || !options.retryMs ||
+        (options.device && options.speedup != 1)) {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr,
+                "usage: %s [-D /dev/i2c-N] [-m name] [-n capacity] [-l] "
+                "[-x speedup] [-s seed] [-S scenario] [-g guardMs] "
+                "[-r retryMs] [-c samples] [-v]\n"
+                "       -x is only available for the simulated sensor\n",
+                argv[0]);
+        return 2;
+    }
+
+    IndoorTraceSource trace(options.scenario, options.seed, 0xFFFFFFFF);
+    SimScd4x simulated(trace, options.seed);
+    LinuxI2cDevice* hardware = nullptr;
+    if (options.device) {
+        hardware = new LinuxI2cDevice(options.device, SIM_SCD4X_ADDRESS);
+        if (!hardware->isOpen()) {
+            perror(options.device);
+            return 1;
+        }
+        Wire.attach(SIM_SCD4X_ADDRESS, hardware);
+    } else {
+        Wire.attach(SIM_SCD4X_ADDRESS, &simulated);
+    }
+    VirtualClock::followRealTime(options.speedup);
+
+    static Scd4xSample ringBuffer[8];
+    Scd4xSampleRing sampleRing(ringBuffer, 8);
+    Scd4xSampleFilter<> sampleFilter;
+    SensirionI2CScd4x scd4x;
+    uint16_t serial[3];
+    uint16_t error;
+
+    Wire.begin();
+    scd4x.begin(Wire);
+    scd4x.attachSampleRing(&sampleRing);
+    scd4x.stopPeriodicMeasurement();
+    error = scd4x.getSerialNumber(serial[0], serial[1], serial[2]);
+    if (!error) {
+        error = options.lowPower ? scd4x.startLowPowerPeriodicMeasurement()
+                                 : scd4x.startPeriodicMeasurement();
+    }
+    if (error) {
+        char message[64];
+        errorToString(error, message, sizeof(message));
+        fprintf(stderr, "sensor not available: %s\n", message);
+        return 1;
+    }
+
+    uint64_t intervalUs = options.lowPower ? 30000000 : 5000000;
+    uint64_t serialNumber = static_cast<uint64_t>(serial[0]) << 32 |
+                            static_cast<uint64_t>(serial[1]) << 16 | serial[2];
+    Scd4xShmWriter ring;
+    if (!ring.create(options.name, options.capacity, intervalUs / 1000,
+                     serialNumber)) {
+        perror(options.name);
+        return 1;
+    }
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    int signalFd = signalfd(-1, &signals, SFD_CLOEXEC);
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = timerFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event);
+    event.data.fd = signalFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &event);
+
+    fprintf(stderr, "scd4xd: serial %012llx, %s mode, publishing to %s\n",
+            static_cast<unsigned long long>(serialNumber),
+            options.lowPower ? "low power" : "periodic", options.name);
+
+    Stats stats;
+    uint64_t guardUs = options.guardMs * 1000ULL;
+    uint64_t retryUs = options.retryMs * 1000ULL;
+    uint64_t expected = VirtualClock::micros() + intervalUs;
+    bool retried = false;
+    bool running = true;
+
+    armAt(timerFd, expected + guardUs);
+    while (running) {
+        if (epoll_wait(epollFd, &event, 1, -1) < 1) {
+            continue;
+        }
+        if (event.data.fd == signalFd) {
+            running = false;
+            continue;
+        }
+        uint64_t expirations;
+        if (read(timerFd, &expirations, sizeof(expirations)) < 0) {
+            continue;
+        }
+
+        uint16_t dataReady;
+        stats.polls++;
+        error = scd4x.getDataReadyStatus(dataReady);
+        if (error || !(dataReady & 0x07FF)) {
+            stats.errors += error ? 1 : 0;
+            stats.notReady += error ? 0 : 1;
+            retried = true;
+            armAt(timerFd, VirtualClock::micros() + retryUs);
+            continue;
+        }
+
+        uint16_t co2, temperature, humidity;
+        uint64_t now = VirtualClock::micros();
+        if (scd4x.readMeasurementTicks(co2, temperature, humidity)) {
+            stats.errors++;
+        }
+        Scd4xSample sample;
+        while (sampleRing.pop(sample)) {
+            sampleFilter.apply(sample);
+            ring.publish(realtimeUs(), sample.co2, sample.temperatureTicks,
+                         sample.humidityTicks, sample.flags);
+            stats.samples++;
+            if (options.verbose) {
+                printf("%llu co2 %u ppm, %.2f C, %.2f %%RH, flags %02x\n",
+                       static_cast<unsigned long long>(stats.samples),
+                       sample.co2, sample.temperature, sample.humidity,
+                       sample.flags);
+                fflush(stdout);
+            }
+        }
+
+        // the edge lies within the last retry interval if we had to retry,
+        // otherwise it may be earlier than predicted
+        expected = retried ? now - retryUs / 2 : expected - retryUs;
+        expected += intervalUs;
+        if (expected + guardUs < VirtualClock::micros()) {
+            // missed a whole interval, e.g. after a suspend
+            expected = VirtualClock::micros() + intervalUs;
+        }
+        retried = false;
+        armAt(timerFd, expected + guardUs);
+        running = !options.samples || stats.samples < options.samples;
+    }
+
+    scd4x.stopPeriodicMeasurement();
+    ring.close();
+    fprintf(stderr,
+            "scd4xd: %llu samples, %.2f polls per sample, %llu not ready, "
+            "%llu errors\n",
+            static_cast<unsigned long long>(stats.samples),
+            stats.samples ? static_cast<double>(stats.polls) / stats.samples
+                          : 0.0,
+            static_cast<unsigned long long>(stats.notReady),
+            static_cast<unsigned long long>(stats.errors));
+    delete hardware;
+    return 0;
+}
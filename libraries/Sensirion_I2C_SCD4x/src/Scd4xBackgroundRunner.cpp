@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xBackgroundRunner.h"
+#include "Arduino.h"
+#include "SensirionI2CScd4x.h"
+
+// added to the datasheet execution time of the driver's command table for
+// the poll interval and a sensor at the edge of its specification
+#define SCD4X_RUNNER_DEADLINE_MARGIN_MS 500
+
+Scd4xBackgroundRunner::Scd4xBackgroundRunner() {
+}
+
+void Scd4xBackgroundRunner::begin(SensirionI2CScd4x& scd4x,
+                                  Scd4xRunnerCallback callback) {
+    _scd4x = &scd4x;
+    _callback = callback;
+    _operation = Scd4xNoOperation;
+}
+
+uint16_t Scd4xBackgroundRunner::_start(Scd4xOperation operation,
+                                       uint32_t nowMs) {
+    uint16_t error;
+
+    if (isBusy()) {
+        return WriteError | I2cOtherError;
+    }
+    if (operation == Scd4xSelfTest) {
+        error = _scd4x->sendPerformSelfTest();
+        _deadlineMs =
+            SensirionI2CScd4x::executionTime(Scd4xCmdPerformSelfTest) +
+            SCD4X_RUNNER_DEADLINE_MARGIN_MS;
+        _pollIntervalMs = 100;
+    } else {
+        error = _scd4x->sendPerformFactoryReset();
+        _deadlineMs =
+            SensirionI2CScd4x::executionTime(Scd4xCmdPerformFactoryReset) +
+            SCD4X_RUNNER_DEADLINE_MARGIN_MS;
+        _pollIntervalMs = 20;
+    }
+    if (error) {
+        return error;
+    }
+    _operation = operation;
+    _startMs = nowMs;
+    _lastPollMs = nowMs;
+    _progress = 0;
+    return NoError;
+}
+
+uint16_t Scd4xBackgroundRunner::startSelfTest(uint32_t nowMs) {
+    return _start(Scd4xSelfTest, nowMs);
+}
+
+uint16_t Scd4xBackgroundRunner::startFactoryReset(uint32_t nowMs) {
+    return _start(Scd4xFactoryReset, nowMs);
+}
+
+void Scd4xBackgroundRunner::_finish(uint16_t error, uint16_t result) {
+    Scd4xRunnerEvent event;
+
+    event.operation = _operation;
+    event.progress = 100;
+    event.done = true;
+    event.error = error;
+    event.result = result;
+    _operation = Scd4xNoOperation;
+    if (_callback) {
+        _callback(event);
+    }
+}
+
+void Scd4xBackgroundRunner::update(uint32_t nowMs) {
+    uint32_t elapsed = nowMs - _startMs;
+    uint16_t error;
+    uint16_t result = 0;
+
+    if (!isBusy() || nowMs - _lastPollMs < _pollIntervalMs) {
+        return;
+    }
+    _lastPollMs = nowMs;
+
+    if (_operation == Scd4xSelfTest) {
+        error = _scd4x->readPerformSelfTestResult(result);
+    } else {
+        error = _scd4x->probe();
+    }
+    if (!error) {
+        _finish(NoError, result);
+        return;
+    }
+    if (elapsed >= _deadlineMs) {
+        _finish(ReadError | TimeoutError, 0);
+        return;
+    }
+
+    uint8_t progress = static_cast<uint8_t>(elapsed * 10 / _deadlineMs) * 10;
+    if (progress > _progress) {
+        Scd4xRunnerEvent event;
+        event.operation = _operation;
+        event.progress = progress;
+        event.done = false;
+        event.error = NoError;
+        event.result = 0;
+        _progress = progress;
+        if (_callback) {
+            _callback(event);
+        }
+    }
+}
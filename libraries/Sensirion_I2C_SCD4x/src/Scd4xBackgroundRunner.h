@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_BACKGROUND_RUNNER_H
+#define SCD4X_BACKGROUND_RUNNER_H
+
+#include <stdint.h>
+
+#include "SensirionI2CScd4x.h"
+
+enum Scd4xOperation : uint8_t {
+    Scd4xNoOperation,
+    Scd4xSelfTest,
+    Scd4xFactoryReset,
+};
+
+/*
+ * Scd4xRunnerEvent - Progress or completion of a background operation.
+ * result is the sensor status of a self test, 0 for a factory reset.
+ */
+struct Scd4xRunnerEvent {
+    Scd4xOperation operation;
+    uint8_t progress;  // 0 - 100 %, estimated from the deadline
+    bool done;
+    uint16_t error;
+    uint16_t result;
+};
+
+typedef void (*Scd4xRunnerCallback)(const Scd4xRunnerEvent& event);
+
+/*
+ * Scd4xBackgroundRunner - Runs perform_self_test and perform_factory_reset
+ * without blocking. The command is sent, then update() polls the sensor from
+ * the main loop until it answers or the datasheet deadline passed. Progress
+ * is reported through the callback in 10 % steps, followed by one event with
+ * done set. The sensor must be idle when an operation is started and must
+ * not be used by anything else until the operation is done.
+ */
+class Scd4xBackgroundRunner {
+
+  public:
+    Scd4xBackgroundRunner();
+
+    /**
+     * begin() - Initializes the runner.
+     *
+     * @param scd4x    Sensor driver to use.
+     * @param callback Function receiving progress and result events.
+     */
+    void begin(SensirionI2CScd4x& scd4x, Scd4xRunnerCallback callback);
+
+    /**
+     * startSelfTest() - Send perform_self_test, the result arrives within
+     * the datasheet time of 5.5 s; the runner gives up 0.5 s later.
+     *
+     * @param nowMs Current time in ms, e.g. millis().
+     *
+     * @return 0 on success, an error code otherwise, also if an operation is
+     * already running
+     */
+    uint16_t startSelfTest(uint32_t nowMs);
+
+    /**
+     * startFactoryReset() - Send perform_factory_reset, it completes within
+     * the datasheet time of 0.8 s; the runner gives up 0.5 s later.
+     *
+     * @param nowMs Current time in ms, e.g. millis().
+     *
+     * @return 0 on success, an error code otherwise, also if an operation is
+     * already running
+     */
+    uint16_t startFactoryReset(uint32_t nowMs);
+
+    /**
+     * update() - Poll the running operation and emit events. Call it from
+     * the main loop; it only touches the bus every poll interval.
+     *
+     * @param nowMs Current time in ms, e.g. millis().
+     */
+    void update(uint32_t nowMs);
+
+    bool isBusy() const {
+        return _operation != Scd4xNoOperation;
+    }
+
+    Scd4xOperation operation() const {
+        return _operation;
+    }
+
+  private:
+    uint16_t _start(Scd4xOperation operation, uint32_t nowMs);
+    void _finish(uint16_t error, uint16_t result);
+
+    SensirionI2CScd4x* _scd4x = nullptr;
+    Scd4xRunnerCallback _callback = nullptr;
+    uint32_t _startMs = 0;
+    uint32_t _lastPollMs = 0;
+    uint16_t _deadlineMs = 0;
+    uint16_t _pollIntervalMs = 0;
+    uint8_t _progress = 0;
+    Scd4xOperation _operation = Scd4xNoOperation;
+};
+
+#endif /* SCD4X_BACKGROUND_RUNNER_H */
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xBusScanner.h"
+#include "Arduino.h"
+
+#define SCD4X_I2C_ADDRESS 0x62
+#define SSD1306_I2C_ADDRESS 0x3C
+#define SSD1306_I2C_ADDRESS_ALT 0x3D
+
+static uint8_t crc8(const uint8_t data[], uint8_t length) {
+    uint8_t crc = 0xFF;
+
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+Scd4xBusScanner::Scd4xBusScanner(Scd4xBusDevice devices[], uint8_t capacity)
+    : _devices(devices), _capacity(capacity) {
+}
+
+void Scd4xBusScanner::begin(TwoWire& wire, uint32_t busClock,
+                            Scd4xBusEventHandler handler) {
+    _wire = &wire;
+    _busClock = busClock;
+    _handler = handler;
+    _count = 0;
+    _passActive = false;
+}
+
+uint8_t Scd4xBusScanner::scan(uint8_t first, uint8_t last, uint8_t limit) {
+    uint8_t found = 0;
+
+    _count = 0;
+    _probes = 0;
+    _wire->setClock(SCD4X_SCAN_CLOCK);
+    for (uint16_t address = first; address <= last && found < limit;
+         address++) {
+        if (_probe(address)) {
+            found++;
+            _insert(address);
+        }
+    }
+    _wire->setClock(_busClock);
+    return _count;
+}
+
+void Scd4xBusScanner::setWatchInterval(uint32_t intervalMs,
+                                       uint8_t addressesPerRun) {
+    _intervalMs = intervalMs;
+    _addressesPerRun = addressesPerRun ? addressesPerRun : 1;
+}
+
+void Scd4xBusScanner::update(uint32_t nowMs) {
+    if (!_intervalMs) {
+        return;
+    }
+    if (!_passActive) {
+        if (nowMs - _passStartMs < _intervalMs) {
+            return;
+        }
+        _passActive = true;
+        _passStartMs = nowMs;
+        _next = SCD4X_SCAN_FIRST;
+        _probes = 0;
+    }
+
+    _wire->setClock(SCD4X_SCAN_CLOCK);
+    for (uint8_t i = 0; i < _addressesPerRun && _passActive; i++) {
+        _check(_next);
+        if (_next++ == SCD4X_SCAN_LAST) {
+            _passActive = false;
+        }
+    }
+    _wire->setClock(_busClock);
+}
+
+const Scd4xBusDevice* Scd4xBusScanner::find(Scd4xBusDeviceType type,
+                                            uint8_t index) const {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_devices[i].type == type && index-- == 0) {
+            return &_devices[i];
+        }
+    }
+    return nullptr;
+}
+
+bool Scd4xBusScanner::_probe(uint8_t address) {
+    _probes++;
+    _wire->beginTransmission(address);
+    return _wire->endTransmission() == 0;
+}
+
+// sends an SCD4x read command and checks the CRC of every response word
+bool Scd4xBusScanner::_readScd4x(uint16_t command, uint16_t words[],
+                                 uint8_t count) {
+    uint8_t buffer[9];
+    uint8_t length = 3 * count;
+
+    _probes += 2;
+    _wire->beginTransmission(SCD4X_I2C_ADDRESS);
+    _wire->write(static_cast<uint8_t>(command >> 8));
+    _wire->write(static_cast<uint8_t>(command));
+    if (_wire->endTransmission()) {
+        return false;
+    }
+    delay(1);
+    if (_wire->requestFrom(static_cast<uint8_t>(SCD4X_I2C_ADDRESS),
+                           length) != length) {
+        return false;
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[i] = _wire->read();
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (crc8(&buffer[3 * i], 2) != buffer[3 * i + 2]) {
+            return false;
+        }
+        words[i] = (buffer[3 * i] << 8) | buffer[3 * i + 1];
+    }
+    return true;
+}
+
+void Scd4xBusScanner::_identify(Scd4xBusDevice& device) {
+    uint16_t status;
+
+    device.type = BusDeviceUnknown;
+    device.flags = 0;
+    device.serial[0] = device.serial[1] = device.serial[2] = 0;
+
+    if (device.address == SCD4X_I2C_ADDRESS) {
+        // get_serial_number is only executed in idle mode
+        if (_readScd4x(0x3682, device.serial, 3)) {
+            device.type = BusDeviceScd4x;
+        } else if (_readScd4x(0xE4B8, &status, 1)) {
+            device.type = BusDeviceScd4x;
+            device.flags |= BusDeviceMeasuring;
+        }
+    } else if (device.address == SSD1306_I2C_ADDRESS ||
+               device.address == SSD1306_I2C_ADDRESS_ALT) {
+        // a read returns the status byte: bit 6 display off, the low bits
+        // tell SH1106 (8) from SSD1306 controllers
+        _probes++;
+        if (_wire->requestFrom(device.address, static_cast<uint8_t>(1)) != 1) {
+            return;
+        }
+        status = _wire->read();
+        device.type =
+            ((status & 0x0F) == 0x08) ? BusDeviceSh1106 : BusDeviceSsd1306;
+        if (!(status & 0x40)) {
+            device.flags |= BusDeviceDisplayOn;
+        }
+    }
+}
+
+void Scd4xBusScanner::_check(uint8_t address) {
+    int16_t index = _indexOf(address);
+
+    if (_probe(address)) {
+        if (index < 0) {
+            _insert(address);
+        } else {
+            _devices[index].flags &= ~BusDeviceMissed;
+        }
+    } else if (index >= 0) {
+        if (_devices[index].flags & BusDeviceMissed) {
+            _remove(index);
+        } else {
+            _devices[index].flags |= BusDeviceMissed;
+        }
+    }
+}
+
+int16_t Scd4xBusScanner::_indexOf(uint8_t address) const {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_devices[i].address == address) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void Scd4xBusScanner::_insert(uint8_t address) {
+    uint8_t index = _count;
+
+    if (_count == _capacity) {
+        return;
+    }
+    while (index && _devices[index - 1].address > address) {
+        _devices[index] = _devices[index - 1];
+        index--;
+    }
+    _count++;
+    _devices[index].address = address;
+    _identify(_devices[index]);
+    if (_handler) {
+        _handler(_devices[index], true);
+    }
+}
+
+void Scd4xBusScanner::_remove(uint8_t index) {
+    Scd4xBusDevice device = _devices[index];
+
+    _count--;
+    for (uint8_t i = index; i < _count; i++) {
+        _devices[i] = _devices[i + 1];
+    }
+    if (_handler) {
+        _handler(device, false);
+    }
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_BUS_SCANNER_H
+#define SCD4X_BUS_SCANNER_H
+
+#include <Wire.h>
+#include <stdint.h>
+
+// bus clock while probing
+#define SCD4X_SCAN_CLOCK 400000
+// usable 7-bit addresses, the others are reserved by the I2C specification
+#define SCD4X_SCAN_FIRST 0x08
+#define SCD4X_SCAN_LAST 0x77
+
+enum Scd4xBusDeviceType : uint8_t {
+    BusDeviceUnknown,  // acknowledged its address, not identified
+    BusDeviceScd4x,
+    BusDeviceSsd1306,
+    BusDeviceSh1106,
+};
+
+enum Scd4xBusDeviceFlag : uint8_t {
+    BusDeviceMeasuring = 0x01,  // SCD4x in periodic mode, serial unknown
+    BusDeviceDisplayOn = 0x02,  // display controller reports display on
+    BusDeviceMissed = 0x04,     // did not answer the last watch pass
+};
+
+/*
+ * Scd4xBusDevice - Entry of the scanner's device table, sorted by address.
+ */
+struct Scd4xBusDevice {
+    uint8_t address;
+    Scd4xBusDeviceType type;
+    uint8_t flags;
+    uint16_t serial[3];  // SCD4x serial number, 0 if not read
+};
+
+typedef void (*Scd4xBusEventHandler)(const Scd4xBusDevice& device,
+                                     bool attached);
+
+/*
+ * Scd4xBusScanner - I2C scanner which probes at 400 kHz and identifies the
+ * devices it finds with cheap read-only commands: get_serial_number for an
+ * idle SCD4x at 0x62 (get_data_ready_status when it is measuring) and the
+ * status byte of SSD1306 / SH1106 displays at 0x3C and 0x3D. The results
+ * are kept in a caller provided table.
+ *
+ * update() then watches the bus for hot-plug events: every watch interval
+ * it walks the address range again, a few addresses per call so the loop
+ * is never held up, and reports devices which appeared, or which missed two
+ * passes in a row. A busy SCD4x NACKs its address, so one miss is not
+ * counted as a removal.
+ */
+class Scd4xBusScanner {
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param devices  Storage for the device table.
+     * @param capacity Number of entries; further devices are ignored.
+     */
+    Scd4xBusScanner(Scd4xBusDevice devices[], uint8_t capacity);
+
+    /**
+     * begin() - Initializes the scanner.
+     *
+     * @param wire     Bus to scan.
+     * @param busClock Clock restored after probing.
+     * @param handler  Called for every device added to or removed from the
+     *                 table, may be nullptr.
+     */
+    void begin(TwoWire& wire, uint32_t busClock = 100000,
+               Scd4xBusEventHandler handler = nullptr);
+
+    /**
+     * scan() - Probe an address range now and rebuild the table. The
+     * handler is called for every device found.
+     *
+     * @param first First address.
+     * @param last  Last address.
+     * @param limit Stop after this many devices were found.
+     *
+     * @return Number of devices in the table
+     */
+    uint8_t scan(uint8_t first = SCD4X_SCAN_FIRST,
+                 uint8_t last = SCD4X_SCAN_LAST, uint8_t limit = 0xFF);
+
+    /**
+     * setWatchInterval() - Configure the hot-plug watch of update().
+     *
+     * @param intervalMs      Time from the start of one pass to the next,
+     *                        0 disables the watch.
+     * @param addressesPerRun Addresses probed per update() call.
+     */
+    void setWatchInterval(uint32_t intervalMs, uint8_t addressesPerRun = 8);
+
+    /**
+     * update() - Continue the watch pass, call it from loop().
+     *
+     * @param nowMs Current millis().
+     */
+    void update(uint32_t nowMs);
+
+    /**
+     * find() - Look up a device.
+     *
+     * @param type  Device type to look for.
+     * @param index Number of the device of this type, in address order.
+     *
+     * @return The table entry, nullptr if there is none
+     */
+    const Scd4xBusDevice* find(Scd4xBusDeviceType type,
+                               uint8_t index = 0) const;
+
+    uint8_t count() const {
+        return _count;
+    }
+
+    const Scd4xBusDevice& device(uint8_t index) const {
+        return _devices[index];
+    }
+
+    // transactions sent by the last scan() or watch pass
+    uint16_t probes() const {
+        return _probes;
+    }
+
+  private:
+    bool _probe(uint8_t address);
+    void _identify(Scd4xBusDevice& device);
+    bool _readScd4x(uint16_t command, uint16_t words[], uint8_t count);
+    void _check(uint8_t address);
+    int16_t _indexOf(uint8_t address) const;
+    void _insert(uint8_t address);
+    void _remove(uint8_t index);
+
+    Scd4xBusDevice* _devices;
+    uint8_t _capacity;
+    uint8_t _count = 0;
+    TwoWire* _wire = nullptr;
+    uint32_t _busClock = 100000;
+    Scd4xBusEventHandler _handler = nullptr;
+    uint32_t _intervalMs = 0;
+    uint32_t _passStartMs = 0;
+    uint16_t _probes = 0;
+    uint8_t _addressesPerRun = 8;
+    uint8_t _next = SCD4X_SCAN_FIRST;
+    bool _passActive = false;
+};
+
+#endif /* SCD4X_BUS_SCANNER_H */
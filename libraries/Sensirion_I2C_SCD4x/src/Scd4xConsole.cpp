@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xConsole.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+Scd4xConsole::Scd4xConsole(const Scd4xConsoleCommand commands[],
+                           uint8_t count)
+    : _commands(commands), _count(count) {
+    _line[0] = '\0';
+    _argv[0] = _line;
+}
+
+Scd4xConsoleStatus Scd4xConsole::feed(char c) {
+    if (c == '\r') {
+        return ConsoleIdle;
+    }
+    if (c == '\b' || c == 0x7F) {
+        if (_length) {
+            _length--;
+        }
+        return ConsoleIdle;
+    }
+    if (c != '\n') {
+        if (_length < SCD4X_CONSOLE_LINE_MAX - 1) {
+            _line[_length++] = c;
+        } else {
+            _tooLong = true;
+        }
+        return ConsoleIdle;
+    }
+
+    Scd4xConsoleStatus status = ConsoleTooLong;
+    if (_tooLong) {
+        _line[0] = '\0';
+        _argv[0] = _line;
+    } else {
+        status = _execute();
+    }
+    _length = 0;
+    _tooLong = false;
+    return status;
+}
+
+Scd4xConsoleStatus Scd4xConsole::_execute() {
+    uint8_t argc = 0;
+    char* next = _line;
+
+    _line[_length] = '\0';
+    while (*next) {
+        while (*next == ' ' || *next == '\t') {
+            *next++ = '\0';
+        }
+        if (!*next) {
+            break;
+        }
+        if (argc == SCD4X_CONSOLE_MAX_ARGS) {
+            return ConsoleUsage;
+        }
+        _argv[argc++] = next;
+        while (*next && *next != ' ' && *next != '\t') {
+            next++;
+        }
+    }
+    if (!argc) {
+        _argv[0] = _line;
+        return ConsoleEmpty;
+    }
+
+    for (uint8_t i = 0; i < _count; i++) {
+        const Scd4xConsoleCommand& command = _commands[i];
+        if (strcmp(command.name, _argv[0])) {
+            continue;
+        }
+        if (argc - 1 < command.minArgs) {
+            return ConsoleUsage;
+        }
+        command.handler(argc, _argv);
+        return ConsoleExecuted;
+    }
+    return ConsoleUnknown;
+}
+
+bool Scd4xConsole::parseUInt16(const char* text, uint16_t& value) {
+    char* end;
+    unsigned long number;
+
+    if (!*text || *text == '-') {
+        return false;
+    }
+    // base 0 would take a leading zero as octal, "010" must stay ten
+    bool hex = text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+    number = strtoul(text, &end, hex ? 16 : 10);
+    if (*end || number > 0xFFFF) {
+        return false;
+    }
+    value = static_cast<uint16_t>(number);
+    return true;
+}
+
+bool Scd4xConsole::parseFloat(const char* text, float& value) {
+    char* end;
+    double number;
+
+    if (!*text) {
+        return false;
+    }
+    number = strtod(text, &end);
+    if (*end) {
+        return false;
+    }
+    value = static_cast<float>(number);
+    return true;
+}
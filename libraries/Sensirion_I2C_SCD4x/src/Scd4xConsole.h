@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_CONSOLE_H
+#define SCD4X_CONSOLE_H
+
+#include <stdint.h>
+
+// longest command line including the terminating 0
+#define SCD4X_CONSOLE_LINE_MAX 32
+// command name and arguments per line
+#define SCD4X_CONSOLE_MAX_ARGS 4
+
+typedef void (*Scd4xConsoleHandler)(uint8_t argc, char* argv[]);
+
+/*
+ * Scd4xConsoleCommand - Entry of the command table: the handler gets the
+ * command name as argv[0] and at least minArgs arguments after it.
+ */
+struct Scd4xConsoleCommand {
+    const char* name;
+    Scd4xConsoleHandler handler;
+    uint8_t minArgs;
+};
+
+enum Scd4xConsoleStatus : uint8_t {
+    ConsoleIdle,      // line not complete yet
+    ConsoleExecuted,  // a handler ran
+    ConsoleEmpty,     // empty line
+    ConsoleUnknown,   // no such command
+    ConsoleUsage,     // too few or too many arguments
+    ConsoleTooLong,   // line longer than SCD4X_CONSOLE_LINE_MAX, ignored
+};
+
+/*
+ * Scd4xConsole - Line oriented command console without heap use. Input is
+ * fed one character at a time, so the main loop never waits for a line;
+ * when the line ends it is split at spaces in place and the matching
+ * handler of the table runs. Backspace edits the line, '\r' is ignored.
+ */
+class Scd4xConsole {
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param commands Command table, kept by pointer.
+     * @param count    Number of commands.
+     */
+    Scd4xConsole(const Scd4xConsoleCommand commands[], uint8_t count);
+
+    /**
+     * feed() - Process one input character, e.g. from Serial.read().
+     *
+     * @return Result of the line if c ended one, ConsoleIdle otherwise
+     */
+    Scd4xConsoleStatus feed(char c);
+
+    // name of the command of the last complete line
+    const char* command() const {
+        return _argv[0];
+    }
+
+    /**
+     * parseUInt16() - Parse a decimal or 0x prefixed hex number.
+     *
+     * @return true if text is a number from 0 to 65535
+     */
+    static bool parseUInt16(const char* text, uint16_t& value);
+
+    /**
+     * parseFloat() - Parse a decimal number like 4.5 or -1.25.
+     *
+     * @return true if text is a number
+     */
+    static bool parseFloat(const char* text, float& value);
+
+  private:
+    Scd4xConsoleStatus _execute();
+
+    const Scd4xConsoleCommand* _commands;
+    uint8_t _count;
+    char _line[SCD4X_CONSOLE_LINE_MAX];
+    char* _argv[SCD4X_CONSOLE_MAX_ARGS] = {};
+    uint8_t _length = 0;
+    bool _tooLong = false;
+};
+
+#endif /* SCD4X_CONSOLE_H */
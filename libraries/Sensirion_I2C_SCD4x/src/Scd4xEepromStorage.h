@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_EEPROM_STORAGE_H
+#define SCD4X_EEPROM_STORAGE_H
+
+#include "Scd4xLogStore.h"
+
+#ifdef ARDUINO_ARCH_AVR
+
+#include <EEPROM.h>
+
+/*
+ * Scd4xEepromStorage - Scd4xStorage on the internal EEPROM of AVR boards.
+ * Cells are written individually, so an erase only touches the bytes which
+ * are not 0xFF yet and a write skips bytes which already hold the value.
+ */
+class Scd4xEepromStorage : public Scd4xStorage {
+
+  public:
+    /**
+     * Scd4xEepromStorage() - Use an EEPROM region for the log.
+     *
+     * @param offset      First EEPROM address of the region.
+     * @param size        Size of the region, a multiple of segmentSize.
+     * @param segmentSize Rotation unit of the log in bytes.
+     */
+    Scd4xEepromStorage(uint16_t offset, uint16_t size, uint16_t segmentSize)
+        : _offset(offset), _size(size), _segmentSize(segmentSize) {
+    }
+
+    uint32_t size() const override {
+        return _size;
+    }
+
+    uint16_t segmentSize() const override {
+        return _segmentSize;
+    }
+
+    bool read(uint32_t address, uint8_t data[], size_t length) override {
+        if (address + length > _size) {
+            return false;
+        }
+        for (size_t i = 0; i < length; i++) {
+            data[i] = EEPROM.read(_offset + address + i);
+        }
+        return true;
+    }
+
+    bool write(uint32_t address, const uint8_t data[],
+               size_t length) override {
+        if (address + length > _size) {
+            return false;
+        }
+        for (size_t i = 0; i < length; i++) {
+            EEPROM.update(_offset + address + i, data[i]);
+        }
+        return true;
+    }
+
+    bool erase(uint32_t segmentAddress) override {
+        if (segmentAddress + _segmentSize > _size) {
+            return false;
+        }
+        for (uint16_t i = 0; i < _segmentSize; i++) {
+            EEPROM.update(_offset + segmentAddress + i, 0xFF);
+        }
+        return true;
+    }
+
+  private:
+    uint16_t _offset;
+    uint16_t _size;
+    uint16_t _segmentSize;
+};
+
+#endif /* ARDUINO_ARCH_AVR */
+
+#endif /* SCD4X_EEPROM_STORAGE_H */
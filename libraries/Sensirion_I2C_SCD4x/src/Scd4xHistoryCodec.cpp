@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xHistoryCodec.h"
+
+static void putUInt16(uint8_t* buffer, uint16_t value) {
+    buffer[0] = static_cast<uint8_t>(value);
+    buffer[1] = static_cast<uint8_t>(value >> 8);
+}
+
+static uint16_t getUInt16(const uint8_t* buffer) {
+    return static_cast<uint16_t>(buffer[0] | (buffer[1] << 8));
+}
+
+static uint32_t getUInt32(const uint8_t* buffer) {
+    return static_cast<uint32_t>(getUInt16(buffer)) |
+           (static_cast<uint32_t>(getUInt16(buffer + 2)) << 16);
+}
+
+Scd4xHistoryEncoder::Scd4xHistoryEncoder(uint8_t block[], size_t blockSize)
+    : _block(block), _blockSize(blockSize) {
+    // the first record fills the header, the others check for space
+    if (blockSize < SCD4X_HISTORY_HEADER_SIZE + SCD4X_HISTORY_MAX_RECORD_SIZE) {
+        _blockSize = 0;
+    }
+    reset();
+}
+
+void Scd4xHistoryEncoder::reset() {
+    _previousDelta = 0;
+    if (!_blockSize) {
+        _index = 0;
+        return;
+    }
+    _block[0] = SCD4X_HISTORY_VERSION;
+    _block[1] = 0;
+    _index = SCD4X_HISTORY_HEADER_SIZE;
+}
+
+bool Scd4xHistoryEncoder::append(const Scd4xHistoryRecord& record) {
+    if (!_blockSize) {
+        return false;
+    }
+    uint8_t count = _block[1];
+
+    if (count == 0) {
+        putUInt16(&_block[2], static_cast<uint16_t>(record.timestamp));
+        putUInt16(&_block[4], static_cast<uint16_t>(record.timestamp >> 16));
+        putUInt16(&_block[6], record.co2);
+        putUInt16(&_block[8], record.temperatureTicks);
+        putUInt16(&_block[10], record.humidityTicks);
+    } else {
+        if (count == 0xFF ||
+            _index + SCD4X_HISTORY_MAX_RECORD_SIZE > _blockSize) {
+            return false;
+        }
+        // modulo 2^32, any timestamp jump is encoded without overflow
+        uint32_t delta = record.timestamp - _previous.timestamp;
+        _putVarint(static_cast<int32_t>(delta - _previousDelta));
+        _putVarint(static_cast<int32_t>(record.co2) - _previous.co2);
+        _putVarint(static_cast<int32_t>(record.temperatureTicks) -
+                   _previous.temperatureTicks);
+        _putVarint(static_cast<int32_t>(record.humidityTicks) -
+                   _previous.humidityTicks);
+        _previousDelta = delta;
+    }
+    _previous = record;
+    _block[1] = count + 1;
+    return true;
+}
+
+void Scd4xHistoryEncoder::_putVarint(int32_t value) {
+    // zigzag maps small negative and positive values to small codes
+    uint32_t code = (static_cast<uint32_t>(value) << 1) ^
+                    static_cast<uint32_t>(value >> 31);
+    while (code >= 0x80) {
+        _block[_index++] = static_cast<uint8_t>(code | 0x80);
+        code >>= 7;
+    }
+    _block[_index++] = static_cast<uint8_t>(code);
+}
+
+Scd4xHistoryDecoder::Scd4xHistoryDecoder(const uint8_t block[],
+                                         size_t blockSize)
+    : _block(block), _blockSize(blockSize), _index(0), _previousDelta(0) {
+    _remaining = isValid(block, blockSize) ? block[1] : 0;
+}
+
+bool Scd4xHistoryDecoder::isValid(const uint8_t block[], size_t blockSize) {
+    return blockSize >= SCD4X_HISTORY_HEADER_SIZE &&
+           block[0] == SCD4X_HISTORY_VERSION && block[1] != 0;
+}
+
+uint32_t Scd4xHistoryDecoder::startTime(const uint8_t block[],
+                                        size_t blockSize) {
+    return isValid(block, blockSize) ? getUInt32(&block[2]) : 0;
+}
+
+bool Scd4xHistoryDecoder::next(Scd4xHistoryRecord& record) {
+    if (_remaining == 0) {
+        return false;
+    }
+
+    if (_index == 0) {
+        record.timestamp = getUInt32(&_block[2]);
+        record.co2 = getUInt16(&_block[6]);
+        record.temperatureTicks = getUInt16(&_block[8]);
+        record.humidityTicks = getUInt16(&_block[10]);
+        _index = SCD4X_HISTORY_HEADER_SIZE;
+    } else {
+        int32_t deltaOfDelta;
+        int32_t co2;
+        int32_t temperature;
+        int32_t humidity;
+        if (!_getVarint(deltaOfDelta) || !_getVarint(co2) ||
+            !_getVarint(temperature) || !_getVarint(humidity)) {
+            _remaining = 0;
+            return false;
+        }
+        // unsigned, corrupt data must not overflow a signed int
+        _previousDelta += static_cast<uint32_t>(deltaOfDelta);
+        record.timestamp = _previous.timestamp + _previousDelta;
+        record.co2 = static_cast<uint16_t>(_previous.co2 +
+                                           static_cast<uint32_t>(co2));
+        record.temperatureTicks = static_cast<uint16_t>(
+            _previous.temperatureTicks + static_cast<uint32_t>(temperature));
+        record.humidityTicks = static_cast<uint16_t>(
+            _previous.humidityTicks + static_cast<uint32_t>(humidity));
+    }
+    _previous = record;
+    _remaining--;
+    return true;
+}
+
+bool Scd4xHistoryDecoder::_getVarint(int32_t& value) {
+    uint32_t code = 0;
+    uint8_t shift = 0;
+    uint8_t byte;
+
+    do {
+        if (_index >= _blockSize || shift > 28) {
+            return false;
+        }
+        byte = _block[_index++];
+        code |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    value = static_cast<int32_t>(code >> 1) ^ -static_cast<int32_t>(code & 1);
+    return true;
+}
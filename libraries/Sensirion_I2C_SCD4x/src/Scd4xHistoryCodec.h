@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_HISTORY_CODEC_H
+#define SCD4X_HISTORY_CODEC_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// size of the block header: version, record count, base timestamp, first
+// co2/temperature/humidity ticks
+#define SCD4X_HISTORY_HEADER_SIZE 12
+// worst case size of an encoded record: 5 byte timestamp, 3 x 3 byte ticks
+#define SCD4X_HISTORY_MAX_RECORD_SIZE 14
+#define SCD4X_HISTORY_VERSION 0x01
+
+/*
+ * Scd4xHistoryRecord - One history entry as raw sensor ticks.
+ */
+struct Scd4xHistoryRecord {
+    uint32_t timestamp;  // seconds, any epoch
+    uint16_t co2;
+    uint16_t temperatureTicks;
+    uint16_t humidityTicks;
+};
+
+/*
+ * Scd4xHistoryEncoder - Append-only compressor for measurement history. The
+ * records are packed into self-contained blocks of fixed size: a header with
+ * the first record in plain form, followed by the delta-of-delta of the
+ * timestamps and the deltas of the ticks, each zigzag and varint encoded. A
+ * steady 5 s signal usually needs 4 to 5 bytes per record instead of 10.
+ * Blocks do not reference each other, so stored blocks can be accessed and
+ * decoded individually.
+ */
+class Scd4xHistoryEncoder {
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param block     Buffer receiving the encoded block.
+     * @param blockSize Size of the block in bytes, at least
+     *                  SCD4X_HISTORY_HEADER_SIZE +
+     *                  SCD4X_HISTORY_MAX_RECORD_SIZE. A smaller block is
+     *                  rejected: it is never written and append() always
+     *                  fails.
+     */
+    Scd4xHistoryEncoder(uint8_t block[], size_t blockSize);
+
+    /**
+     * isValid() - Check whether the block was large enough.
+     *
+     * @return true if records can be appended
+     */
+    bool isValid() const {
+        return _blockSize != 0;
+    }
+
+    /**
+     * reset() - Start a new, empty block in the buffer.
+     */
+    void reset();
+
+    /**
+     * append() - Add a record to the current block.
+     *
+     * @param record Record to encode, timestamps must be non-decreasing.
+     *
+     * @return true on success, false if the block is full. The caller then
+     * stores the block, calls reset() and appends the record again.
+     */
+    bool append(const Scd4xHistoryRecord& record);
+
+    /**
+     * size() - Number of bytes used in the block.
+     */
+    size_t size() const {
+        return _index;
+    }
+
+    /**
+     * count() - Number of records in the block.
+     */
+    uint8_t count() const {
+        return _blockSize ? _block[1] : 0;
+    }
+
+  private:
+    void _putVarint(int32_t value);
+
+    uint8_t* _block;
+    size_t _blockSize;
+    size_t _index;
+    Scd4xHistoryRecord _previous;
+    uint32_t _previousDelta;  // modulo 2^32 like the timestamps
+};
+
+/*
+ * Scd4xHistoryDecoder - Streaming decoder for one block written by
+ * Scd4xHistoryEncoder.
+ */
+class Scd4xHistoryDecoder {
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param block     Encoded block.
+     * @param blockSize Size of the block buffer in bytes. Nothing is read
+     *                  beyond it; a block shorter than the header decodes
+     *                  no records.
+     */
+    Scd4xHistoryDecoder(const uint8_t block[], size_t blockSize);
+
+    /**
+     * next() - Decode the next record.
+     *
+     * @param record Receives the record.
+     *
+     * @return true on success, false at the end of the block or if the block
+     * is corrupt
+     */
+    bool next(Scd4xHistoryRecord& record);
+
+    /**
+     * isValid() - Check the block header.
+     *
+     * @param block     Encoded block.
+     * @param blockSize Size of the block buffer in bytes.
+     *
+     * @return true if the block holds the header, a known version and records
+     */
+    static bool isValid(const uint8_t block[], size_t blockSize);
+
+    /**
+     * startTime() - Timestamp of the first record of a block without
+     * decoding it, e.g. to binary search stored blocks.
+     *
+     * @param block     Encoded block.
+     * @param blockSize Size of the block buffer in bytes.
+     *
+     * @return Timestamp in seconds, 0 if the block is not valid
+     */
+    static uint32_t startTime(const uint8_t block[], size_t blockSize);
+
+  private:
+    bool _getVarint(int32_t& value);
+
+    const uint8_t* _block;
+    size_t _blockSize;
+    size_t _index;
+    uint8_t _remaining;
+    Scd4xHistoryRecord _previous;
+    uint32_t _previousDelta;
+};
+
+#endif /* SCD4X_HISTORY_CODEC_H */
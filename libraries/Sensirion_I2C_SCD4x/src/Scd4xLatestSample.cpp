@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xLatestSample.h"
+
+#include <string.h>
+
+Scd4xLatestSample::Scd4xLatestSample() : _sequence(0) {
+    memset(&_current, 0, sizeof(_current));
+    for (uint8_t i = 0; i < WORDS; i++) {
+        _storeWord(_words[i], 0);
+    }
+}
+
+void Scd4xLatestSample::onSample(const Scd4xSample& sample) {
+    _current.sample = sample;
+    _current.count++;
+    _current.lastError = 0;
+    _publish();
+}
+
+void Scd4xLatestSample::onError(uint16_t error) {
+    _current.errorCount++;
+    _current.lastError = error;
+    _publish();
+}
+
+void Scd4xLatestSample::_publish() {
+    uint32_t words[WORDS] = {};
+    memcpy(words, &_current, sizeof(_current));
+
+#ifdef __AVR__
+    _sequence = _sequence + 1;
+    _fence();
+    for (uint8_t i = 0; i < WORDS; i++) {
+        _storeWord(_words[i], words[i]);
+    }
+    _fence();
+    _sequence = _sequence + 1;
+#else
+    uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint8_t i = 0; i < WORDS; i++) {
+        _storeWord(_words[i], words[i]);
+    }
+    _sequence.store(sequence + 2, std::memory_order_release);
+#endif
+}
+
+bool Scd4xLatestSample::tryRead(Scd4xSnapshot& snapshot) const {
+    uint32_t words[WORDS];
+    uint32_t before = _load(_sequence);
+
+    if (before & 1) {
+        return false;
+    }
+    for (uint8_t i = 0; i < WORDS; i++) {
+        words[i] = _loadWord(_words[i]);
+    }
+    _fence();
+#ifdef __AVR__
+    if (_sequence != static_cast<uint8_t>(before)) {
+#else
+    if (_sequence.load(std::memory_order_relaxed) != before) {
+#endif
+        return false;
+    }
+    memcpy(&snapshot, words, sizeof(snapshot));
+    return true;
+}
+
+void Scd4xLatestSample::read(Scd4xSnapshot& snapshot) const {
+    while (!tryRead(snapshot)) {
+    }
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_LATEST_SAMPLE_H
+#define SCD4X_LATEST_SAMPLE_H
+
+#include <stdint.h>
+
+#include "Scd4xMeasurementBus.h"
+#include "Scd4xSampleRing.h"
+
+/*
+ * Scd4xSnapshot - The most recent measurement and its metadata.
+ */
+struct Scd4xSnapshot {
+    Scd4xSample sample;   // latest sample, all zero before the first one
+    uint32_t count;       // samples published so far
+    uint32_t errorCount;  // read errors published so far
+    uint16_t lastError;   // error of the latest read, 0 if it succeeded
+};
+
+/*
+ * Scd4xLatestSample - Seqlock protected snapshot of the latest measurement
+ * for readers in other threads (or, on AVR, a reader in the main loop and a
+ * writer in an interrupt). One writer publishes, by subscribing it to a
+ * Scd4xMeasurementBus or calling onSample() / onError() directly. Readers
+ * copy the snapshot and retry if the writer changed it meanwhile, so they
+ * never see torn values and never block the writer; a reader only waits
+ * while a write is in progress, which is a copy of a few dozen bytes.
+ */
+class Scd4xLatestSample : public Scd4xSampleSink {
+
+  public:
+    Scd4xLatestSample();
+
+    // writer side
+    void onSample(const Scd4xSample& sample) override;
+    void onError(uint16_t error) override;
+
+    /**
+     * tryRead() - Copy the snapshot once.
+     *
+     * @param snapshot Receives the snapshot, undefined if false is returned.
+     *
+     * @return true if the copy is consistent, false if the writer was active
+     */
+    bool tryRead(Scd4xSnapshot& snapshot) const;
+
+    /**
+     * read() - Copy the snapshot, retrying until it is consistent.
+     *
+     * @param snapshot Receives the snapshot.
+     */
+    void read(Scd4xSnapshot& snapshot) const;
+
+    /**
+     * version() - Changes with every publication; compare it to skip
+     * copying an unchanged snapshot.
+     *
+     * @return Even number when idle, odd while a write is in progress
+     */
+    uint32_t version() const {
+        return _load(_sequence);
+    }
+
+  private:
+    static const uint8_t WORDS = (sizeof(Scd4xSnapshot) + 3) / 4;
+
+    void _publish();
+
+#ifdef __AVR__
+    typedef volatile uint8_t Sequence;
+    typedef volatile uint32_t Word;
+    static uint8_t _load(const Sequence& sequence) {
+        __asm__ __volatile__("" ::: "memory");
+        return sequence;
+    }
+    static uint32_t _loadWord(const Word& word) {
+        return word;
+    }
+    static void _storeWord(Word& word, uint32_t value) {
+        word = value;
+    }
+    static void _fence() {
+        __asm__ __volatile__("" ::: "memory");
+    }
+#else
+    typedef std::atomic<uint32_t> Sequence;
+    typedef std::atomic<uint32_t> Word;
+    static uint32_t _load(const Sequence& sequence) {
+        return sequence.load(std::memory_order_acquire);
+    }
+    static uint32_t _loadWord(const Word& word) {
+        return word.load(std::memory_order_relaxed);
+    }
+    static void _storeWord(Word& word, uint32_t value) {
+        word.store(value, std::memory_order_relaxed);
+    }
+    static void _fence() {
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+#endif
+
+    Scd4xSnapshot _current;  // writer's copy
+    Sequence _sequence;
+    Word _words[WORDS];
+};
+
+#endif /* SCD4X_LATEST_SAMPLE_H */
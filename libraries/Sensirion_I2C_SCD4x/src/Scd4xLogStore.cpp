@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xLogStore.h"
+
+Scd4xLogStore::Scd4xLogStore(Scd4xStorage& storage) : _storage(storage) {
+}
+
+// same CRC-8 as the sensor frames: polynomial 0x31, initialization 0xFF
+uint8_t Scd4xLogStore::_crc(const uint8_t data[], size_t count, uint8_t crc) {
+    for (size_t i = 0; i < count; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 8; bit > 0; --bit) {
+            if (crc & 0x80) {
+                crc = (crc << 1) ^ 0x31;
+            } else {
+                crc = (crc << 1);
+            }
+        }
+    }
+    return crc;
+}
+
+bool Scd4xLogStore::_readHeader(uint16_t segment, uint32_t& sequence) {
+    uint8_t header[SCD4X_LOG_SEGMENT_HEADER_SIZE];
+
+    if (!_storage.read(static_cast<uint32_t>(segment) * _segmentSize, header,
+                       sizeof(header))) {
+        return false;
+    }
+    if (header[0] != (SCD4X_LOG_SEGMENT_MAGIC >> 8) ||
+        header[1] != (SCD4X_LOG_SEGMENT_MAGIC & 0xFF) ||
+        header[6] != _crc(header, 6, 0xFF)) {
+        return false;
+    }
+    sequence = (static_cast<uint32_t>(header[2]) << 24) |
+               (static_cast<uint32_t>(header[3]) << 16) |
+               (static_cast<uint32_t>(header[4]) << 8) | header[5];
+    return true;
+}
+
+bool Scd4xLogStore::_openSegment(uint16_t segment, uint32_t sequence) {
+    uint32_t address = static_cast<uint32_t>(segment) * _segmentSize;
+    uint8_t header[SCD4X_LOG_SEGMENT_HEADER_SIZE];
+
+    if (!_storage.erase(address)) {
+        return false;
+    }
+    _erasedSegments++;
+
+    header[0] = SCD4X_LOG_SEGMENT_MAGIC >> 8;
+    header[1] = SCD4X_LOG_SEGMENT_MAGIC & 0xFF;
+    header[2] = static_cast<uint8_t>(sequence >> 24);
+    header[3] = static_cast<uint8_t>(sequence >> 16);
+    header[4] = static_cast<uint8_t>(sequence >> 8);
+    header[5] = static_cast<uint8_t>(sequence);
+    header[6] = _crc(header, 6, 0xFF);
+    if (!_storage.write(address, header, sizeof(header))) {
+        return false;
+    }
+    _writtenBytes += sizeof(header);
+
+    _head = segment;
+    _headSequence = sequence;
+    _headOffset = SCD4X_LOG_SEGMENT_HEADER_SIZE;
+    return true;
+}
+
+uint16_t Scd4xLogStore::_scanSegment(uint16_t segment) {
+    uint32_t base = static_cast<uint32_t>(segment) * _segmentSize;
+    uint16_t offset = SCD4X_LOG_SEGMENT_HEADER_SIZE;
+    uint8_t length;
+
+    while (offset < _segmentSize) {
+        if (!_storage.read(base + offset, &length, 1) || length == 0xFF) {
+            break;
+        }
+        // torn and valid records alike occupy their full length
+        offset += length + SCD4X_LOG_RECORD_OVERHEAD;
+    }
+    return (offset > _segmentSize) ? _segmentSize : offset;
+}
+
+bool Scd4xLogStore::mount() {
+    uint32_t sequence;
+    bool found = false;
+
+    _segmentSize = _storage.segmentSize();
+    if (_segmentSize <= SCD4X_LOG_SEGMENT_HEADER_SIZE +
+                            SCD4X_LOG_RECORD_OVERHEAD) {
+        return false;
+    }
+    _segmentCount = static_cast<uint16_t>(_storage.size() / _segmentSize);
+    if (_segmentCount < 2) {
+        return false;
+    }
+
+    for (uint16_t segment = 0; segment < _segmentCount; segment++) {
+        if (_readHeader(segment, sequence) &&
+            (!found || sequence > _headSequence)) {
+            _head = segment;
+            _headSequence = sequence;
+            found = true;
+        }
+    }
+    if (!found) {
+        return format();
+    }
+    _headOffset = _scanSegment(_head);
+    rewind();
+    return true;
+}
+
+bool Scd4xLogStore::format() {
+    _segmentSize = _storage.segmentSize();
+    _segmentCount = static_cast<uint16_t>(_storage.size() / _segmentSize);
+
+    for (uint16_t segment = 1; segment < _segmentCount; segment++) {
+        if (!_storage.erase(static_cast<uint32_t>(segment) * _segmentSize)) {
+            return false;
+        }
+        _erasedSegments++;
+    }
+    if (!_openSegment(0, 1)) {
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+bool Scd4xLogStore::append(const uint8_t payload[], uint8_t length) {
+    uint16_t recordSize = length + SCD4X_LOG_RECORD_OVERHEAD;
+
+    if (length == 0 || length > SCD4X_LOG_MAX_PAYLOAD ||
+        recordSize > _segmentSize - SCD4X_LOG_SEGMENT_HEADER_SIZE) {
+        return false;
+    }
+    if (_headOffset + recordSize > _segmentSize) {
+        uint16_t next = (_head + 1 == _segmentCount) ? 0 : _head + 1;
+        if (!_openSegment(next, _headSequence + 1)) {
+            return false;
+        }
+    }
+
+    uint32_t address = static_cast<uint32_t>(_head) * _segmentSize +
+                       _headOffset;
+    uint8_t crc = _crc(&length, 1, 0xFF);
+    crc = _crc(payload, length, crc);
+    uint8_t commit = SCD4X_LOG_COMMIT;
+    // reserve the space before writing so a failed write is never reused
+    _headOffset += recordSize;
+    if (!_storage.write(address, &length, 1) ||
+        !_storage.write(address + 1, payload, length) ||
+        !_storage.write(address + 1 + length, &crc, 1)) {
+        return false;
+    }
+    // the commit marker goes last, a record without it is ignored
+    if (!_storage.write(address + length + 2, &commit, 1)) {
+        return false;
+    }
+    _writtenBytes += recordSize;
+    return true;
+}
+
+void Scd4xLogStore::rewind() {
+    // the segment after the head is the oldest one in round-robin order
+    _readSegment = (_head + 1 == _segmentCount) ? 0 : _head + 1;
+    _readOffset = SCD4X_LOG_SEGMENT_HEADER_SIZE;
+    _readSteps = _segmentCount;
+}
+
+bool Scd4xLogStore::_readRecord(uint32_t address, uint8_t payload[],
+                                uint8_t bufferSize, uint8_t& length,
+                                bool& valid) {
+    uint8_t trailer[2];
+    uint8_t crc;
+
+    valid = false;
+    if (!_storage.read(address, &length, 1) || length > bufferSize ||
+        !_storage.read(address + 1, payload, length) ||
+        !_storage.read(address + 1 + length, trailer, 2)) {
+        return false;
+    }
+    crc = _crc(&length, 1, 0xFF);
+    crc = _crc(payload, length, crc);
+    valid = (trailer[0] == crc && trailer[1] == SCD4X_LOG_COMMIT);
+    return true;
+}
+
+bool Scd4xLogStore::readNext(uint8_t payload[], uint8_t bufferSize,
+                             uint8_t& length) {
+    uint32_t sequence;
+    uint8_t recordLength;
+    bool valid;
+
+    while (_readSteps) {
+        uint32_t base = static_cast<uint32_t>(_readSegment) * _segmentSize;
+        // the header is only checked when entering a segment
+        bool inLog = _readOffset > SCD4X_LOG_SEGMENT_HEADER_SIZE ||
+                     (_readHeader(_readSegment, sequence) &&
+                      sequence <= _headSequence);
+        uint16_t end = (_readSegment == _head) ? _headOffset : _segmentSize;
+
+        while (inLog && _readOffset + SCD4X_LOG_RECORD_OVERHEAD < end) {
+            if (!_storage.read(base + _readOffset, &recordLength, 1) ||
+                recordLength == 0xFF ||
+                _readOffset + recordLength + SCD4X_LOG_RECORD_OVERHEAD >
+                    end) {
+                break;
+            }
+            if (recordLength > bufferSize) {
+                _readOffset += recordLength + SCD4X_LOG_RECORD_OVERHEAD;
+                _skippedRecords++;
+                continue;
+            }
+            if (!_readRecord(base + _readOffset, payload, bufferSize, length,
+                             valid)) {
+                return false;
+            }
+            _readOffset += recordLength + SCD4X_LOG_RECORD_OVERHEAD;
+            if (valid) {
+                return true;
+            }
+        }
+
+        _readSteps--;
+        _readSegment = (_readSegment + 1 == _segmentCount) ? 0
+                                                           : _readSegment + 1;
+        _readOffset = SCD4X_LOG_SEGMENT_HEADER_SIZE;
+    }
+    return false;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_LOG_STORE_H
+#define SCD4X_LOG_STORE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SCD4X_LOG_SEGMENT_MAGIC 0x5334
+// magic, sequence number, CRC
+#define SCD4X_LOG_SEGMENT_HEADER_SIZE 7
+// length byte in front, CRC and commit marker behind the payload
+#define SCD4X_LOG_RECORD_OVERHEAD 3
+#define SCD4X_LOG_MAX_PAYLOAD 254
+#define SCD4X_LOG_COMMIT 0x5A
+
+/*
+ * Scd4xStorage - Non-volatile memory the log store lives on, divided into
+ * equally sized segments which are erased as a whole. Erased bytes read as
+ * 0xFF. Implementations exist for the AVR EEPROM (Scd4xEepromStorage.h) and
+ * for a file-backed flash simulation on the host.
+ */
+class Scd4xStorage {
+
+  public:
+    virtual ~Scd4xStorage() {
+    }
+
+    virtual uint32_t size() const = 0;
+    virtual uint16_t segmentSize() const = 0;
+    virtual bool read(uint32_t address, uint8_t data[], size_t length) = 0;
+    virtual bool write(uint32_t address, const uint8_t data[],
+                       size_t length) = 0;
+    virtual bool erase(uint32_t segmentAddress) = 0;
+};
+
+/*
+ * Scd4xLogStore - Append-only log of CRC protected records on a Scd4xStorage.
+ * Records are written into the head segment; when it is full the next
+ * segment in round-robin order is erased and becomes the new head, dropping
+ * the oldest data. Every segment is therefore erased exactly once per pass
+ * over the memory, which levels the wear.
+ *
+ * An append writes length, payload and CRC first and the commit marker last.
+ * A record torn by a power failure lacks the marker or fails the CRC; it is
+ * skipped on read-back and the next append continues behind it, so no data
+ * written before the failure is lost or rewritten.
+ */
+class Scd4xLogStore {
+
+  public:
+    explicit Scd4xLogStore(Scd4xStorage& storage);
+
+    /**
+     * mount() - Locate the head segment and the append position. Formats the
+     * storage if it does not contain a valid log.
+     *
+     * @return true on success, false if the storage failed or is too small
+     */
+    bool mount();
+
+    /**
+     * format() - Erase all segments and start an empty log.
+     *
+     * @return true on success
+     */
+    bool format();
+
+    /**
+     * append() - Append a record.
+     *
+     * @param payload Record data.
+     * @param length  Record length, 1 to SCD4X_LOG_MAX_PAYLOAD bytes.
+     *
+     * @return true on success
+     */
+    bool append(const uint8_t payload[], uint8_t length);
+
+    /**
+     * rewind() - Position the reader at the oldest record.
+     */
+    void rewind();
+
+    /**
+     * readNext() - Read the next record in append order. Torn records are
+     * skipped, and so are records which do not fit into the buffer; those
+     * are counted by skippedRecords(). Appending while reading may erase the
+     * segment being read.
+     *
+     * @param payload    Buffer for the record data.
+     * @param bufferSize Size of the buffer.
+     * @param length     Receives the record length.
+     *
+     * @return true if a record was read, false at the end of the log or if
+     * the storage failed
+     */
+    bool readNext(uint8_t payload[], uint8_t bufferSize, uint8_t& length);
+
+    // records skipped by readNext() because they did not fit the buffer
+    uint32_t skippedRecords() const {
+        return _skippedRecords;
+    }
+
+    uint32_t erasedSegments() const {
+        return _erasedSegments;
+    }
+
+    uint32_t writtenBytes() const {
+        return _writtenBytes;
+    }
+
+  private:
+    static uint8_t _crc(const uint8_t data[], size_t count, uint8_t crc);
+    bool _readHeader(uint16_t segment, uint32_t& sequence);
+    bool _openSegment(uint16_t segment, uint32_t sequence);
+    uint16_t _scanSegment(uint16_t segment);
+    bool _readRecord(uint32_t address, uint8_t payload[], uint8_t bufferSize,
+                     uint8_t& length, bool& valid);
+
+    Scd4xStorage& _storage;
+    uint16_t _segmentCount = 0;
+    uint16_t _segmentSize = 0;
+    uint16_t _head = 0;  // segment receiving appends
+    uint32_t _headSequence = 0;
+    uint16_t _headOffset = 0;  // append position inside the head segment
+    uint16_t _readSegment = 0;
+    uint16_t _readOffset = 0;
+    uint16_t _readSteps = 0;  // segments left to visit
+    uint32_t _skippedRecords = 0;
+    uint32_t _erasedSegments = 0;
+    uint32_t _writtenBytes = 0;
+};
+
+#endif /* SCD4X_LOG_STORE_H */
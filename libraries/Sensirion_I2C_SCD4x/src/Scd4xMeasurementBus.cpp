@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xMeasurementBus.h"
+
+Scd4xMeasurementBus::Scd4xMeasurementBus() {
+}
+
+void Scd4xMeasurementBus::subscribe(Scd4xSampleSink& sink, uint8_t divisor) {
+    Scd4xSampleSink** link = &_sinks;
+
+    sink._divisor = divisor ? divisor : 1;
+    sink._countdown = 1;
+    while (*link) {
+        if (*link == &sink) {
+            return;
+        }
+        link = &(*link)->_next;
+    }
+    // append, sinks are served in subscription order
+    sink._next = nullptr;
+    *link = &sink;
+}
+
+void Scd4xMeasurementBus::unsubscribe(Scd4xSampleSink& sink) {
+    for (Scd4xSampleSink** link = &_sinks; *link; link = &(*link)->_next) {
+        if (*link == &sink) {
+            *link = sink._next;
+            sink._next = nullptr;
+            return;
+        }
+    }
+}
+
+void Scd4xMeasurementBus::publish(const Scd4xSample& sample) {
+    _published++;
+    for (Scd4xSampleSink* sink = _sinks; sink; sink = sink->_next) {
+        if (--sink->_countdown == 0) {
+            sink->_countdown = sink->_divisor;
+            sink->onSample(sample);
+        }
+    }
+}
+
+void Scd4xMeasurementBus::publishError(uint16_t error) {
+    for (Scd4xSampleSink* sink = _sinks; sink; sink = sink->_next) {
+        sink->onError(error);
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_MEASUREMENT_BUS_H
+#define SCD4X_MEASUREMENT_BUS_H
+
+#include <stdint.h>
+
+#include "Scd4xSampleRing.h"
+
+class Scd4xMeasurementBus;
+
+/*
+ * Scd4xSampleSink - Consumer of published samples, e.g. a display, serial
+ * output, logger or alarm. The sample is only valid during the call; a sink
+ * which needs it later keeps what it needs itself.
+ */
+class Scd4xSampleSink {
+
+  public:
+    virtual void onSample(const Scd4xSample& sample) = 0;
+
+    /**
+     * onError() - Called for every published read error, regardless of the
+     * rate divisor.
+     *
+     * @param error Error code of the failed read
+     */
+    virtual void onError(uint16_t error) {
+        static_cast<void>(error);
+    }
+
+  private:
+    friend class Scd4xMeasurementBus;
+
+    Scd4xSampleSink* _next = nullptr;
+    uint8_t _divisor = 1;
+    uint8_t _countdown = 1;
+};
+
+/*
+ * Scd4xMeasurementBus - Fans every sample read from the sensor out to the
+ * subscribed sinks by const reference. The sample is read and filtered once,
+ * adding a sink adds neither bus reads nor copies. Each sink has a rate
+ * divisor and receives every n-th sample only. Sinks are kept in a list
+ * linked through the sinks themselves, so the bus needs no memory of its
+ * own and has no limit on the number of sinks.
+ */
+class Scd4xMeasurementBus {
+
+  public:
+    Scd4xMeasurementBus();
+
+    /**
+     * subscribe() - Add a sink, it receives its first sample with the next
+     * publish(). A sink which is already subscribed only gets the new
+     * divisor.
+     *
+     * @param sink    Sink to add, must outlive its subscription.
+     * @param divisor Deliver every divisor-th sample, 1 for all.
+     */
+    void subscribe(Scd4xSampleSink& sink, uint8_t divisor = 1);
+
+    /**
+     * unsubscribe() - Remove a sink.
+     *
+     * @param sink Sink to remove.
+     */
+    void unsubscribe(Scd4xSampleSink& sink);
+
+    /**
+     * publish() - Deliver a sample to all sinks whose divisor is due.
+     *
+     * @param sample Sample to deliver.
+     */
+    void publish(const Scd4xSample& sample);
+
+    /**
+     * publishError() - Report a failed read to all sinks.
+     *
+     * @param error Error code returned by the driver.
+     */
+    void publishError(uint16_t error);
+
+    uint32_t publishedCount() const {
+        return _published;
+    }
+
+  private:
+    Scd4xSampleSink* _sinks = nullptr;
+    uint32_t _published = 0;
+};
+
+#endif /* SCD4X_MEASUREMENT_BUS_H */
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xMemory.h"
+
+#ifdef __AVR__
+
+#include <avr/io.h>
+
+extern uint8_t __data_start;
+extern uint8_t __bss_end;
+extern uint8_t __heap_start;
+extern uint8_t* __brkval;
+
+// avr-libc's malloc free list
+struct __freelist {
+    size_t sz;
+    struct __freelist* nx;
+};
+extern struct __freelist* __flp;
+
+static uint8_t* heapEnd() {
+    return __brkval ? __brkval : &__heap_start;
+}
+
+void Scd4xMemory::paintStack() {
+    uint8_t* p = heapEnd();
+    uint8_t* sp = reinterpret_cast<uint8_t*>(SP);
+
+    while (p < sp) {
+        *p++ = SCD4X_STACK_CANARY;
+    }
+}
+
+size_t Scd4xMemory::stackUnused() {
+    const uint8_t* p = heapEnd();
+    const uint8_t* top = reinterpret_cast<const uint8_t*>(RAMEND);
+
+    while (p <= top && *p == SCD4X_STACK_CANARY) {
+        p++;
+    }
+    return p - heapEnd();
+}
+
+size_t Scd4xMemory::stackHighWater() {
+    return RAMEND - reinterpret_cast<size_t>(heapEnd()) + 1 - stackUnused();
+}
+
+size_t Scd4xMemory::freeRam() {
+    return SP - reinterpret_cast<size_t>(heapEnd());
+}
+
+size_t Scd4xMemory::staticRam() {
+    return &__bss_end - &__data_start;
+}
+
+void Scd4xMemory::heapStats(Scd4xHeapStats& stats) {
+    stats.heapSize = heapEnd() - &__heap_start;
+    stats.freeBytes = 0;
+    stats.largestFree = 0;
+    stats.fragments = 0;
+    for (const __freelist* block = __flp; block; block = block->nx) {
+        // a free block includes its size field
+        size_t size = block->sz + sizeof(size_t);
+        stats.freeBytes += size;
+        stats.fragments++;
+        if (size > stats.largestFree) {
+            stats.largestFree = size;
+        }
+    }
+}
+
+#elif defined(__linux__)
+
+#include <malloc.h>
+
+// glibc linker symbols
+extern char __data_start;
+extern char end;
+
+// painted area, kept as addresses since the frame is gone after painting
+static uintptr_t paintBottom = 0;
+
+// a frame of SCD4X_HOST_STACK_PAINT bytes right below the caller
+static void __attribute__((noinline)) paintBelow() {
+    volatile uint8_t area[SCD4X_HOST_STACK_PAINT];
+
+    for (size_t i = 0; i < sizeof(area); i++) {
+        area[i] = SCD4X_STACK_CANARY;
+    }
+    paintBottom = reinterpret_cast<uintptr_t>(&area[0]);
+}
+
+void Scd4xMemory::paintStack() {
+    paintBelow();
+}
+
+size_t Scd4xMemory::stackUnused() {
+    const volatile uint8_t* p =
+        reinterpret_cast<const volatile uint8_t*>(paintBottom);
+    size_t unused = 0;
+
+    while (p && unused < SCD4X_HOST_STACK_PAINT &&
+           p[unused] == SCD4X_STACK_CANARY) {
+        unused++;
+    }
+    return unused;
+}
+
+size_t Scd4xMemory::stackHighWater() {
+    return paintBottom ? SCD4X_HOST_STACK_PAINT - stackUnused() : 0;
+}
+
+size_t Scd4xMemory::freeRam() {
+    uintptr_t frame = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+
+    return (paintBottom && frame > paintBottom) ? frame - paintBottom : 0;
+}
+
+size_t Scd4xMemory::staticRam() {
+    return &end - &__data_start;
+}
+
+void Scd4xMemory::heapStats(Scd4xHeapStats& stats) {
+    struct mallinfo2 info = mallinfo2();
+
+    stats.heapSize = info.arena;
+    stats.freeBytes = info.fordblks;
+    stats.largestFree = 0;
+    stats.fragments = static_cast<uint16_t>(info.ordblks);
+}
+
+#else
+
+// other boards: no probes, every figure reads 0
+
+void Scd4xMemory::paintStack() {
+}
+
+size_t Scd4xMemory::stackUnused() {
+    return 0;
+}
+
+size_t Scd4xMemory::stackHighWater() {
+    return 0;
+}
+
+size_t Scd4xMemory::freeRam() {
+    return 0;
+}
+
+size_t Scd4xMemory::staticRam() {
+    return 0;
+}
+
+void Scd4xMemory::heapStats(Scd4xHeapStats& stats) {
+    stats.heapSize = 0;
+    stats.freeBytes = 0;
+    stats.largestFree = 0;
+    stats.fragments = 0;
+}
+
+#endif /* __AVR__ */
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_MEMORY_H
+#define SCD4X_MEMORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// fill byte of the painted stack area
+#define SCD4X_STACK_CANARY 0xC5
+// stack area painted by paintStack() in host builds
+#define SCD4X_HOST_STACK_PAINT 65536
+
+// heap usage and fragmentation
+struct Scd4xHeapStats {
+    size_t heapSize;     // bytes from heap start to the break
+    size_t freeBytes;    // freed bytes below the break
+    size_t largestFree;  // largest freed block, 0 if unknown
+    uint16_t fragments;  // number of freed blocks
+};
+
+/*
+ * Scd4xMemory - RAM probes for the sketches. The stack area is painted with
+ * SCD4X_STACK_CANARY, and stackUnused() later counts the bytes which still
+ * hold it: the closest the stack ever came to the heap.
+ *
+ * On AVR a sketch which defines SCD4X_PAINT_STACK_EARLY before including
+ * this header has the area between heap and stack painted before main(),
+ * from the .init3 section, so the probes cover the whole run; define it in
+ * one file only. Other sketches call paintStack() themselves. Linux host
+ * builds paint SCD4X_HOST_STACK_PAINT bytes below the caller of
+ * paintStack(), so the same report covers the stack depth of a sketch
+ * running in the host emulator; static RAM and heap come from the linker
+ * symbols and glibc there. On other boards every probe returns 0.
+ */
+class Scd4xMemory {
+
+  public:
+    /**
+     * paintStack() - Fill the unused stack area with the canary. Called
+     * before main() on AVR with SCD4X_PAINT_STACK_EARLY; on the host call it
+     * early in main().
+     */
+    static void paintStack();
+
+    /**
+     * stackUnused() - Get the painted bytes which were never overwritten,
+     * the minimum free RAM between heap and stack since painting.
+     */
+    static size_t stackUnused();
+
+    /**
+     * stackHighWater() - Get the deepest stack usage since painting in
+     * bytes, measured from the top of RAM, on the host from paintStack().
+     */
+    static size_t stackHighWater();
+
+    /**
+     * freeRam() - Get the current gap between the heap and the stack.
+     */
+    static size_t freeRam();
+
+    /**
+     * staticRam() - Get the size of the .data and .bss sections.
+     */
+    static size_t staticRam();
+
+    /**
+     * heapStats() - Walk the allocator's free list.
+     *
+     * @param stats Heap size, free bytes, largest free block and fragments.
+     */
+    static void heapStats(Scd4xHeapStats& stats);
+};
+
+#if defined(__AVR__) && defined(SCD4X_PAINT_STACK_EARLY)
+
+#include <avr/io.h>
+
+extern uint8_t __heap_start;
+
+// runs after the stack pointer and r1 are set up, before the .data copy
+extern "C" void scd4xPaintStackEarly(void)
+    __attribute__((naked, used, section(".init3")));
+
+void scd4xPaintStackEarly(void) {
+    // __brkval is not cleared yet, the heap is empty anyway
+    uint8_t* p = &__heap_start;
+
+    while (p < reinterpret_cast<uint8_t*>(SP)) {
+        *p++ = SCD4X_STACK_CANARY;
+    }
+}
+
+#endif /* __AVR__ && SCD4X_PAINT_STACK_EARLY */
+
+#endif /* SCD4X_MEMORY_H */
@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_OUTLIER_FILTER_H
+#define SCD4X_OUTLIER_FILTER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "Scd4xSampleRing.h"
+
+// upper end of the SCD4x output range in ppm
+#define SCD4X_MAX_CO2_PPM 40000
+
+/*
+ * Scd4xRollingMedian - Median of the last N values, maintained in a double
+ * heap: a max-heap below and a min-heap above the median share one array
+ * centered on the median, and every window slot knows its heap position so
+ * the value leaving the window is replaced in place. Each insertion costs
+ * O(log N) compares and the median is read in O(1). Heap positions are
+ * int8_t, so N is limited to 127.
+ */
+template <uint8_t N> class Scd4xRollingMedian {
+    static_assert(N >= 1 && N <= 127,
+                  "Scd4xRollingMedian window must hold 1 to 127 values");
+
+  public:
+    Scd4xRollingMedian() {
+        clear();
+    }
+
+    void clear() {
+        _count = 0;
+        _index = 0;
+        for (uint8_t i = 0; i < N; i++) {
+            _data[i] = 0;
+            // alternate the slots between min-heap (>0) and max-heap (<0)
+            _pos[i] = ((i + 1) / 2) * ((i & 1) ? -1 : 1);
+            _heap(_pos[i]) = i;
+        }
+    }
+
+    void insert(uint16_t value) {
+        bool isNew = _count < N;
+        int8_t p = _pos[_index];
+        uint16_t old = _data[_index];
+
+        _data[_index] = value;
+        _index = (_index + 1 == N) ? 0 : _index + 1;
+        if (isNew) {
+            _count++;
+        }
+
+        if (p > 0) {
+            if (!isNew && old < value) {
+                _minSortDown(p * 2);
+            } else if (_minSortUp(p)) {
+                _maxSortDown(-1);
+            }
+        } else if (p < 0) {
+            if (!isNew && value < old) {
+                _maxSortDown(p * 2);
+            } else if (_maxSortUp(p)) {
+                _minSortDown(1);
+            }
+        } else {
+            if (_maxCount()) {
+                _maxSortDown(-1);
+            }
+            if (_minCount()) {
+                _minSortDown(1);
+            }
+        }
+    }
+
+    uint16_t median() const {
+        uint16_t value = _data[_heapAt(0)];
+        if (_count && (_count & 1) == 0) {
+            value = static_cast<uint16_t>(
+                (static_cast<uint32_t>(value) + _data[_heapAt(-1)]) / 2);
+        }
+        return value;
+    }
+
+    uint8_t count() const {
+        return _count;
+    }
+
+  private:
+    // heap positions run from -N/2 to N/2, the median sits at position 0
+    uint8_t& _heap(int8_t position) {
+        return _heapStorage[static_cast<uint8_t>(position + N / 2)];
+    }
+    uint8_t _heapAt(int8_t position) const {
+        return _heapStorage[static_cast<uint8_t>(position + N / 2)];
+    }
+    int8_t _minCount() const {
+        return (_count - 1) / 2;
+    }
+    int8_t _maxCount() const {
+        return _count / 2;
+    }
+    bool _less(int8_t i, int8_t j) const {
+        return _data[_heapAt(i)] < _data[_heapAt(j)];
+    }
+    bool _exchange(int8_t i, int8_t j) {
+        uint8_t t = _heap(i);
+        _heap(i) = _heap(j);
+        _heap(j) = t;
+        _pos[_heap(i)] = i;
+        _pos[_heap(j)] = j;
+        return true;
+    }
+    bool _compareExchange(int8_t i, int8_t j) {
+        return _less(i, j) && _exchange(i, j);
+    }
+    // restore the heap order from position i downwards, the item at i is
+    // compared against its parent first (for +-1 the parent is the median)
+    void _minSortDown(int8_t i) {
+        for (; i <= _minCount(); i *= 2) {
+            if (i > 1 && i < _minCount() && _less(i + 1, i)) {
+                ++i;
+            }
+            if (!_compareExchange(i, i / 2)) {
+                break;
+            }
+        }
+    }
+    void _maxSortDown(int8_t i) {
+        for (; i >= -_maxCount(); i *= 2) {
+            if (i < -1 && i > -_maxCount() && _less(i, i - 1)) {
+                --i;
+            }
+            if (!_compareExchange(i / 2, i)) {
+                break;
+            }
+        }
+    }
+    // both return true if the item reached the median position
+    bool _minSortUp(int8_t i) {
+        while (i > 0 && _compareExchange(i, i / 2)) {
+            i /= 2;
+        }
+        return i == 0;
+    }
+    bool _maxSortUp(int8_t i) {
+        while (i < 0 && _compareExchange(i / 2, i)) {
+            i /= 2;
+        }
+        return i == 0;
+    }
+
+    uint16_t _data[N];        // window values in arrival order
+    int8_t _pos[N];           // heap position of each window slot
+    uint8_t _heapStorage[N];  // window slots in heap order
+    uint8_t _count;
+    uint8_t _index;  // slot receiving the next value
+};
+
+/*
+ * Scd4xHampelFilter - Streaming Hampel filter with rate-of-change limit for
+ * one channel. A value is an outlier if it deviates from the median of the
+ * previous N values by more than k times the scaled median absolute deviation
+ * (MAD). To stay at O(log N) per value the MAD is the rolling median of each
+ * value's deviation from the median at the time it arrived. Values are only
+ * classified, never dropped.
+ */
+template <uint8_t N> class Scd4xHampelFilter {
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param kTenths     Threshold in tenths of the scaled MAD, 30 is the
+     *                    common choice of 3 sigma.
+     * @param minScale    Lower bound of the scaled MAD in ticks, keeps
+     *                    quantization noise of a steady signal from being
+     *                    flagged.
+     * @param maxRate     Maximum plausible change in ticks per second,
+     *                    0 disables the rate limit.
+     */
+    Scd4xHampelFilter(uint16_t kTenths, uint16_t minScale, uint16_t maxRate)
+        : _kTenths(kTenths), _minScale(minScale), _maxRate(maxRate) {
+    }
+
+    /**
+     * check() - Classify a value and add it to the window.
+     *
+     * @param timestamp Time of the value in ms.
+     * @param value     Value in ticks.
+     *
+     * @return 0 for plausible values, else SampleOutlier and/or
+     * SampleRateLimited
+     */
+    uint8_t check(uint32_t timestamp, uint16_t value) {
+        uint8_t flags = 0;
+
+        if (_values.count()) {
+            uint16_t deviation = _distance(value, _values.median());
+            if (_values.count() >= (N + 1) / 2) {
+                // 1.4826 scales the MAD to a standard deviation
+                uint32_t scale =
+                    static_cast<uint32_t>(_deviations.median()) * 1483 / 1000;
+                if (scale < _minScale) {
+                    scale = _minScale;
+                }
+                if (static_cast<uint32_t>(deviation) * 10 > _kTenths * scale) {
+                    flags |= SampleOutlier;
+                }
+            }
+            _deviations.insert(deviation);
+        }
+
+        if (_maxRate && _hasReference) {
+            // allowance grows with the time since the last accepted value, so
+            // a genuine step is accepted once it is no longer too steep
+            uint32_t allowed =
+                static_cast<uint32_t>(_maxRate) * (timestamp - _lastTime) /
+                1000;
+            if (_distance(value, _lastValue) > allowed) {
+                flags |= SampleRateLimited;
+            }
+        }
+        if (!(flags & SampleRateLimited)) {
+            _lastValue = value;
+            _lastTime = timestamp;
+            _hasReference = true;
+        }
+
+        _values.insert(value);
+        return flags;
+    }
+
+  private:
+    static uint16_t _distance(uint16_t a, uint16_t b) {
+        return (a > b) ? a - b : b - a;
+    }
+
+    Scd4xRollingMedian<N> _values;
+    Scd4xRollingMedian<N> _deviations;
+    uint32_t _lastTime = 0;
+    uint16_t _lastValue = 0;
+    uint16_t _kTenths;
+    uint16_t _minScale;
+    uint16_t _maxRate;
+    bool _hasReference = false;
+};
+
+/*
+ * Scd4xSampleFilter - Runs a Scd4xHampelFilter over CO₂, temperature and
+ * humidity of each sample and sets SampleOutlier / SampleRateLimited if any
+ * channel is implausible. CO₂ readings of 0 ppm or beyond the output range
+ * are flagged with SampleInvalidCo2 and kept out of the CO₂ window. Defaults:
+ * CO₂ 10 ppm minimum scale and 100 ppm/s, temperature 0.2 °C and 0.5 °C/s,
+ * humidity 1 %RH and 2 %RH/s.
+ */
+template <uint8_t N = 9> class Scd4xSampleFilter {
+
+  public:
+    Scd4xSampleFilter()
+        : co2(30, 10, 100), temperature(30, 75, 187), humidity(30, 655, 1311) {
+    }
+
+    /**
+     * apply() - Classify a sample and add it to the windows.
+     *
+     * @param sample Sample whose flags are updated.
+     *
+     * @return true if the sample carries none of the rejection flags
+     */
+    bool apply(Scd4xSample& sample) {
+        if (sample.co2 == 0 || sample.co2 > SCD4X_MAX_CO2_PPM) {
+            sample.flags |= SampleInvalidCo2;
+        } else {
+            sample.flags |= co2.check(sample.timestamp, sample.co2);
+        }
+        sample.flags |=
+            temperature.check(sample.timestamp, sample.temperatureTicks);
+        sample.flags |= humidity.check(sample.timestamp, sample.humidityTicks);
+        return !(sample.flags & SampleRejectMask);
+    }
+
+    Scd4xHampelFilter<N> co2;
+    Scd4xHampelFilter<N> temperature;
+    Scd4xHampelFilter<N> humidity;
+};
+
+#endif /* SCD4X_OUTLIER_FILTER_H */
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xOutputQueue.h"
+
+static Scd4xOutputPriority classify(const uint8_t line[], uint8_t length) {
+    if (length >= 5 && line[4] == '>') {
+        if (!memcmp(line, "ERRO", 4)) {
+            return OutputCritical;
+        }
+        if (!memcmp(line, "WARN", 4)) {
+            return OutputWarning;
+        }
+        return OutputDebug;
+    }
+    return OutputCritical;
+}
+
+// appends the decimal digits of value, returns the new length
+static uint8_t appendNumber(uint8_t out[], uint8_t length, uint16_t value) {
+    uint8_t digits[5];
+    uint8_t count = 0;
+
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (count) {
+        out[length++] = digits[--count];
+    }
+    return length;
+}
+
+static uint8_t appendText(uint8_t out[], uint8_t length, const char* text) {
+    while (*text) {
+        out[length++] = *text++;
+    }
+    return length;
+}
+
+Scd4xOutputQueue::Scd4xOutputQueue(uint8_t buffer[], size_t size,
+                                   Print& output)
+    : _output(output) {
+    const size_t message = SCD4X_OUTPUT_LINE_MAX + 1;  // length byte
+    size_t share = size / 4;
+
+    // every ring holds at least the longest line if the buffer allows it
+    if (share < message) {
+        share = (size >= 3 * message) ? message : size / 3;
+    }
+    size_t sizes[OutputPriorities] = {share, share, size - 2 * share};
+
+    for (uint8_t i = 0; i < OutputPriorities; i++) {
+        Ring& ring = _rings[i];
+        ring.data = buffer;
+        ring.size = static_cast<uint16_t>(sizes[i] < 0xFFFF ? sizes[i]
+                                                            : 0xFFFF);
+        ring.head = 0;
+        ring.used = 0;
+        ring.summaryLines = 0;
+        ring.summaryBytes = 0;
+        buffer += sizes[i];
+    }
+}
+
+size_t Scd4xOutputQueue::write(uint8_t data) {
+    if (data != '\n') {
+        // keep the last byte for the line end
+        if (_lineLength < SCD4X_OUTPUT_LINE_MAX - 1) {
+            _line[_lineLength++] = data;
+        }
+        return 1;
+    }
+    _line[_lineLength++] = '\n';
+    write(classify(_line, _lineLength), _line, _lineLength);
+    _lineLength = 0;
+    return 1;
+}
+
+bool Scd4xOutputQueue::write(Scd4xOutputPriority priority,
+                             const uint8_t data[], size_t length) {
+    if (priority >= OutputPriorities || !length) {
+        return false;
+    }
+    return _enqueue(_rings[priority], data, length);
+}
+
+bool Scd4xOutputQueue::_enqueue(Ring& ring, const uint8_t data[],
+                                size_t length) {
+    bool fits = length <= 0xFF && (!ring.summaryLines || _queueSummary(ring));
+
+    if (!fits || static_cast<size_t>(ring.size - ring.used) < length + 1) {
+        if (ring.summaryLines < 0xFFFF) {
+            ring.summaryLines++;
+        }
+        ring.summaryBytes = (ring.summaryBytes + length < 0xFFFF)
+                                ? ring.summaryBytes + length
+                                : 0xFFFF;
+        _droppedLines++;
+        _droppedBytes += length;
+        return false;
+    }
+    _put(ring, static_cast<uint8_t>(length));
+    for (size_t i = 0; i < length; i++) {
+        _put(ring, data[i]);
+    }
+    return true;
+}
+
+bool Scd4xOutputQueue::_queueSummary(Ring& ring) {
+    uint8_t summary[48];
+    uint8_t length = 0;
+
+    length = appendText(summary, length, "WARN> dropped ");
+    length = appendNumber(summary, length, ring.summaryLines);
+    length = appendText(summary, length, " lines, ");
+    length = appendNumber(summary, length, ring.summaryBytes);
+    length = appendText(summary, length, " bytes\r\n");
+
+    if (ring.size - ring.used < length + 1) {
+        return false;
+    }
+    _put(ring, length);
+    for (uint8_t i = 0; i < length; i++) {
+        _put(ring, summary[i]);
+    }
+    ring.summaryLines = 0;
+    ring.summaryBytes = 0;
+    return true;
+}
+
+void Scd4xOutputQueue::_put(Ring& ring, uint8_t data) {
+    uint32_t tail = static_cast<uint32_t>(ring.head) + ring.used;
+
+    if (tail >= ring.size) {
+        tail -= ring.size;
+    }
+    ring.data[tail] = data;
+    ring.used++;
+}
+
+uint8_t Scd4xOutputQueue::_take(Ring& ring) {
+    uint8_t data = ring.data[ring.head];
+
+    ring.head = (ring.head + 1 < ring.size) ? ring.head + 1 : 0;
+    ring.used--;
+    return data;
+}
+
+size_t Scd4xOutputQueue::drain(size_t budget) {
+    size_t written = 0;
+
+    while (written < budget) {
+        if (!_remaining) {
+            // next message, highest priority first
+            _current = nullptr;
+            for (uint8_t i = OutputPriorities; i-- > 0;) {
+                if (_rings[i].used) {
+                    _current = &_rings[i];
+                    break;
+                }
+            }
+            if (!_current) {
+                break;
+            }
+            _remaining = _take(*_current);
+            continue;
+        }
+
+        Ring& ring = *_current;
+        size_t chunk = _remaining;
+        if (chunk > budget - written) {
+            chunk = budget - written;
+        }
+        if (chunk > static_cast<size_t>(ring.size - ring.head)) {
+            chunk = ring.size - ring.head;
+        }
+        _output.write(ring.data + ring.head, chunk);
+        ring.head = (ring.head + chunk < ring.size) ? ring.head + chunk : 0;
+        ring.used -= chunk;
+        _remaining -= chunk;
+        written += chunk;
+    }
+
+    for (uint8_t i = 0; i < OutputPriorities; i++) {
+        if (_rings[i].summaryLines) {
+            _queueSummary(_rings[i]);
+        }
+    }
+    return written;
+}
+
+size_t Scd4xOutputQueue::pending() const {
+    size_t used = 0;
+
+    for (uint8_t i = 0; i < OutputPriorities; i++) {
+        used += _rings[i].used;
+    }
+    return used;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_OUTPUT_QUEUE_H
+#define SCD4X_OUTPUT_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Arduino.h"
+
+// longest text line, longer lines are cut
+#define SCD4X_OUTPUT_LINE_MAX 96
+
+enum Scd4xOutputPriority : uint8_t {
+    OutputDebug,     // INFO> and STAT> lines, dropped first
+    OutputWarning,   // WARN> lines
+    OutputCritical,  // ERRO> lines, measurements and telemetry frames
+    OutputPriorities,
+};
+
+/*
+ * Scd4xOutputQueue - Non-blocking output with a fixed RAM budget. Text
+ * printed to the queue is collected per line and queued as one message
+ * when the line ends; its priority follows from the prefix of the sketch
+ * output: ERRO> critical, WARN> warning, INFO> and STAT> debug, anything
+ * else, like measurement lines, critical. Binary messages are queued
+ * with write(priority, ...).
+ *
+ * Each priority has its own share of the buffer: a quarter each for debug
+ * and warning, half for critical, but at least one SCD4X_OUTPUT_LINE_MAX
+ * line each when the buffer has 3 * (SCD4X_OUTPUT_LINE_MAX + 1) bytes or
+ * more. A message which does not fit is dropped instead of waiting; once
+ * there is room again, a summary line "WARN> dropped <lines> lines,
+ * <bytes> bytes" takes its place. Reports of many lines at once, like
+ * statistics, are better written directly after draining the queue.
+ *
+ * drain() writes whole messages, highest priority first, limited to what
+ * the output accepts without blocking, e.g. Serial.availableForWrite().
+ */
+class Scd4xOutputQueue : public Print {
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param buffer Storage for the queued messages.
+     * @param size   Size of the buffer, up to 4 * 65535 bytes.
+     * @param output Destination, usually Serial.
+     */
+    Scd4xOutputQueue(uint8_t buffer[], size_t size, Print& output);
+
+    // collects text, queues it at the end of the line
+    size_t write(uint8_t data) override;
+
+    /**
+     * write() - Queue a binary message, e.g. a telemetry frame, as a whole.
+     *
+     * @param priority Priority of the message.
+     * @param data     Message bytes, up to 255.
+     * @param length   Number of bytes.
+     *
+     * @return true if queued, false if dropped
+     */
+    bool write(Scd4xOutputPriority priority, const uint8_t data[],
+               size_t length);
+
+    /**
+     * drain() - Write queued messages to the output.
+     *
+     * @param budget Bytes the output takes without blocking.
+     *
+     * @return Number of bytes written
+     */
+    size_t drain(size_t budget);
+
+    // queued bytes of all priorities
+    size_t pending() const;
+
+    // bytes and lines dropped since the start
+    uint32_t droppedBytes() const {
+        return _droppedBytes;
+    }
+
+    uint32_t droppedLines() const {
+        return _droppedLines;
+    }
+
+    using Print::write;
+
+  private:
+    // byte ring of one priority; messages are stored as length + bytes
+    struct Ring {
+        uint8_t* data;
+        uint16_t size;
+        uint16_t head;
+        uint16_t used;
+        uint16_t summaryLines;  // dropped since the last summary
+        uint16_t summaryBytes;
+    };
+
+    bool _enqueue(Ring& ring, const uint8_t data[], size_t length);
+    bool _queueSummary(Ring& ring);
+    void _put(Ring& ring, uint8_t data);
+    uint8_t _take(Ring& ring);
+
+    Print& _output;
+    Ring _rings[OutputPriorities];
+    uint8_t _line[SCD4X_OUTPUT_LINE_MAX];
+    uint8_t _lineLength = 0;
+    Ring* _current = nullptr;  // ring whose message is being written
+    uint8_t _remaining = 0;     // bytes left of that message
+    uint32_t _droppedBytes = 0;
+    uint32_t _droppedLines = 0;
+};
+
+#endif /* SCD4X_OUTPUT_QUEUE_H */
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xPressureFeed.h"
+#include "Arduino.h"
+#include "SensirionI2CScd4x.h"
+
+Scd4xPressureFeed::Scd4xPressureFeed() {
+}
+
+void Scd4xPressureFeed::begin(SensirionI2CScd4x& scd4x, uint16_t thresholdHpa,
+                              uint8_t filterShift, uint32_t minIntervalMs) {
+    _scd4x = &scd4x;
+    _thresholdHpa = thresholdHpa;
+    _filterShift = filterShift;
+    _minIntervalMs = minIntervalMs;
+    _hasReading = false;
+    _windowOpen = false;
+    _sentHpa = 0;
+    _writeCount = 0;
+    _sent = false;
+}
+
+void Scd4xPressureFeed::addReading(uint32_t pressurePa) {
+    int32_t sample = static_cast<int32_t>(pressurePa) << 8;
+
+    if (!_hasReading) {
+        _filtered = sample;
+        _hasReading = true;
+        return;
+    }
+    _filtered += (sample - _filtered) >> _filterShift;
+}
+
+void Scd4xPressureFeed::measurementRead(uint32_t nowMs,
+                                        uint32_t updateIntervalMs) {
+    _lastReadMs = nowMs;
+    _updateIntervalMs = updateIntervalMs;
+    _windowOpen = true;
+}
+
+uint16_t Scd4xPressureFeed::filteredPressure() const {
+    if (!_hasReading) {
+        return 0;
+    }
+    // Q8 Pa to hPa with rounding
+    return static_cast<uint16_t>((_filtered + (50L << 8)) / (100L << 8));
+}
+
+bool Scd4xPressureFeed::isPending() const {
+    if (!_hasReading) {
+        return false;
+    }
+    if (!_sent) {
+        return true;
+    }
+    uint16_t pressure = filteredPressure();
+    uint16_t delta = (pressure > _sentHpa) ? pressure - _sentHpa
+                                           : _sentHpa - pressure;
+    return delta >= _thresholdHpa;
+}
+
+uint16_t Scd4xPressureFeed::update(uint32_t nowMs) {
+    if (_scd4x == nullptr || !_windowOpen) {
+        return NoError;
+    }
+    // the window closes shortly before the next sample becomes ready
+    if (nowMs - _lastReadMs + GUARD_TIME_MS >= _updateIntervalMs) {
+        _windowOpen = false;
+        return NoError;
+    }
+    if (!isPending()) {
+        return NoError;
+    }
+    if (_sent && nowMs - _lastWriteMs < _minIntervalMs) {
+        return NoError;
+    }
+
+    uint16_t pressure = filteredPressure();
+    uint16_t error = _scd4x->setAmbientPressure(pressure);
+    // one write per window, retried after the next read on failure
+    _windowOpen = false;
+    if (error) {
+        return error;
+    }
+    _sentHpa = pressure;
+    _lastWriteMs = nowMs;
+    _writeCount++;
+    _sent = true;
+    return NoError;
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_PRESSURE_FEED_H
+#define SCD4X_PRESSURE_FEED_H
+
+#include <stdint.h>
+
+#include "SensirionI2CScd4x.h"
+
+/*
+ * Scd4xPressureFeed - Forwards live barometer readings to the ambient
+ * pressure compensation of a SCD4x running in periodic measurement mode.
+ * Readings are smoothed with an exponential moving average and a new value is
+ * only sent when the filtered pressure drifted by more than a threshold. Writes
+ * are deferred into the idle bus time right after a measurement has been read
+ * so they never collide with or delay the next readMeasurement() call.
+ */
+class Scd4xPressureFeed {
+
+  public:
+    Scd4xPressureFeed();
+
+    /**
+     * begin() - Initializes the pressure feed.
+     *
+     * @param scd4x         Sensor driver used to send the ambient pressure.
+     * @param thresholdHpa  Minimum change of the filtered pressure in hPa
+     *                      before a new value is sent to the sensor.
+     * @param filterShift   Smoothing of the input filter, each reading is
+     *                      weighted with 1/2^filterShift.
+     * @param minIntervalMs Minimum time in ms between two pressure updates.
+     */
+    void begin(SensirionI2CScd4x& scd4x, uint16_t thresholdHpa = 1,
+               uint8_t filterShift = 3, uint32_t minIntervalMs = 60000);
+
+    /**
+     * addReading() - Feed a new barometer reading into the input filter.
+     *
+     * @param pressurePa Ambient pressure in Pa.
+     */
+    void addReading(uint32_t pressurePa);
+
+    /**
+     * measurementRead() - Notify the feed that a measurement has just been
+     * read from the sensor. This opens the window in which pressure updates
+     * may be written to the bus.
+     *
+     * @param nowMs            Current time in ms, e.g. millis().
+     * @param updateIntervalMs Signal update interval of the active
+     *                         measurement mode (5000 or 30000 ms).
+     */
+    void measurementRead(uint32_t nowMs, uint32_t updateIntervalMs);
+
+    /**
+     * update() - Send the filtered pressure to the sensor if it changed by
+     * more than the threshold, the minimum interval elapsed and the bus is
+     * idle until the next measurement. Call it from the main loop.
+     *
+     * @param nowMs Current time in ms, e.g. millis().
+     *
+     * @return 0 on success or if nothing had to be sent, an error code
+     * otherwise
+     */
+    uint16_t update(uint32_t nowMs);
+
+    /**
+     * isPending() - Check whether the filtered pressure differs enough from
+     * the last sent value to require an update.
+     *
+     * @return true if an update is due
+     */
+    bool isPending() const;
+
+    /**
+     * filteredPressure() - Get the current output of the input filter.
+     *
+     * @return Filtered ambient pressure in hPa, 0 if no reading was added yet
+     */
+    uint16_t filteredPressure() const;
+
+    /**
+     * sentPressure() - Get the last value sent to the sensor.
+     *
+     * @return Ambient pressure in hPa, 0 if nothing was sent yet
+     */
+    uint16_t sentPressure() const {
+        return _sentHpa;
+    }
+
+    /**
+     * writeCount() - Get the number of pressure updates sent to the sensor.
+     *
+     * @return Number of setAmbientPressure() commands issued
+     */
+    uint16_t writeCount() const {
+        return _writeCount;
+    }
+
+  private:
+    // time reserved before the next data-ready event in which no write starts
+    static const uint16_t GUARD_TIME_MS = 100;
+
+    SensirionI2CScd4x* _scd4x = nullptr;
+    int32_t _filtered = 0;  // Pa in Q8 fixed point
+    uint32_t _minIntervalMs = 60000;
+    uint32_t _lastReadMs = 0;
+    uint32_t _updateIntervalMs = 0;
+    uint32_t _lastWriteMs = 0;
+    uint16_t _thresholdHpa = 1;
+    uint16_t _sentHpa = 0;
+    uint16_t _writeCount = 0;
+    uint8_t _filterShift = 3;
+    bool _hasReading = false;
+    bool _sent = false;  // a value was sent since begin()
+    bool _windowOpen = false;
+};
+
+#endif /* SCD4X_PRESSURE_FEED_H */
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xReconfiguration.h"
+#include "Arduino.h"
+#include "SensirionI2CScd4x.h"
+
+Scd4xReconfiguration::Scd4xReconfiguration() {
+}
+
+void Scd4xReconfiguration::begin(SensirionI2CScd4x& scd4x,
+                                 Scd4xMeasurementMode mode) {
+    _scd4x = &scd4x;
+    _mode = mode;
+    _targetMode = mode;
+    _changes = 0;
+    _downtime = 0;
+}
+
+void Scd4xReconfiguration::setMeasurementMode(Scd4xMeasurementMode mode) {
+    _targetMode = mode;
+    _changes |= ChangeMode;
+}
+
+void Scd4xReconfiguration::setTemperatureOffsetTicks(uint16_t tOffset) {
+    _temperatureOffset = tOffset;
+    _changes |= ChangeTemperatureOffset;
+}
+
+void Scd4xReconfiguration::setTemperatureOffset(float tOffset) {
+    setTemperatureOffsetTicks(
+        static_cast<uint16_t>(tOffset * 65536.0 / 175.0 + 0.5f));
+}
+
+void Scd4xReconfiguration::setSensorAltitude(uint16_t sensorAltitude) {
+    _altitude = sensorAltitude;
+    _changes |= ChangeAltitude;
+}
+
+void Scd4xReconfiguration::setAutomaticSelfCalibration(uint16_t ascEnabled) {
+    _asc = ascEnabled;
+    _changes |= ChangeAsc;
+}
+
+void Scd4xReconfiguration::persistSettings() {
+    _changes |= ChangePersist;
+}
+
+void Scd4xReconfiguration::reinit() {
+    _changes |= ChangeReinit;
+}
+
+void Scd4xReconfiguration::performForcedRecalibration(uint16_t targetCo2) {
+    _frcTarget = targetCo2;
+    _changes |= ChangeFrc;
+}
+
+void Scd4xReconfiguration::readSettings() {
+    _changes |= ChangeRead;
+}
+
+void Scd4xReconfiguration::clear() {
+    _changes = 0;
+    _targetMode = _mode;
+}
+
+bool Scd4xReconfiguration::isPending() const {
+    return (_changes & ~ChangeMode) || _targetMode != _mode;
+}
+
+uint16_t Scd4xReconfiguration::measurementRead() {
+    if (!isPending()) {
+        return NoError;
+    }
+    return commit();
+}
+
+uint16_t Scd4xReconfiguration::commit() {
+    uint16_t error = NoError;
+    uint16_t result;
+    uint32_t start = millis();
+
+    if (!isPending()) {
+        _changes = 0;
+        return NoError;
+    }
+
+    if (_mode != Scd4xIdle) {
+        error = _scd4x->stopPeriodicMeasurement();
+        // a failed stop leaves the mode unknown, do not configure blindly
+        if (error) {
+            _changes = 0;
+            _downtime = millis() - start;
+            return error;
+        }
+        _mode = Scd4xIdle;
+    }
+
+    if (_changes & ChangeReinit) {
+        result = _scd4x->reinit();
+        error = error ? error : result;
+    }
+    if (_changes & ChangeTemperatureOffset) {
+        result = _scd4x->setTemperatureOffsetTicks(_temperatureOffset);
+        error = error ? error : result;
+    }
+    if (_changes & ChangeAltitude) {
+        result = _scd4x->setSensorAltitude(_altitude);
+        error = error ? error : result;
+    }
+    if (_changes & ChangeAsc) {
+        result = _scd4x->setAutomaticSelfCalibration(_asc);
+        error = error ? error : result;
+    }
+    if (_changes & ChangeFrc) {
+        result = _scd4x->performForcedRecalibration(_frcTarget,
+                                                    _frcCorrection);
+        error = error ? error : result;
+    }
+    if (_changes & ChangePersist) {
+        result = _scd4x->persistSettings();
+        error = error ? error : result;
+    }
+    if (_changes & ChangeRead) {
+        uint16_t* serial = _settings.serialNumber;
+        result = _scd4x->getSerialNumber(serial[0], serial[1], serial[2]);
+        error = error ? error : result;
+        result =
+            _scd4x->getTemperatureOffsetTicks(_settings.temperatureOffsetTicks);
+        error = error ? error : result;
+        result = _scd4x->getSensorAltitude(_settings.sensorAltitude);
+        error = error ? error : result;
+        result = _scd4x->getAutomaticSelfCalibration(_settings.ascEnabled);
+        error = error ? error : result;
+    }
+
+    if (_targetMode == Scd4xPeriodic) {
+        result = _scd4x->startPeriodicMeasurement();
+    } else if (_targetMode == Scd4xLowPowerPeriodic) {
+        result = _scd4x->startLowPowerPeriodicMeasurement();
+    } else {
+        result = NoError;
+    }
+    if (!result) {
+        _mode = _targetMode;
+    }
+    error = error ? error : result;
+
+    _changes = 0;
+    _targetMode = _mode;
+    _downtime = millis() - start;
+    return error;
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_RECONFIGURATION_H
+#define SCD4X_RECONFIGURATION_H
+
+#include <stdint.h>
+
+#include "SensirionI2CScd4x.h"
+
+enum Scd4xMeasurementMode : uint8_t {
+    Scd4xIdle,
+    Scd4xPeriodic,
+    Scd4xLowPowerPeriodic,
+};
+
+// settings read back by a transaction, see readSettings()
+struct Scd4xSettings {
+    uint16_t serialNumber[3];
+    uint16_t temperatureOffsetTicks;
+    uint16_t sensorAltitude;
+    uint16_t ascEnabled;
+};
+
+/*
+ * Scd4xReconfiguration - Collects configuration changes and applies them as one
+ * transaction: stop periodic measurement, reinit, the setters, forced
+ * recalibration, persist settings, then restart in the requested mode. The
+ * driver calls wait exactly the datasheet execution times. While measuring, the
+ * transaction is run from measurementRead() right after a sample has been read,
+ * so the sequence fits into the gap before the next sample instead of
+ * discarding a measurement in progress.
+ */
+class Scd4xReconfiguration {
+
+  public:
+    Scd4xReconfiguration();
+
+    /**
+     * begin() - Initializes the transaction.
+     *
+     * @param scd4x Sensor driver to configure.
+     * @param mode  Measurement mode the sensor is currently in.
+     */
+    void begin(SensirionI2CScd4x& scd4x, Scd4xMeasurementMode mode = Scd4xIdle);
+
+    /**
+     * setMeasurementMode() - Mode to continue in after the transaction.
+     * Without other changes this only stops or starts the measurement.
+     *
+     * @param mode Scd4xIdle to stay stopped or one of the periodic modes.
+     */
+    void setMeasurementMode(Scd4xMeasurementMode mode);
+
+    void setTemperatureOffsetTicks(uint16_t tOffset);
+    void setTemperatureOffset(float tOffset);
+    void setSensorAltitude(uint16_t sensorAltitude);
+    void setAutomaticSelfCalibration(uint16_t ascEnabled);
+
+    /**
+     * persistSettings() - Store the settings in the sensor EEPROM at the end
+     * of the transaction.
+     */
+    void persistSettings();
+
+    /**
+     * reinit() - Reload the settings from the sensor EEPROM before the
+     * setters of the transaction are applied.
+     */
+    void reinit();
+
+    /**
+     * performForcedRecalibration() - Run a forced recalibration to
+     * targetCo2 ppm after the setters. The sensor must have been measuring
+     * at that concentration for at least 3 minutes. The result is available
+     * from frcCorrection() after the transaction.
+     */
+    void performForcedRecalibration(uint16_t targetCo2);
+
+    /**
+     * readSettings() - Read the serial number and the settings at the end of
+     * the transaction, after the setters and persist; see settings().
+     */
+    void readSettings();
+
+    /**
+     * clear() - Drop all pending changes.
+     */
+    void clear();
+
+    /**
+     * isPending() - Check whether the transaction has work to do.
+     *
+     * @return true if commit() would send commands
+     */
+    bool isPending() const;
+
+    /**
+     * measurementRead() - Notify the transaction that a measurement has just
+     * been read. Pending changes are applied now, in the idle time until the
+     * next sample. Nothing is sent if no change is pending.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t measurementRead();
+
+    /**
+     * commit() - Apply the pending changes immediately. Use this while the
+     * sensor is idle; during periodic measurement prefer measurementRead().
+     * The transaction is cleared even if a command fails, and the sensor is
+     * restarted in the requested mode whenever possible.
+     *
+     * @return 0 on success, the first error code otherwise
+     */
+    uint16_t commit();
+
+    /**
+     * mode() - Get the measurement mode after the last transaction.
+     */
+    Scd4xMeasurementMode mode() const {
+        return _mode;
+    }
+
+    /**
+     * downtime() - Get the duration of the last transaction in ms, from the
+     * stop command to the restart of the measurement.
+     */
+    uint32_t downtime() const {
+        return _downtime;
+    }
+
+    /**
+     * frcCorrection() - Get the FRC correction of the last transaction
+     * which ran one, 0xFFFF if the recalibration failed.
+     */
+    uint16_t frcCorrection() const {
+        return _frcCorrection;
+    }
+
+    /**
+     * settings() - Get the values read by the last transaction with
+     * readSettings().
+     */
+    const Scd4xSettings& settings() const {
+        return _settings;
+    }
+
+  private:
+    enum {
+        ChangeMode = 0x01,
+        ChangeTemperatureOffset = 0x02,
+        ChangeAltitude = 0x04,
+        ChangeAsc = 0x08,
+        ChangePersist = 0x10,
+        ChangeReinit = 0x20,
+        ChangeFrc = 0x40,
+        ChangeRead = 0x80,
+    };
+
+    SensirionI2CScd4x* _scd4x = nullptr;
+    uint32_t _downtime = 0;
+    uint16_t _temperatureOffset = 0;
+    uint16_t _altitude = 0;
+    uint16_t _asc = 0;
+    uint16_t _frcTarget = 0;
+    uint16_t _frcCorrection = 0xFFFF;
+    Scd4xSettings _settings = {};
+    uint8_t _changes = 0;
+    Scd4xMeasurementMode _mode = Scd4xIdle;
+    Scd4xMeasurementMode _targetMode = Scd4xIdle;
+};
+
+#endif /* SCD4X_RECONFIGURATION_H */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xSampleRing.h"
+
+#ifdef __AVR__
+#include <util/atomic.h>
+#endif
+
+Scd4xSampleRing::Scd4xSampleRing(Scd4xSample buffer[], uint8_t capacity)
+    : _buffer(buffer), _capacity(capacity < 2 ? 2 : capacity), _head(0),
+      _tail(0) {
+}
+
+bool Scd4xSampleRing::push(const Scd4xSample& sample) {
+    uint8_t head = _load(_head);
+    uint8_t next = _next(head);
+
+    if (next == _load(_tail)) {
+        _dropped = _dropped + 1;
+        _overrun = true;
+        return false;
+    }
+    _buffer[head] = sample;
+    if (_overrun) {
+        _buffer[head].flags |= SampleOverrun;
+        _overrun = false;
+    }
+    _store(_head, next);
+    return true;
+}
+
+bool Scd4xSampleRing::pop(Scd4xSample& sample) {
+    uint8_t tail = _load(_tail);
+
+    if (tail == _load(_head)) {
+        return false;
+    }
+    sample = _buffer[tail];
+    _store(_tail, _next(tail));
+    return true;
+}
+
+bool Scd4xSampleRing::popLatest(Scd4xSample& sample) {
+    uint8_t head = _load(_head);
+    uint8_t tail = _load(_tail);
+
+    if (tail == head) {
+        return false;
+    }
+    uint8_t latest = (head == 0) ? _capacity - 1 : head - 1;
+    sample = _buffer[latest];
+    _store(_tail, head);
+    return true;
+}
+
+uint8_t Scd4xSampleRing::size() const {
+    uint8_t head = _load(_head);
+    uint8_t tail = _load(_tail);
+
+    return (head >= tail) ? head - tail : _capacity - tail + head;
+}
+
+uint16_t Scd4xSampleRing::droppedCount() const {
+#ifdef __AVR__
+    uint16_t dropped;
+    // two byte read, the producer may run from an interrupt in between
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        dropped = _dropped;
+    }
+    return dropped;
+#else
+    return _dropped;
+#endif
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_SAMPLE_RING_H
+#define SCD4X_SAMPLE_RING_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef __AVR__
+#include <atomic>
+#endif
+
+enum Scd4xSampleFlags : uint8_t {
+    // CO₂ reading of 0 ppm, reported by the sensor for invalid samples
+    SampleInvalidCo2 = 0x01,
+    // samples were dropped before this one because the ring was full
+    SampleOverrun = 0x02,
+    // a channel deviates too far from its rolling median (Scd4xSampleFilter)
+    SampleOutlier = 0x04,
+    // a channel changed faster than physically plausible (Scd4xSampleFilter)
+    SampleRateLimited = 0x08,
+    // flags marking samples which should not be displayed or aggregated
+    SampleRejectMask = SampleInvalidCo2 | SampleOutlier | SampleRateLimited,
+};
+
+/*
+ * Scd4xSample - One measurement as read from the sensor, together with the
+ * converted values and the time of the read-out.
+ */
+struct Scd4xSample {
+    uint32_t timestamp;  // millis() at read-out
+    uint16_t co2;        // CO₂ concentration in ppm
+    uint16_t temperatureTicks;
+    uint16_t humidityTicks;
+    float temperature;  // °C
+    float humidity;     // %RH
+    uint8_t flags;      // Scd4xSampleFlags
+};
+
+/*
+ * Scd4xSampleRing - Fixed-capacity single-producer/single-consumer ring buffer
+ * of measurement samples. The producer (the driver, possibly called from a
+ * timer task or interrupt) and the consumer (the main loop) only share the
+ * head and tail indices, which are updated without locks: single byte loads
+ * and stores fenced by compiler barriers on AVR, std::atomic with
+ * acquire/release ordering everywhere else. When the ring is full new samples
+ * are dropped and the next stored sample is marked with SampleOverrun.
+ */
+class Scd4xSampleRing {
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param buffer   Storage for the samples.
+     * @param capacity Number of entries in the buffer (2 to 255). One entry is
+     *                 kept free, so capacity - 1 samples can be queued.
+     */
+    Scd4xSampleRing(Scd4xSample buffer[], uint8_t capacity);
+
+    /**
+     * push() - Append a sample. Must only be called by the producer.
+     *
+     * @param sample Sample to copy into the ring.
+     *
+     * @return true on success, false if the ring was full
+     */
+    bool push(const Scd4xSample& sample);
+
+    /**
+     * pop() - Remove the oldest sample. Must only be called by the consumer.
+     *
+     * @param sample Receives the oldest queued sample.
+     *
+     * @return true on success, false if the ring was empty
+     */
+    bool pop(Scd4xSample& sample);
+
+    /**
+     * popLatest() - Skip to the newest sample and remove everything up to and
+     * including it. Must only be called by the consumer.
+     *
+     * @param sample Receives the newest queued sample.
+     *
+     * @return true on success, false if the ring was empty
+     */
+    bool popLatest(Scd4xSample& sample);
+
+    /**
+     * size() - Get the number of queued samples as seen by the caller.
+     *
+     * @return Number of samples which can be popped
+     */
+    uint8_t size() const;
+
+    /**
+     * droppedCount() - Get the number of samples dropped because the ring was
+     * full.
+     *
+     * @return Number of dropped samples
+     */
+    uint16_t droppedCount() const;
+
+  private:
+#ifdef __AVR__
+    typedef volatile uint8_t Index;
+    typedef volatile uint16_t Counter;  // read with interrupts disabled
+    uint8_t _load(const Index& index) const {
+        uint8_t value = index;
+        // keep the sample copy from being moved ahead of the index read
+        __asm__ __volatile__("" ::: "memory");
+        return value;
+    }
+    void _store(Index& index, uint8_t value) {
+        // keep the sample copy from being reordered past the index update
+        __asm__ __volatile__("" ::: "memory");
+        index = value;
+    }
+#else
+    typedef std::atomic<uint8_t> Index;
+    typedef std::atomic<uint16_t> Counter;
+    uint8_t _load(const Index& index) const {
+        return index.load(std::memory_order_acquire);
+    }
+    void _store(Index& index, uint8_t value) {
+        index.store(value, std::memory_order_release);
+    }
+#endif
+    uint8_t _next(uint8_t index) const {
+        return (index + 1 == _capacity) ? 0 : index + 1;
+    }
+
+    Scd4xSample* _buffer;
+    uint8_t _capacity;
+    Index _head;  // written by the producer only
+    Index _tail;  // written by the consumer only
+    Counter _dropped{0};
+    bool _overrun = false;
+};
+
+#endif /* SCD4X_SAMPLE_RING_H */
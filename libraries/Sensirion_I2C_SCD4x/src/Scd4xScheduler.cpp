@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xScheduler.h"
+#include "Arduino.h"
+#include "Scd4xTrace.h"
+
+// true if `a` is not before `b`, across the millis() wrap
+static bool reached(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) >= 0;
+}
+
+Scd4xScheduler::Scd4xScheduler(Scd4xTaskSlot slots[], uint8_t capacity)
+    : _slots(slots), _capacity(capacity) {
+}
+
+int8_t Scd4xScheduler::addTask(const char* name, Scd4xTaskFunction function,
+                               uint32_t periodMs, uint8_t priority,
+                               uint16_t deadlineMs, uint32_t nowMs) {
+    if (_count >= _capacity) {
+        return -1;
+    }
+    Scd4xTaskSlot& slot = _slots[_count];
+    slot.name = name;
+    slot.function = function;
+    slot.releaseMs = nowMs;
+    slot.periodMs = periodMs;
+    slot.deadlineMs = deadlineMs ? deadlineMs
+                                 : static_cast<uint16_t>(
+                                       periodMs < 0xFFFF ? periodMs : 0xFFFF);
+    slot.priority = priority;
+    slot.pending = periodMs != 0;
+    slot.stats = Scd4xTaskStats();
+    return static_cast<int8_t>(_count++);
+}
+
+void Scd4xScheduler::trigger(int8_t id, uint32_t nowMs) {
+    if (id < 0 || id >= _count) {
+        return;
+    }
+    Scd4xTaskSlot& slot = _slots[id];
+    if (!slot.pending || !reached(nowMs, slot.releaseMs)) {
+        slot.releaseMs = nowMs;
+    }
+    slot.pending = true;
+}
+
+void Scd4xScheduler::setPeriod(int8_t id, uint32_t periodMs) {
+    if (id < 0 || id >= _count) {
+        return;
+    }
+    _slots[id].periodMs = periodMs;
+    if (periodMs) {
+        _slots[id].pending = true;
+    }
+}
+
+bool Scd4xScheduler::update(uint32_t nowMs) {
+    uint32_t startUs = micros();
+    Scd4xTaskSlot* next = nullptr;
+    uint32_t nextDeadline = 0;
+
+    if (_looping && startUs - _lastUpdateUs > _maxLoopUs) {
+        _maxLoopUs = startUs - _lastUpdateUs;
+    }
+    _lastUpdateUs = startUs;
+    _looping = true;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        Scd4xTaskSlot& slot = _slots[i];
+        if (!slot.pending || !reached(nowMs, slot.releaseMs)) {
+            continue;
+        }
+        uint32_t deadline = slot.releaseMs + slot.deadlineMs;
+        if (!next || slot.priority > next->priority ||
+            (slot.priority == next->priority &&
+             !reached(deadline, nextDeadline))) {
+            next = &slot;
+            nextDeadline = deadline;
+        }
+    }
+    if (!next) {
+        return false;
+    }
+
+    Scd4xTaskStats& stats = next->stats;
+    uint32_t lateness = nowMs - next->releaseMs;
+    if (lateness > stats.maxLatenessMs) {
+        stats.maxLatenessMs =
+            static_cast<uint16_t>(lateness < 0xFFFF ? lateness : 0xFFFF);
+    }
+
+    // released again before running, so that the task may trigger itself
+    if (next->periodMs) {
+        next->releaseMs += next->periodMs;
+        if (reached(nowMs, next->releaseMs)) {
+            // more than a period behind, skip the missed releases
+            next->releaseMs = nowMs + next->periodMs;
+        }
+    } else {
+        next->pending = false;
+    }
+
+    uint32_t runStartUs = micros();
+    next->function(nowMs);
+    uint32_t elapsedUs = micros() - runStartUs;
+    Scd4xTrace::end(TraceTask, runStartUs, next - _slots);
+
+    stats.runs++;
+    stats.totalUs += elapsedUs;
+    if (elapsedUs > stats.maxUs) {
+        stats.maxUs =
+            static_cast<uint16_t>(elapsedUs < 0xFFFF ? elapsedUs : 0xFFFF);
+    }
+    if (!reached(nextDeadline, nowMs + elapsedUs / 1000)) {
+        stats.missedDeadlines++;
+    }
+    _busyUs += elapsedUs;
+    return true;
+}
+
+uint32_t Scd4xScheduler::nextReleaseMs(uint32_t nowMs) const {
+    uint32_t wait = 0xFFFFFFFF;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        const Scd4xTaskSlot& slot = _slots[i];
+        if (!slot.pending) {
+            continue;
+        }
+        if (reached(nowMs, slot.releaseMs)) {
+            return 0;
+        }
+        if (slot.releaseMs - nowMs < wait) {
+            wait = slot.releaseMs - nowMs;
+        }
+    }
+    return wait;
+}
+
+void Scd4xScheduler::resetStats(uint32_t nowMs) {
+    for (uint8_t i = 0; i < _count; i++) {
+        _slots[i].stats = Scd4xTaskStats();
+    }
+    _maxLoopUs = 0;
+    _busyUs = 0;
+    _looping = false;
+    _statsStartMs = nowMs;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_SCHEDULER_H
+#define SCD4X_SCHEDULER_H
+
+#include <stdint.h>
+
+typedef void (*Scd4xTaskFunction)(uint32_t nowMs);
+
+/*
+ * Scd4xTaskStats - Run time statistics of one task. Lateness is how long
+ * after its release a task started, the jitter the main loop adds.
+ */
+struct Scd4xTaskStats {
+    uint32_t runs;
+    uint32_t totalUs;  // CPU time spent in the task
+    uint16_t maxUs;    // longest single run, saturated
+    uint16_t maxLatenessMs;
+    uint16_t missedDeadlines;  // runs finished after release + deadline
+};
+
+/*
+ * Scd4xTaskSlot - Storage of one task, provided by the sketch and managed
+ * by Scd4xScheduler.
+ */
+struct Scd4xTaskSlot {
+    const char* name;
+    Scd4xTaskFunction function;
+    uint32_t releaseMs;   // time the task becomes ready
+    uint32_t periodMs;    // 0: only runs after trigger()
+    uint16_t deadlineMs;  // after the release
+    uint8_t priority;     // higher runs first
+    bool pending;
+    Scd4xTaskStats stats;
+};
+
+/*
+ * Scd4xScheduler - Cooperative run-to-completion scheduler for the main
+ * loop. Tasks are released every period or on trigger(); each update()
+ * runs at most one ready task: the one with the highest priority, among
+ * equal priorities the one with the earliest deadline. Tasks must return
+ * quickly and keep their state between runs instead of calling delay().
+ *
+ * The scheduler measures every run with micros() and the interval between
+ * update() calls, so the sketch can see where its loop time goes. While
+ * Scd4xTrace records, every run is also stored as a task span.
+ */
+class Scd4xScheduler {
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param slots    Storage for the tasks.
+     * @param capacity Number of slots.
+     */
+    Scd4xScheduler(Scd4xTaskSlot slots[], uint8_t capacity);
+
+    /**
+     * addTask() - Register a task, released first at nowMs.
+     *
+     * @param name       Name for reports, kept by pointer.
+     * @param function   Function to run, gets the time of the update().
+     * @param periodMs   Release interval, 0 for a task only run through
+     *                   trigger().
+     * @param priority   Higher values run first.
+     * @param deadlineMs Time after the release by which a run should have
+     *                   finished, 0 for the period.
+     * @param nowMs      Current time in ms, e.g. millis().
+     *
+     * @return Task id, or -1 if all slots are taken
+     */
+    int8_t addTask(const char* name, Scd4xTaskFunction function,
+                   uint32_t periodMs, uint8_t priority, uint16_t deadlineMs,
+                   uint32_t nowMs);
+
+    /**
+     * trigger() - Release a task now, in addition to its period. Can be
+     * called from another task, e.g. to redraw after a new sample.
+     */
+    void trigger(int8_t id, uint32_t nowMs);
+
+    /**
+     * setPeriod() - Change the period of a task, the next release stays.
+     */
+    void setPeriod(int8_t id, uint32_t periodMs);
+
+    /**
+     * update() - Run the most urgent ready task, if any. Call it from
+     * loop().
+     *
+     * @param nowMs Current time in ms, e.g. millis().
+     *
+     * @return true if a task ran
+     */
+    bool update(uint32_t nowMs);
+
+    /**
+     * nextReleaseMs() - Time until the next periodic release, for sleeping
+     * in between; 0 if a task is ready.
+     */
+    uint32_t nextReleaseMs(uint32_t nowMs) const;
+
+    /**
+     * resetStats() - Clear the statistics of all tasks and the loop.
+     */
+    void resetStats(uint32_t nowMs);
+
+    uint8_t taskCount() const {
+        return _count;
+    }
+
+    const char* taskName(uint8_t id) const {
+        return _slots[id].name;
+    }
+
+    const Scd4xTaskStats& taskStats(uint8_t id) const {
+        return _slots[id].stats;
+    }
+
+    // longest interval between two update() calls
+    uint32_t maxLoopUs() const {
+        return _maxLoopUs;
+    }
+
+    // CPU time in tasks and time since resetStats(), for the utilization
+    uint32_t busyUs() const {
+        return _busyUs;
+    }
+
+    uint32_t elapsedMs(uint32_t nowMs) const {
+        return nowMs - _statsStartMs;
+    }
+
+  private:
+    Scd4xTaskSlot* _slots;
+    uint8_t _capacity;
+    uint8_t _count = 0;
+    uint32_t _lastUpdateUs = 0;
+    uint32_t _maxLoopUs = 0;
+    uint32_t _busyUs = 0;
+    uint32_t _statsStartMs = 0;
+    bool _looping = false;
+};
+
+#endif /* SCD4X_SCHEDULER_H */
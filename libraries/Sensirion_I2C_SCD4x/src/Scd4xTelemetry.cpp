@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xTelemetry.h"
+#include "Arduino.h"
+
+#define TELEMETRY_HEADER_LENGTH 7
+#define TELEMETRY_SAMPLE_LENGTH (TELEMETRY_HEADER_LENGTH + 7)
+#define TELEMETRY_ERROR_LENGTH (TELEMETRY_HEADER_LENGTH + 2)
+#define TELEMETRY_CRC_LENGTH 2
+
+// CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF
+static uint16_t crc16(const uint8_t data[], size_t length) {
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < length; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void putUInt16(uint8_t out[], uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+static void putUInt32(uint8_t out[], uint32_t value) {
+    putUInt16(out, static_cast<uint16_t>(value));
+    putUInt16(out + 2, static_cast<uint16_t>(value >> 16));
+}
+
+static uint16_t getUInt16(const uint8_t in[]) {
+    return static_cast<uint16_t>(in[0] | in[1] << 8);
+}
+
+static uint32_t getUInt32(const uint8_t in[]) {
+    return getUInt16(in) | static_cast<uint32_t>(getUInt16(in + 2)) << 16;
+}
+
+size_t Scd4xTelemetryEncoder::encodeSample(const Scd4xSample& sample,
+                                           uint8_t frame[]) {
+    uint8_t payload[TELEMETRY_SAMPLE_LENGTH + TELEMETRY_CRC_LENGTH];
+
+    payload[0] = TelemetrySample;
+    putUInt32(payload + 3, sample.timestamp);
+    putUInt16(payload + 7, sample.co2);
+    putUInt16(payload + 9, sample.temperatureTicks);
+    putUInt16(payload + 11, sample.humidityTicks);
+    payload[13] = sample.flags;
+    return _finish(payload, TELEMETRY_SAMPLE_LENGTH, frame);
+}
+
+size_t Scd4xTelemetryEncoder::encodeError(uint32_t timestamp, uint16_t error,
+                                          uint8_t frame[]) {
+    uint8_t payload[TELEMETRY_ERROR_LENGTH + TELEMETRY_CRC_LENGTH];
+
+    payload[0] = TelemetryError;
+    putUInt32(payload + 3, timestamp);
+    putUInt16(payload + 7, error);
+    return _finish(payload, TELEMETRY_ERROR_LENGTH, frame);
+}
+
+// adds sequence number and CRC, then COBS: every 0x00 is replaced by the
+// distance to the next one, the first distance leads the frame
+size_t Scd4xTelemetryEncoder::_finish(uint8_t payload[], size_t length,
+                                      uint8_t frame[]) {
+    size_t code = 0;
+    size_t out = 1;
+
+    putUInt16(payload + 1, _sequence++);
+    putUInt16(payload + length, crc16(payload, length));
+    length += TELEMETRY_CRC_LENGTH;
+
+    for (size_t i = 0; i < length; i++) {
+        if (payload[i]) {
+            frame[out++] = payload[i];
+            continue;
+        }
+        frame[code] = static_cast<uint8_t>(out - code);
+        code = out++;
+    }
+    frame[code] = static_cast<uint8_t>(out - code);
+    frame[out++] = 0x00;
+    return out;
+}
+
+Scd4xTelemetrySink::Scd4xTelemetrySink(Scd4xTelemetryWriter writer)
+    : _writer(writer) {
+}
+
+void Scd4xTelemetrySink::onSample(const Scd4xSample& sample) {
+    uint8_t frame[1 + SCD4X_TELEMETRY_MAX_FRAME] = {0x00};
+    _writer(frame, 1 + _encoder.encodeSample(sample, frame + 1));
+}
+
+void Scd4xTelemetrySink::onError(uint16_t error) {
+    uint8_t frame[1 + SCD4X_TELEMETRY_MAX_FRAME] = {0x00};
+    _writer(frame, 1 + _encoder.encodeError(millis(), error, frame + 1));
+}
+
+bool Scd4xTelemetryDecoder::feed(uint8_t byte,
+                                 Scd4xTelemetryRecord& record) {
+    if (byte) {
+        if (_length < sizeof(_buffer)) {
+            _buffer[_length++] = byte;
+        } else {
+            _overflow = true;
+        }
+        return false;
+    }
+    if (!_length && !_overflow) {
+        return false;  // empty frame, e.g. a leading delimiter
+    }
+
+    bool valid = !_overflow && _decode(record);
+    _length = 0;
+    _overflow = false;
+    return valid;
+}
+
+bool Scd4xTelemetryDecoder::_decode(Scd4xTelemetryRecord& record) {
+    uint8_t payload[SCD4X_TELEMETRY_MAX_FRAME];
+    size_t length = 0;
+    size_t i = 0;
+
+    // undo COBS
+    while (i < _length) {
+        uint8_t code = _buffer[i++];
+        if (i + code - 1 > _length) {
+            _invalidFrames++;
+            return false;
+        }
+        for (uint8_t j = 1; j < code; j++) {
+            payload[length++] = _buffer[i++];
+        }
+        if (i < _length) {
+            payload[length++] = 0x00;
+        }
+    }
+
+    size_t expected = payload[0] == TelemetrySample  ? TELEMETRY_SAMPLE_LENGTH
+                      : payload[0] == TelemetryError ? TELEMETRY_ERROR_LENGTH
+                                                     : 0;
+    if (!length || length != expected + TELEMETRY_CRC_LENGTH) {
+        _invalidFrames++;
+        return false;
+    }
+    if (crc16(payload, expected) != getUInt16(payload + expected)) {
+        _crcErrors++;
+        return false;
+    }
+
+    record = Scd4xTelemetryRecord();
+    record.type = payload[0];
+    record.sequence = getUInt16(payload + 1);
+    record.timestamp = getUInt32(payload + 3);
+    if (record.type == TelemetrySample) {
+        record.co2 = getUInt16(payload + 7);
+        record.temperatureTicks = getUInt16(payload + 9);
+        record.humidityTicks = getUInt16(payload + 11);
+        record.flags = payload[13];
+    } else {
+        record.error = getUInt16(payload + 7);
+    }
+
+    uint16_t gap = record.sequence - _nextSequence;
+    // a jump backwards is a restarted sender, not lost frames
+    if (_synced && gap < 0x8000) {
+        _lostFrames += gap;
+    }
+    _nextSequence = record.sequence + 1;
+    _synced = true;
+    _frames++;
+    return true;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xTrace.h"
+
+#include "Scd4xScheduler.h"
+
+Scd4xTraceEvent* Scd4xTrace::_events = nullptr;
+uint16_t Scd4xTrace::_capacity = 0;
+uint16_t Scd4xTrace::_head = 0;
+uint16_t Scd4xTrace::_count = 0;
+uint32_t Scd4xTrace::_overwritten = 0;
+
+void Scd4xTrace::attach(Scd4xTraceEvent events[], uint16_t capacity) {
+    _events = capacity ? events : nullptr;
+    _capacity = capacity;
+    clear();
+}
+
+void Scd4xTrace::clear() {
+    _head = 0;
+    _count = 0;
+    _overwritten = 0;
+}
+
+void Scd4xTrace::end(uint8_t span, uint32_t startUs, uint16_t arg) {
+    if (!_events) {
+        return;
+    }
+    Scd4xTraceEvent& event = _events[_head];
+    event.startUs = startUs;
+    event.durationUs = micros() - startUs;
+    event.arg = arg;
+    event.span = span;
+
+    _head = (_head + 1 < _capacity) ? _head + 1 : 0;
+    if (_count < _capacity) {
+        _count++;
+    } else {
+        _overwritten++;
+    }
+}
+
+const Scd4xTraceEvent& Scd4xTrace::_event(uint16_t index) {
+    uint16_t oldest = (_count < _capacity) ? 0 : _head;
+    uint16_t slot = oldest + index;
+
+    return _events[slot < _capacity ? slot : slot - _capacity];
+}
+
+// name strings stay in flash on AVR
+static void printFlash(Print& output, const char* text) {
+    char c;
+
+    while ((c = pgm_read_byte(text++))) {
+        output.print(c);
+    }
+}
+
+static const char* spanName(uint8_t span) {
+    switch (span) {
+        case TraceI2cWrite:
+            return PSTR("i2c write");
+        case TraceI2cRead:
+            return PSTR("i2c read");
+        case TraceCommandWait:
+            return PSTR("command wait");
+        case TraceTask:
+            return PSTR("task");
+        case TraceDisplayFrame:
+            return PSTR("display frame");
+        case TraceDisplayPage:
+            return PSTR("display page");
+        default:
+            return PSTR("span");
+    }
+}
+
+static const char* spanCategory(uint8_t span) {
+    switch (span) {
+        case TraceI2cWrite:
+        case TraceI2cRead:
+            return PSTR("bus");
+        case TraceCommandWait:
+            return PSTR("sensor");
+        case TraceTask:
+            return PSTR("task");
+        case TraceDisplayFrame:
+        case TraceDisplayPage:
+            return PSTR("display");
+        default:
+            return PSTR("user");
+    }
+}
+
+static void printArgs(Print& output, const Scd4xTraceEvent& event,
+                      const Scd4xScheduler* scheduler) {
+    switch (event.span) {
+        case TraceI2cWrite:
+        case TraceI2cRead:
+        case TraceCommandWait:
+            output.print(F("\"command\":\"0x"));
+            output.print(event.arg, HEX);
+            output.print('"');
+            break;
+        case TraceTask:
+            if (scheduler && event.arg < scheduler->taskCount()) {
+                output.print(F("\"task\":\""));
+                output.print(scheduler->taskName(event.arg));
+                output.print('"');
+            } else {
+                output.print(F("\"task\":"));
+                output.print(event.arg);
+            }
+            break;
+        case TraceDisplayFrame:
+            output.print(F("\"pages\":"));
+            output.print(event.arg);
+            break;
+        case TraceDisplayPage:
+            output.print(F("\"page\":"));
+            output.print(event.arg);
+            break;
+        default:
+            output.print(F("\"span\":"));
+            output.print(event.span);
+            output.print(F(",\"arg\":"));
+            output.print(event.arg);
+            break;
+    }
+}
+
+void Scd4xTrace::writeJson(Print& output, const Scd4xScheduler* scheduler) {
+    uint32_t now = micros();
+    uint32_t oldestAge = 0;
+
+    // spans are stored by their end, the oldest start may be anywhere
+    for (uint16_t i = 0; i < _count; i++) {
+        uint32_t age = now - _event(i).startUs;
+        if (age > oldestAge) {
+            oldestAge = age;
+        }
+    }
+
+    output.println(F("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    output.print(F("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                   "\"tid\":1,\"args\":{\"name\":\"loop\"}}"));
+    for (uint16_t i = 0; i < _count; i++) {
+        const Scd4xTraceEvent& event = _event(i);
+
+        output.println(',');
+        output.print(F("{\"name\":\""));
+        printFlash(output, spanName(event.span));
+        output.print(F("\",\"cat\":\""));
+        printFlash(output, spanCategory(event.span));
+        output.print(F("\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"));
+        output.print(oldestAge - (now - event.startUs));
+        output.print(F(",\"dur\":"));
+        output.print(event.durationUs);
+        output.print(F(",\"args\":{"));
+        printArgs(output, event, scheduler);
+        output.print(F("}}"));
+    }
+    output.println();
+    output.println(F("]}"));
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_TRACE_H
+#define SCD4X_TRACE_H
+
+#include <stdint.h>
+
+#include "Arduino.h"
+
+class Scd4xScheduler;
+
+/*
+ * Scd4xTraceSpan - What a span covers. The argument of the span depends on
+ * its kind.
+ */
+enum Scd4xTraceSpan : uint8_t {
+    TraceI2cWrite,      // command frame sent, arg: command code
+    TraceI2cRead,       // response frame read, arg: command code
+    TraceCommandWait,   // execution time after a command, arg: command code
+    TraceTask,          // Scd4xScheduler task run, arg: task id
+    TraceDisplayFrame,  // firstPage() / nextPage() picture loop, arg: pages
+    TraceDisplayPage,   // page buffer sent to the display, arg: page
+    TraceUser = 16      // sketch spans from here on, arg: free
+};
+
+// one finished span
+struct Scd4xTraceEvent {
+    uint32_t startUs;  // micros() at the begin
+    uint32_t durationUs;
+    uint16_t arg;
+    uint8_t span;  // Scd4xTraceSpan
+};
+
+/*
+ * Scd4xTrace - Span recorder for profiling the main loop. The driver
+ * records its I2C transactions and command waits, Scd4xScheduler its task
+ * runs, and sketches add their own spans, e.g. display pages. Every span is
+ * stored when it ends, with its start and duration, into a ring provided by
+ * the sketch; when the ring is full the oldest spans are overwritten, so it
+ * always holds the most recent activity.
+ *
+ * writeJson() prints the ring in the Chrome trace event format, which
+ * chrome://tracing and https://ui.perfetto.dev open directly. Spans nest
+ * as they were called, all on one thread, so the timeline shows which
+ * transactions and waits make up a slow task.
+ *
+ * Tracing is off until attach(); then every span costs two micros() calls
+ * and an 11 byte event on AVR.
+ */
+class Scd4xTrace {
+
+  public:
+    /**
+     * attach() - Start recording into `events`, discarding earlier spans.
+     *
+     * @param events   Ring storage, nullptr stops recording.
+     * @param capacity Number of events the ring holds.
+     */
+    static void attach(Scd4xTraceEvent events[], uint16_t capacity);
+
+    static bool enabled() {
+        return _events != nullptr;
+    }
+
+    /**
+     * begin() - Start time of a span, to be passed to end().
+     */
+    static uint32_t begin() {
+        return _events ? micros() : 0;
+    }
+
+    /**
+     * end() - Record a span which started at `startUs`.
+     *
+     * @param span    Scd4xTraceSpan, or TraceUser and above.
+     * @param startUs Value of begin() at the start of the span.
+     * @param arg     Argument, see Scd4xTraceSpan.
+     */
+    static void end(uint8_t span, uint32_t startUs, uint16_t arg = 0);
+
+    // discard all recorded spans
+    static void clear();
+
+    // spans in the ring
+    static uint16_t count() {
+        return _count;
+    }
+
+    // spans overwritten since attach() or clear()
+    static uint32_t overwritten() {
+        return _overwritten;
+    }
+
+    /**
+     * writeJson() - Print the spans, oldest first, as Chrome trace JSON.
+     * Timestamps start at the oldest span; the ring must not cover more
+     * than the 71 minutes of micros() before it wraps.
+     *
+     * @param output    Serial, or any other Print.
+     * @param scheduler Scheduler whose task names label the task spans,
+     *                  nullptr to label them by id.
+     */
+    static void writeJson(Print& output,
+                          const Scd4xScheduler* scheduler = nullptr);
+
+  private:
+    static const Scd4xTraceEvent& _event(uint16_t index);
+
+    static Scd4xTraceEvent* _events;
+    static uint16_t _capacity;
+    static uint16_t _head;  // slot of the next span
+    static uint16_t _count;
+    static uint32_t _overwritten;
+};
+
+/*
+ * Scd4xTraceScope - Records a span from its construction to the end of the
+ * enclosing block.
+ */
+class Scd4xTraceScope {
+
+  public:
+    explicit Scd4xTraceScope(uint8_t span, uint16_t arg = 0)
+        : _startUs(Scd4xTrace::begin()), _arg(arg), _span(span) {
+    }
+
+    ~Scd4xTraceScope() {
+        Scd4xTrace::end(_span, _startUs, _arg);
+    }
+
+    // argument known only at the end of the span
+    void setArg(uint16_t arg) {
+        _arg = arg;
+    }
+
+  private:
+    uint32_t _startUs;
+    uint16_t _arg;
+    uint8_t _span;
+};
+
+#endif /* SCD4X_TRACE_H */
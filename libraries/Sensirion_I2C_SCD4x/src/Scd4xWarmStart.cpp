@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xWarmStart.h"
+
+// random RAM after a power-up matches it once in 2^32
+#define SCD4X_WARM_MARKER 0x5CD4B007UL
+
+#ifdef __AVR__
+
+// .noinit: neither copied from flash nor cleared before main()
+static uint32_t warmMarker __attribute__((section(".noinit")));
+uint8_t scd4xEarlyResetFlags __attribute__((section(".noinit")));
+
+// true in the sketch which defines SCD4X_RESET_FLAGS_HOOK
+bool scd4xResetFlagsHook __attribute__((weak)) = false;
+
+bool Scd4xWarmStart::warm() {
+    uint8_t powerUp = _BV(PORF);
+
+#ifdef BORF
+    powerUp |= _BV(BORF);
+#endif
+    if (scd4xResetFlagsHook && (scd4xEarlyResetFlags & powerUp)) {
+        return false;
+    }
+    return warmMarker == SCD4X_WARM_MARKER;
+}
+
+uint8_t Scd4xWarmStart::resetFlags() {
+    return scd4xResetFlagsHook ? scd4xEarlyResetFlags : MCUSR;
+}
+
+#else
+
+static uint32_t warmMarker;
+
+bool Scd4xWarmStart::warm() {
+    return warmMarker == SCD4X_WARM_MARKER;
+}
+
+uint8_t Scd4xWarmStart::resetFlags() {
+    return 0;
+}
+
+#endif /* __AVR__ */
+
+void Scd4xWarmStart::mark() {
+    warmMarker = SCD4X_WARM_MARKER;
+}
+
+void Scd4xWarmStart::clear() {
+    warmMarker = 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_WARM_START_H
+#define SCD4X_WARM_START_H
+
+#include <stdint.h>
+
+/*
+ * Scd4xWarmStart - Tells a warm restart (watchdog, reset button, the DTR
+ * reset when a terminal opens) from a power-up, so that a sketch can skip
+ * setting up peripherals which kept their state. The sketch sets a marker
+ * in .noinit RAM, which the C runtime leaves alone, with mark() once
+ * everything is set up; after a power-up that RAM holds random data.
+ *
+ * On AVR a sketch may also define SCD4X_RESET_FLAGS_HOOK before including
+ * this header, in one file only. That emits a hook in the .init3 section
+ * which takes the reset flags from MCUSR before main(), then clears MCUSR
+ * and stops the watchdog as avr-libc recommends, since a watchdog reset
+ * leaves it running at its shortest timeout. This affects the whole
+ * program: read the reset cause with resetFlags() then, not from MCUSR.
+ * With the hook a power-on or brown-out reset always counts as cold;
+ * without it, or with bootloaders which clear MCUSR themselves, the marker
+ * is all there is. Host builds keep the marker in a normal variable, so it
+ * only survives within one run; the sketch emulator sets it for a warm
+ * start.
+ */
+class Scd4xWarmStart {
+
+  public:
+    /**
+     * warm() - Check whether the marker survived the last reset and, with
+     * SCD4X_RESET_FLAGS_HOOK, that reset was no power-on or brown-out reset.
+     */
+    static bool warm();
+
+    /**
+     * mark() - Set the marker once the peripherals are set up, so that the
+     * next reset finds them warm.
+     */
+    static void mark();
+
+    /**
+     * clear() - Remove the marker before setting the peripherals up again,
+     * so that a reset in between counts as cold.
+     */
+    static void clear();
+
+    /**
+     * resetFlags() - Get MCUSR as it was before main() with
+     * SCD4X_RESET_FLAGS_HOOK, else as it is now; 0 on the host.
+     */
+    static uint8_t resetFlags();
+};
+
+#ifdef __AVR__
+
+#include <avr/io.h>
+#include <avr/wdt.h>
+
+#if !defined(MCUSR) && defined(MCUCSR)
+#define MCUSR MCUCSR
+#endif
+
+#ifdef SCD4X_RESET_FLAGS_HOOK
+
+extern uint8_t scd4xEarlyResetFlags;
+bool scd4xResetFlagsHook = true;  // replaces the weak default
+
+// runs after the stack pointer and r1 are set up, before .bss is cleared
+extern "C" void scd4xTakeResetFlags(void)
+    __attribute__((naked, used, section(".init3")));
+
+void scd4xTakeResetFlags(void) {
+    scd4xEarlyResetFlags = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+#endif /* SCD4X_RESET_FLAGS_HOOK */
+#endif /* __AVR__ */
+
+#endif /* SCD4X_WARM_START_H */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Scd4xWindowStats.h"
+
+Scd4xWindowStats::Scd4xWindowStats(uint8_t ewmaShift)
+    : _minute(60000UL), _quarter(900000UL), _hour(3600000UL),
+      _ewmaShift(ewmaShift) {
+}
+
+void Scd4xWindowStats::add(uint32_t timestamp, uint16_t ticks) {
+    if (!_hasSample) {
+        _ewma = static_cast<int32_t>(ticks) << 8;
+        _hasSample = true;
+    } else {
+        _ewma += ((static_cast<int32_t>(ticks) << 8) - _ewma) >> _ewmaShift;
+    }
+
+    _minute.add(timestamp, ticks);
+    _quarter.add(timestamp, ticks);
+    _hour.add(timestamp, ticks);
+}
+
+void Scd4xWindowStats::expire(uint32_t now) {
+    _minute.expire(now);
+    _quarter.expire(now);
+    _hour.expire(now);
+}
+
+void Scd4xWindowStats::minute(Scd4xAggregate& out) const {
+    _minute.result(out);
+}
+
+void Scd4xWindowStats::quarterHour(Scd4xAggregate& out) const {
+    _quarter.result(out);
+}
+
+void Scd4xWindowStats::hour(Scd4xAggregate& out) const {
+    _hour.result(out);
+}
+
+float Scd4xWindowStats::ewma() const {
+    return _ewma / 256.0f;
+}
+
+void Scd4xMeasurementStats::add(const Scd4xSample& sample) {
+    if (sample.flags & SampleRejectMask) {
+        return;
+    }
+    co2.add(sample.timestamp, sample.co2);
+    temperature.add(sample.timestamp, sample.temperatureTicks);
+    humidity.add(sample.timestamp, sample.humidityTicks);
+}
+
+void Scd4xMeasurementStats::expire(uint32_t now) {
+    co2.expire(now);
+    temperature.expire(now);
+    humidity.expire(now);
+}
@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCD4X_WINDOW_STATS_H
+#define SCD4X_WINDOW_STATS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "Scd4xSampleRing.h"
+
+#ifdef __AVR__
+#include <avr/io.h>
+#endif
+
+// Resolution of the sliding windows in ms. A window with bucket length 0
+// holds raw samples (12 per minute in high performance mode), the others
+// collect samples into buckets and hold one closed bucket per slot. Boards
+// with 2 kB of RAM or less step the 1 minute window by 20 s, the 15 minute
+// window by 5 minutes and the hour by 15 minutes; the others keep raw
+// samples for the minute and 1 minute buckets. Override with compiler
+// flags for all files, Scd4xWindowStats.cpp must see the same values.
+#if defined(RAMEND) && RAMEND < 0x900
+#define SCD4X_STATS_SMALL_RAM
+#endif
+
+#ifndef SCD4X_STATS_MINUTE_BUCKET_MS
+#ifdef SCD4X_STATS_SMALL_RAM
+#define SCD4X_STATS_MINUTE_BUCKET_MS 20000UL
+#else
+#define SCD4X_STATS_MINUTE_BUCKET_MS 0UL
+#endif
+#endif
+
+#ifndef SCD4X_STATS_QUARTER_BUCKET_MS
+#ifdef SCD4X_STATS_SMALL_RAM
+#define SCD4X_STATS_QUARTER_BUCKET_MS 300000UL
+#else
+#define SCD4X_STATS_QUARTER_BUCKET_MS 60000UL
+#endif
+#endif
+
+#ifndef SCD4X_STATS_HOUR_BUCKET_MS
+#ifdef SCD4X_STATS_SMALL_RAM
+#define SCD4X_STATS_HOUR_BUCKET_MS 900000UL
+#else
+#define SCD4X_STATS_HOUR_BUCKET_MS 60000UL
+#endif
+#endif
+
+// Capacity of the sliding windows, derived from the bucket lengths; raw
+// samples in the minute window need one slot per sample.
+#ifndef SCD4X_STATS_MINUTE_SLOTS
+#if SCD4X_STATS_MINUTE_BUCKET_MS
+#define SCD4X_STATS_MINUTE_SLOTS (60000UL / SCD4X_STATS_MINUTE_BUCKET_MS)
+#else
+#define SCD4X_STATS_MINUTE_SLOTS 13
+#endif
+#endif
+#define SCD4X_STATS_QUARTER_SLOTS (900000UL / SCD4X_STATS_QUARTER_BUCKET_MS)
+#define SCD4X_STATS_HOUR_SLOTS (3600000UL / SCD4X_STATS_HOUR_BUCKET_MS)
+
+/*
+ * Scd4xAggregate - Minimum, maximum and sum of a set of values in sensor
+ * ticks. Converting ticks is linear and monotonic, so the aggregate can be
+ * converted to physical units after the fact.
+ */
+struct Scd4xAggregate {
+    uint16_t min;
+    uint16_t max;
+    uint32_t sum;
+    uint16_t count;
+
+    void clear() {
+        min = 0xFFFF;
+        max = 0;
+        sum = 0;
+        count = 0;
+    }
+
+    void add(uint16_t value) {
+        min = (value < min) ? value : min;
+        max = (value > max) ? value : max;
+        sum += value;
+        count++;
+    }
+
+    void merge(const Scd4xAggregate& other) {
+        min = (other.min < min) ? other.min : min;
+        max = (other.max > max) ? other.max : max;
+        sum += other.sum;
+        count += other.count;
+    }
+
+    float mean() const {
+        return count ? static_cast<float>(sum) / count : 0.0f;
+    }
+};
+
+/*
+ * Scd4xSlidingWindow - Time based sliding window over aggregates with a fixed
+ * number of slots. Minimum and maximum are tracked with monotonic deques and
+ * the mean with a running sum, so adding, expiring and querying all run in
+ * amortized constant time. When all slots are in use the oldest entry is
+ * evicted even if it is still inside the time span.
+ */
+template <uint8_t N> class Scd4xSlidingWindow {
+
+  public:
+    explicit Scd4xSlidingWindow(uint32_t spanMs) : _spanMs(spanMs) {
+        clear();
+    }
+
+    void clear() {
+        _first = 0;
+        _size = 0;
+        _minFirst = _minSize = 0;
+        _maxFirst = _maxSize = 0;
+        _total.clear();
+    }
+
+    /**
+     * add() - Append an aggregate and expire entries outside the time span.
+     *
+     * @param timestamp Time of the entry in ms, must be non-decreasing.
+     * @param value     Aggregate of the entry, must not be empty.
+     */
+    void add(uint32_t timestamp, const Scd4xAggregate& value) {
+        expire(timestamp);
+        if (_size == N) {
+            _evict();
+        }
+
+        uint8_t slot = _slot(_first, _size);
+        _timestamps[slot] = timestamp;
+        _values[slot] = value;
+        _size++;
+        _total.sum += value.sum;
+        _total.count += value.count;
+
+        while (_minSize && _values[_back(_minQueue, _minFirst, _minSize)].min >=
+                               value.min) {
+            _minSize--;
+        }
+        _minQueue[_slot(_minFirst, _minSize++)] = slot;
+        while (_maxSize && _values[_back(_maxQueue, _maxFirst, _maxSize)].max <=
+                               value.max) {
+            _maxSize--;
+        }
+        _maxQueue[_slot(_maxFirst, _maxSize++)] = slot;
+    }
+
+    /**
+     * expire() - Drop entries older than the time span.
+     *
+     * @param now Current time in ms.
+     */
+    void expire(uint32_t now) {
+        while (_size && now - _timestamps[_first] >= _spanMs) {
+            _evict();
+        }
+    }
+
+    /**
+     * result() - Aggregate of all entries inside the window.
+     *
+     * @param out Receives the aggregate, count is 0 if the window is empty.
+     */
+    void result(Scd4xAggregate& out) const {
+        out = _total;
+        if (_size) {
+            out.min = _values[_minQueue[_minFirst]].min;
+            out.max = _values[_maxQueue[_maxFirst]].max;
+        } else {
+            out.clear();
+        }
+    }
+
+  private:
+    static uint8_t _slot(uint8_t first, uint8_t offset) {
+        uint16_t slot = static_cast<uint16_t>(first) + offset;
+        return (slot >= N) ? slot - N : slot;
+    }
+
+    static uint8_t _back(const uint8_t queue[], uint8_t first, uint8_t size) {
+        return queue[_slot(first, size - 1)];
+    }
+
+    void _evict() {
+        const Scd4xAggregate& oldest = _values[_first];
+        _total.sum -= oldest.sum;
+        _total.count -= oldest.count;
+        if (_minSize && _minQueue[_minFirst] == _first) {
+            _minFirst = _slot(_minFirst, 1);
+            _minSize--;
+        }
+        if (_maxSize && _maxQueue[_maxFirst] == _first) {
+            _maxFirst = _slot(_maxFirst, 1);
+            _maxSize--;
+        }
+        _first = _slot(_first, 1);
+        _size--;
+    }
+
+    uint32_t _spanMs;
+    uint32_t _timestamps[N];
+    Scd4xAggregate _values[N];
+    Scd4xAggregate _total;
+    uint8_t _minQueue[N];  // slots with increasing minimum
+    uint8_t _maxQueue[N];  // slots with decreasing maximum
+    uint8_t _first;
+    uint8_t _size;
+    uint8_t _minFirst;
+    uint8_t _minSize;
+    uint8_t _maxFirst;
+    uint8_t _maxSize;
+};
+
+/*
+ * Scd4xBucketWindow - Sliding window over samples. With BucketMs 0 every
+ * sample takes a slot; otherwise samples are collected into buckets of
+ * BucketMs and a bucket takes a slot when it closes. Results include the
+ * open bucket, so the closed ones only cover the span minus one bucket.
+ */
+template <uint8_t N, uint32_t BucketMs> class Scd4xBucketWindow {
+
+  public:
+    explicit Scd4xBucketWindow(uint32_t spanMs) : _window(spanMs - BucketMs) {
+        _bucket.clear();
+    }
+
+    /**
+     * add() - Add a sample.
+     *
+     * @param timestamp Time of the sample in ms, must be non-decreasing.
+     * @param ticks     Sample value in sensor ticks.
+     */
+    void add(uint32_t timestamp, uint16_t ticks) {
+        if (!BucketMs) {
+            Scd4xAggregate single;
+            single.clear();
+            single.add(ticks);
+            _window.add(timestamp, single);
+            return;
+        }
+        if (!_started) {
+            _bucketStart = timestamp;
+            _started = true;
+        }
+        expire(timestamp);
+        _bucket.add(ticks);
+    }
+
+    void expire(uint32_t now) {
+        if (BucketMs && _started && now - _bucketStart >= BucketMs) {
+            if (_bucket.count) {
+                _window.add(_bucketStart, _bucket);
+                _bucket.clear();
+            }
+            // skip empty buckets after a gap in the data
+            _bucketStart += ((now - _bucketStart) / BucketMs) * BucketMs;
+        }
+        _window.expire(now);
+    }
+
+    void result(Scd4xAggregate& out) const {
+        _window.result(out);
+        if (_bucket.count) {
+            out.merge(_bucket);
+        }
+    }
+
+  private:
+    Scd4xSlidingWindow<N> _window;
+    Scd4xAggregate _bucket;  // open bucket
+    uint32_t _bucketStart = 0;
+    bool _started = false;
+};
+
+/*
+ * Scd4xWindowStats - Incremental statistics of one sensor channel: sliding
+ * 1 minute, 15 minute and 1 hour windows at the SCD4X_STATS_*_BUCKET_MS
+ * resolution, and an exponentially weighted moving average. Memory use is
+ * fixed by those settings: on AVR about 1.4 kB per channel with the full
+ * resolution, about 0.3 kB with the coarse steps of 2 kB boards.
+ */
+class Scd4xWindowStats {
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param ewmaShift Smoothing of the moving average, each sample is
+     *                  weighted with 1/2^ewmaShift.
+     */
+    explicit Scd4xWindowStats(uint8_t ewmaShift = 4);
+
+    /**
+     * add() - Add a sample.
+     *
+     * @param timestamp Time of the sample in ms, must be non-decreasing.
+     * @param ticks     Sample value in sensor ticks.
+     */
+    void add(uint32_t timestamp, uint16_t ticks);
+
+    /**
+     * expire() - Drop data older than the respective window spans. Only
+     * needed before querying if no samples were added recently.
+     *
+     * @param now Current time in ms.
+     */
+    void expire(uint32_t now);
+
+    void minute(Scd4xAggregate& out) const;
+    void quarterHour(Scd4xAggregate& out) const;
+    void hour(Scd4xAggregate& out) const;
+
+    /**
+     * ewma() - Exponentially weighted moving average in sensor ticks.
+     *
+     * @return Average, 0 before the first sample
+     */
+    float ewma() const;
+
+  private:
+    Scd4xBucketWindow<SCD4X_STATS_MINUTE_SLOTS, SCD4X_STATS_MINUTE_BUCKET_MS>
+        _minute;
+    Scd4xBucketWindow<SCD4X_STATS_QUARTER_SLOTS, SCD4X_STATS_QUARTER_BUCKET_MS>
+        _quarter;
+    Scd4xBucketWindow<SCD4X_STATS_HOUR_SLOTS, SCD4X_STATS_HOUR_BUCKET_MS> _hour;
+    int32_t _ewma = 0;  // ticks in Q8 fixed point
+    uint8_t _ewmaShift;
+    bool _hasSample = false;
+};
+
+/*
+ * Scd4xMeasurementStats - Scd4xWindowStats for CO₂, temperature and humidity
+ * fed with complete samples.
+ */
+class Scd4xMeasurementStats {
+
+  public:
+    /**
+     * add() - Add a sample. Samples with any of the SampleRejectMask flags
+     * are ignored.
+     *
+     * @param sample Sample as read by the driver.
+     */
+    void add(const Scd4xSample& sample);
+
+    void expire(uint32_t now);
+
+    static float toTemperature(float ticks) {
+        return ticks * 175.0f / 65536.0f - 45.0f;
+    }
+
+    static float toHumidity(float ticks) {
+        return ticks * 100.0f / 65536.0f;
+    }
+
+    Scd4xWindowStats co2;
+    Scd4xWindowStats temperature;
+    Scd4xWindowStats humidity;
+};
+
+#endif /* SCD4X_WINDOW_STATS_H */
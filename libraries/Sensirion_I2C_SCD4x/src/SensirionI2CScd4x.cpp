@@ -38,11 +38,87 @@
 
 #include "SensirionI2CScd4x.h"
 #include "Arduino.h"
+#include "Scd4xTrace.h"
 #include "SensirionCore.h"
 #include <Wire.h>
 
 #define SCD4X_I2C_ADDRESS 0x62
 
+enum Scd4xCommandFlags : uint8_t {
+    CmdFixedWait = 0x01,   // measurement or sleep time, never polled
+    CmdIgnoreNack = 0x02,  // wake_up is not acknowledged
+    CmdIdempotent = 0x04,  // may be repeated after a failed attempt
+};
+
+// parts of a command run by _execute()
+enum Scd4xExecPhase : uint8_t {
+    ExecSend = 0x01,
+    ExecReceive = 0x02,
+    ExecWait = 0x04,  // execution time, before the response if any
+    ExecAll = ExecSend | ExecReceive | ExecWait,
+};
+
+struct Scd4xCommandDescriptor {
+    uint16_t code;
+    uint16_t executionMs;
+    uint8_t argumentWords;
+    uint8_t responseWords;
+    uint8_t flags;
+};
+
+// indexed by Scd4xCommandId
+static const Scd4xCommandDescriptor SCD4X_COMMANDS[] PROGMEM = {
+    {0x21B1, 1, 0, 0, 0},                 // start_periodic_measurement
+    {0xEC05, 1, 0, 3, 0},                 // read_measurement
+    {0x3F86, 500, 0, 0, 0},               // stop_periodic_measurement
+    {0x2318, 1, 0, 1, CmdIdempotent},     // get_temperature_offset
+    {0x241D, 1, 1, 0, CmdIdempotent},     // set_temperature_offset
+    {0x2322, 1, 0, 1, CmdIdempotent},     // get_sensor_altitude
+    {0x2427, 1, 1, 0, CmdIdempotent},     // set_sensor_altitude
+    {0xE000, 1, 1, 0, CmdIdempotent},     // set_ambient_pressure
+    {0x362F, 400, 1, 1, 0},               // perform_forced_recalibration
+    {0x2313, 1, 0, 1, CmdIdempotent},     // get_automatic_self_calibration
+    {0x2416, 1, 1, 0, CmdIdempotent},     // set_automatic_self_calibration
+    {0x21AC, 0, 0, 0, 0},                 // start_low_power_periodic_meas.
+    {0xE4B8, 1, 0, 1, CmdIdempotent},     // get_data_ready_status
+    {0x3615, 800, 0, 0, 0},               // persist_settings
+    {0x3682, 1, 0, 3, CmdIdempotent},     // get_serial_number
+    {0x3639, 5500, 0, 1, 0},              // perform_self_test
+    {0x3632, 800, 0, 0, 0},               // perform_factory_reset
+    {0x3646, 20, 0, 0, 0},                // reinit
+    {0x219D, 1350, 0, 0, CmdFixedWait},   // measure_single_shot
+    {0x2196, 50, 0, 0, CmdFixedWait},     // measure_single_shot_rht_only
+    {0x36E0, 1, 0, 0, CmdFixedWait},      // power_down
+    {0x36F6, 20, 0, 0, CmdIgnoreNack},    // wake_up
+};
+
+static_assert(sizeof(SCD4X_COMMANDS) / sizeof(SCD4X_COMMANDS[0]) ==
+                  Scd4xCommandCount,
+              "SCD4X_COMMANDS does not match Scd4xCommandId");
+
+static uint16_t commandCode(Scd4xCommandId id) {
+    return pgm_read_word(&SCD4X_COMMANDS[id].code);
+}
+
+// the SensirionI2CCommunication transfers, recorded as trace spans
+static uint16_t sendTraced(uint16_t code, SensirionI2CTxFrame& txFrame,
+                           TwoWire& i2cBus) {
+    uint32_t start = Scd4xTrace::begin();
+    uint16_t error = SensirionI2CCommunication::sendFrame(
+        SCD4X_I2C_ADDRESS, txFrame, i2cBus);
+    Scd4xTrace::end(TraceI2cWrite, start, code);
+    return error;
+}
+
+static uint16_t receiveTraced(uint16_t code, size_t numBytes,
+                              SensirionI2CRxFrame& rxFrame, TwoWire& i2cBus) {
+    uint32_t start = Scd4xTrace::begin();
+    uint16_t error = SensirionI2CCommunication::receiveFrame(
+        SCD4X_I2C_ADDRESS, numBytes, rxFrame, i2cBus);
+    Scd4xTrace::end(TraceI2cRead, start, code);
+    return error;
+}
+
 SensirionI2CScd4x::SensirionI2CScd4x() {
 }
 
@@ -50,507 +126,453 @@ void SensirionI2CScd4x::begin(TwoWire& i2cBus) {
     _i2cBus = &i2cBus;
 }
 
-uint16_t SensirionI2CScd4x::startPeriodicMeasurement() {
-    uint16_t error;
-    uint8_t buffer[2];
-    SensirionI2CTxFrame txFrame(buffer, 2);
+void SensirionI2CScd4x::attachSampleRing(Scd4xSampleRing* ring) {
+    _sampleRing = ring;
+}
 
-    error = txFrame.addCommand(0x21B1);
-    if (error) {
-        return error;
+void SensirionI2CScd4x::setAdaptiveTiming(bool enabled) {
+    _adaptiveTiming = enabled;
+    for (uint8_t i = 0; i < Scd4xCommandCount; i++) {
+        _latency[i] = 0;
     }
+}
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(1);
-    return error;
+uint32_t SensirionI2CScd4x::latencyEstimate(Scd4xCommandId command) const {
+    return (command < Scd4xCommandCount) ? _latency[command] * 100UL : 0;
 }
 
-uint16_t SensirionI2CScd4x::readMeasurementTicks(uint16_t& co2,
-                                                 uint16_t& temperature,
-                                                 uint16_t& humidity) {
-    uint16_t error;
-    uint8_t buffer[9];
-    SensirionI2CTxFrame txFrame(buffer, 9);
+void SensirionI2CScd4x::setRetries(uint8_t retries) {
+    // attempts count up to _retries + 1 in a uint8_t
+    _retries = (retries < 0xFF) ? retries : 0xFE;
+}
 
-    error = txFrame.addCommand(0xEC05);
-    if (error) {
-        return error;
-    }
+void SensirionI2CScd4x::setCommandCallback(Scd4xCommandCallback callback) {
+    _commandCallback = callback;
+}
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    if (error) {
-        return error;
+uint16_t SensirionI2CScd4x::sendCommand(Scd4xCommandId command,
+                                        const uint16_t args[]) {
+    if (command >= Scd4xCommandCount) {
+        return ExecutionError | InternalBufferSizeError;
     }
+    return _execute(command, args, nullptr, ExecSend);
+}
 
-    delay(1);
-
-    SensirionI2CRxFrame rxFrame(buffer, 9);
-    error = SensirionI2CCommunication::receiveFrame(SCD4X_I2C_ADDRESS, 9,
-                                                    rxFrame, *_i2cBus);
-    if (error) {
-        return error;
+uint16_t SensirionI2CScd4x::readResponse(Scd4xCommandId command,
+                                         uint16_t results[]) {
+    if (command >= Scd4xCommandCount) {
+        return ExecutionError | InternalBufferSizeError;
     }
-
-    error |= rxFrame.getUInt16(co2);
-    error |= rxFrame.getUInt16(temperature);
-    error |= rxFrame.getUInt16(humidity);
-    return error;
+    return _execute(command, nullptr, results, ExecReceive);
 }
 
-uint16_t SensirionI2CScd4x::readMeasurement(uint16_t& co2, float& temperature,
-                                            float& humidity) {
-    uint16_t error;
-    uint16_t temperatureTicks;
-    uint16_t humidityTicks;
-
-    error = readMeasurementTicks(co2, temperatureTicks, humidityTicks);
-    if (error) {
-        return error;
-    }
+uint16_t SensirionI2CScd4x::executionTime(Scd4xCommandId command) {
+    return (command < Scd4xCommandCount)
+               ? pgm_read_word(&SCD4X_COMMANDS[command].executionMs)
+               : 0;
+}
 
-    temperature = static_cast<float>(temperatureTicks * 175.0 / 65536.0 - 45.0);
-    humidity = static_cast<float>(humidityTicks * 100.0 / 65536.0);
-    return NoError;
+uint8_t SensirionI2CScd4x::responseWords(Scd4xCommandId command) {
+    return (command < Scd4xCommandCount)
+               ? pgm_read_byte(&SCD4X_COMMANDS[command].responseWords)
+               : 0;
 }
 
-uint16_t SensirionI2CScd4x::stopPeriodicMeasurement() {
+uint16_t SensirionI2CScd4x::_execute(Scd4xCommandId id, const uint16_t args[],
+                                     uint16_t results[], uint8_t phases) {
+    Scd4xCommandDescriptor command;
+    uint32_t start = micros();
+    uint8_t attempts = 0;
     uint16_t error;
-    uint8_t buffer[2];
-    SensirionI2CTxFrame txFrame(buffer, 2);
 
-    error = txFrame.addCommand(0x3F86);
-    if (error) {
-        return error;
-    }
+    memcpy_P(&command, &SCD4X_COMMANDS[id], sizeof(command));
+    do {
+        error = _attempt(id, command, args, results, phases);
+        attempts++;
+    } while (error && (command.flags & CmdIdempotent) && attempts <= _retries);
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(500);
+    if (_commandCallback) {
+        Scd4xCommandEvent event;
+        event.command = id;
+        event.attempts = attempts;
+        event.error = error;
+        event.durationUs = micros() - start;
+        _commandCallback(event);
+    }
     return error;
 }
 
-uint16_t SensirionI2CScd4x::getTemperatureOffsetTicks(uint16_t& tOffset) {
-    uint16_t error;
-    uint8_t buffer[3];
-    SensirionI2CTxFrame txFrame(buffer, 3);
+uint16_t SensirionI2CScd4x::_attempt(Scd4xCommandId id,
+                                     const Scd4xCommandDescriptor& command,
+                                     const uint16_t args[], uint16_t results[],
+                                     uint8_t phases) {
+    uint16_t error = NoError;
+    uint8_t buffer[9];
 
-    error = txFrame.addCommand(0x2318);
-    if (error) {
-        return error;
-    }
+    if (phases & ExecSend) {
+        SensirionI2CTxFrame txFrame(buffer, 2 + 3 * command.argumentWords);
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    if (error) {
+        error = txFrame.addCommand(command.code);
+        for (uint8_t i = 0; i < command.argumentWords; i++) {
+            error |= txFrame.addUInt16(args[i]);
+        }
+        if (error) {
+            return error;
+        }
+
+        error = sendTraced(command.code, txFrame, *_i2cBus);
+        if (command.flags & CmdIgnoreNack) {
+            error = NoError;
+        }
+        if (!command.responseWords) {
+            if (phases & ExecWait) {
+                _waitForCompletion(id, command.executionMs,
+                                   !error && !(command.flags & CmdFixedWait));
+            }
+            return error;
+        }
+        if (error) {
+            return error;
+        }
+    }
+    if (!(phases & ExecReceive) || !command.responseWords) {
         return error;
     }
 
-    delay(1);
-
-    SensirionI2CRxFrame rxFrame(buffer, 3);
-    error = SensirionI2CCommunication::receiveFrame(SCD4X_I2C_ADDRESS, 3,
-                                                    rxFrame, *_i2cBus);
+    SensirionI2CRxFrame rxFrame(buffer, 9);
+    size_t numBytes = 3 * command.responseWords;
+    if (phases & ExecWait) {
+        error = _receiveFrame(id, command.executionMs, numBytes, rxFrame);
+    } else {
+        error = receiveTraced(command.code, numBytes, rxFrame, *_i2cBus);
+    }
     if (error) {
         return error;
     }
 
-    error |= rxFrame.getUInt16(tOffset);
+    for (uint8_t i = 0; i < command.responseWords; i++) {
+        error |= rxFrame.getUInt16(results[i]);
+    }
     return error;
 }
 
-uint16_t SensirionI2CScd4x::getTemperatureOffset(float& tOffset) {
-    uint16_t error;
-    uint16_t tOffsetTicks;
+void SensirionI2CScd4x::_sleepUntil(uint32_t startUs, uint32_t offsetUs) {
+    uint32_t elapsed = micros() - startUs;
 
-    error = getTemperatureOffsetTicks(tOffsetTicks);
-    if (error) {
-        return error;
+    if (elapsed >= offsetUs) {
+        return;
     }
-
-    tOffset = static_cast<float>(tOffsetTicks * 175.0 / 65536.0);
-    return NoError;
+    uint32_t remaining = offsetUs - elapsed;
+    delay(remaining / 1000);
+    delayMicroseconds(static_cast<unsigned int>(remaining % 1000));
 }
 
-uint16_t SensirionI2CScd4x::setTemperatureOffsetTicks(uint16_t tOffset) {
-    uint16_t error;
-    uint8_t buffer[5];
-    SensirionI2CTxFrame txFrame(buffer, 5);
+// first poll at 3/4 of the estimate so that a faster sensor is noticed,
+// then in steps of 1/8 of the estimate
+uint32_t SensirionI2CScd4x::_firstPoll(Scd4xCommandId id, uint32_t maxUs,
+                                       uint32_t& stepUs) const {
+    uint32_t estimate = _latency[id] ? _latency[id] * 100UL : maxUs;
 
-    error = txFrame.addCommand(0x241D);
-    error |= txFrame.addUInt16(tOffset);
-    if (error) {
-        return error;
+    stepUs = estimate / 8;
+    if (stepUs < 100) {
+        stepUs = 100;
     }
-
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(1);
-    return error;
-}
-
-uint16_t SensirionI2CScd4x::setTemperatureOffset(float tOffset) {
-    uint16_t tOffsetTicks =
-        static_cast<uint16_t>(tOffset * 65536.0 / 175.0 + 0.5f);
-    return setTemperatureOffsetTicks(tOffsetTicks);
+    return estimate - estimate / 4;
 }
 
-uint16_t SensirionI2CScd4x::getSensorAltitude(uint16_t& sensorAltitude) {
-    uint16_t error;
-    uint8_t buffer[3];
-    SensirionI2CTxFrame txFrame(buffer, 3);
-
-    error = txFrame.addCommand(0x2322);
-    if (error) {
-        return error;
-    }
+void SensirionI2CScd4x::_learn(Scd4xCommandId id, uint32_t elapsedUs) {
+    uint16_t observed = static_cast<uint16_t>((elapsedUs + 99) / 100);
+    uint16_t estimate = _latency[id];
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    if (error) {
-        return error;
+    // follow increases at once and decreases slowly, keeping the estimate
+    // at the upper envelope of the observed latencies
+    if (!estimate || observed >= estimate) {
+        _latency[id] = observed;
+    } else {
+        _latency[id] = estimate - (estimate - observed) / 4;
     }
+}
 
-    delay(1);
-
-    SensirionI2CRxFrame rxFrame(buffer, 3);
-    error = SensirionI2CCommunication::receiveFrame(SCD4X_I2C_ADDRESS, 3,
-                                                    rxFrame, *_i2cBus);
-    if (error) {
-        return error;
+void SensirionI2CScd4x::_waitForCompletion(Scd4xCommandId id, uint16_t maxMs,
+                                           bool poll) {
+    Scd4xTraceScope wait(TraceCommandWait, commandCode(id));
+    uint32_t start = micros();
+    uint32_t maxUs = maxMs * 1000UL;
+    uint32_t step;
+    uint32_t next;
+
+    if (!_adaptiveTiming || !poll || !maxMs) {
+        delay(maxMs);
+        return;
+    }
+    next = _firstPoll(id, maxUs, step);
+    for (;;) {
+        _sleepUntil(start, next);
+        uint32_t elapsed = micros() - start;
+        if (!probe()) {
+            _learn(id, elapsed);
+            return;
+        }
+        if (elapsed >= maxUs) {
+            // no ACK within the datasheet time, relearn from worst case
+            _latency[id] = 0;
+            return;
+        }
+        next = (elapsed + step < maxUs) ? elapsed + step : maxUs;
     }
-
-    error |= rxFrame.getUInt16(sensorAltitude);
-    return error;
 }
 
-uint16_t SensirionI2CScd4x::setSensorAltitude(uint16_t sensorAltitude) {
+uint16_t SensirionI2CScd4x::_receiveFrame(Scd4xCommandId id, uint16_t maxMs,
+                                          size_t numBytes,
+                                          SensirionI2CRxFrame& rxFrame) {
+    uint16_t code = commandCode(id);
+    uint32_t start = micros();
+    uint32_t maxUs = maxMs * 1000UL;
+    uint32_t step;
+    uint32_t next;
     uint16_t error;
-    uint8_t buffer[5];
-    SensirionI2CTxFrame txFrame(buffer, 5);
 
-    error = txFrame.addCommand(0x2427);
-    error |= txFrame.addUInt16(sensorAltitude);
-    if (error) {
-        return error;
+    if (!_adaptiveTiming) {
+        {
+            Scd4xTraceScope wait(TraceCommandWait, code);
+            delay(maxMs);
+        }
+        return receiveTraced(code, numBytes, rxFrame, *_i2cBus);
+    }
+    // the polling reads nest in the wait
+    Scd4xTraceScope wait(TraceCommandWait, code);
+    next = _firstPoll(id, maxUs, step);
+    for (;;) {
+        _sleepUntil(start, next);
+        uint32_t elapsed = micros() - start;
+        error = receiveTraced(code, numBytes, rxFrame, *_i2cBus);
+        if (!error) {
+            _learn(id, elapsed);
+            return NoError;
+        }
+        // anything but a NACK, or no answer within the datasheet time
+        if (error != (ReadError | NotEnoughDataError) || elapsed >= maxUs) {
+            _latency[id] = 0;
+            return error;
+        }
+        next = (elapsed + step < maxUs) ? elapsed + step : maxUs;
     }
-
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(1);
-    return error;
 }
 
-uint16_t SensirionI2CScd4x::setAmbientPressure(uint16_t ambientPressure) {
-    uint16_t error;
-    uint8_t buffer[5];
-    SensirionI2CTxFrame txFrame(buffer, 5);
+float SensirionI2CScd4x::_convertTemperature(uint16_t temperatureTicks) {
+    return static_cast<float>(temperatureTicks * 175.0 / 65536.0 - 45.0);
+}
 
-    error = txFrame.addCommand(0xE000);
-    error |= txFrame.addUInt16(ambientPressure);
-    if (error) {
-        return error;
-    }
+float SensirionI2CScd4x::_convertHumidity(uint16_t humidityTicks) {
+    return static_cast<float>(humidityTicks * 100.0 / 65536.0);
+}
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(1);
-    return error;
+uint16_t SensirionI2CScd4x::startPeriodicMeasurement() {
+    return _execute(Scd4xCmdStartPeriodicMeasurement, nullptr, nullptr,
+                    ExecAll);
 }
 
-uint16_t
-SensirionI2CScd4x::performForcedRecalibration(uint16_t targetCo2Concentration,
-                                              uint16_t& frcCorrection) {
+uint16_t SensirionI2CScd4x::readMeasurementTicks(uint16_t& co2,
+                                                 uint16_t& temperature,
+                                                 uint16_t& humidity) {
     uint16_t error;
-    uint8_t buffer[5];
-    SensirionI2CTxFrame txFrame(buffer, 5);
-
-    error = txFrame.addCommand(0x362F);
-    error |= txFrame.addUInt16(targetCo2Concentration);
-    if (error) {
-        return error;
-    }
+    uint16_t words[3];
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
+    error = _execute(Scd4xCmdReadMeasurement, nullptr, words, ExecAll);
     if (error) {
         return error;
     }
 
-    delay(400);
-
-    SensirionI2CRxFrame rxFrame(buffer, 5);
-    error = SensirionI2CCommunication::receiveFrame(SCD4X_I2C_ADDRESS, 3,
-                                                    rxFrame, *_i2cBus);
-    if (error) {
-        return error;
+    co2 = words[0];
+    temperature = words[1];
+    humidity = words[2];
+    if (_sampleRing) {
+        Scd4xSample sample;
+        sample.timestamp = millis();
+        sample.co2 = co2;
+        sample.temperatureTicks = temperature;
+        sample.humidityTicks = humidity;
+        sample.temperature = _convertTemperature(temperature);
+        sample.humidity = _convertHumidity(humidity);
+        sample.flags = (co2 == 0) ? SampleInvalidCo2 : 0;
+        _sampleRing->push(sample);
     }
-
-    error |= rxFrame.getUInt16(frcCorrection);
-    return error;
+    return NoError;
 }
 
-uint16_t SensirionI2CScd4x::getAutomaticSelfCalibration(uint16_t& ascEnabled) {
+uint16_t SensirionI2CScd4x::readMeasurement(uint16_t& co2, float& temperature,
+                                            float& humidity) {
     uint16_t error;
-    uint8_t buffer[3];
-    SensirionI2CTxFrame txFrame(buffer, 3);
-
-    error = txFrame.addCommand(0x2313);
-    if (error) {
-        return error;
-    }
+    uint16_t temperatureTicks;
+    uint16_t humidityTicks;
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
+    error = readMeasurementTicks(co2, temperatureTicks, humidityTicks);
     if (error) {
         return error;
     }
 
-    delay(1);
+    temperature = _convertTemperature(temperatureTicks);
+    humidity = _convertHumidity(humidityTicks);
+    return NoError;
+}
 
-    SensirionI2CRxFrame rxFrame(buffer, 3);
-    error = SensirionI2CCommunication::receiveFrame(SCD4X_I2C_ADDRESS, 3,
-                                                    rxFrame, *_i2cBus);
-    if (error) {
-        return error;
-    }
+uint16_t SensirionI2CScd4x::stopPeriodicMeasurement() {
+    return _execute(Scd4xCmdStopPeriodicMeasurement, nullptr, nullptr,
+                    ExecAll);
+}
 
-    error |= rxFrame.getUInt16(ascEnabled);
-    return error;
+uint16_t SensirionI2CScd4x::getTemperatureOffsetTicks(uint16_t& tOffset) {
+    return _execute(Scd4xCmdGetTemperatureOffset, nullptr, &tOffset, ExecAll);
 }
 
-uint16_t SensirionI2CScd4x::setAutomaticSelfCalibration(uint16_t ascEnabled) {
+uint16_t SensirionI2CScd4x::getTemperatureOffset(float& tOffset) {
     uint16_t error;
-    uint8_t buffer[5];
-    SensirionI2CTxFrame txFrame(buffer, 5);
+    uint16_t tOffsetTicks;
 
-    error = txFrame.addCommand(0x2416);
-    error |= txFrame.addUInt16(ascEnabled);
+    error = getTemperatureOffsetTicks(tOffsetTicks);
     if (error) {
         return error;
     }
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(1);
-    return error;
+    tOffset = static_cast<float>(tOffsetTicks * 175.0 / 65536.0);
+    return NoError;
 }
 
-uint16_t SensirionI2CScd4x::startLowPowerPeriodicMeasurement() {
-    uint16_t error;
-    uint8_t buffer[2];
-    SensirionI2CTxFrame txFrame(buffer, 2);
-
-    error = txFrame.addCommand(0x21AC);
-    if (error) {
-        return error;
-    }
+uint16_t SensirionI2CScd4x::setTemperatureOffsetTicks(uint16_t tOffset) {
+    return _execute(Scd4xCmdSetTemperatureOffset, &tOffset, nullptr, ExecAll);
+}
 
-    return SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                *_i2cBus);
+uint16_t SensirionI2CScd4x::setTemperatureOffset(float tOffset) {
+    uint16_t tOffsetTicks =
+        static_cast<uint16_t>(tOffset * 65536.0 / 175.0 + 0.5f);
+    return setTemperatureOffsetTicks(tOffsetTicks);
 }
 
-uint16_t SensirionI2CScd4x::getDataReadyStatus(uint16_t& dataReady) {
-    uint16_t error;
-    uint8_t buffer[3];
-    SensirionI2CTxFrame txFrame(buffer, 3);
+uint16_t SensirionI2CScd4x::getSensorAltitude(uint16_t& sensorAltitude) {
+    return _execute(Scd4xCmdGetSensorAltitude, nullptr, &sensorAltitude,
+                    ExecAll);
+}
 
-    error = txFrame.addCommand(0xE4B8);
-    if (error) {
-        return error;
-    }
+uint16_t SensirionI2CScd4x::setSensorAltitude(uint16_t sensorAltitude) {
+    return _execute(Scd4xCmdSetSensorAltitude, &sensorAltitude, nullptr,
+                    ExecAll);
+}
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    if (error) {
-        return error;
-    }
+uint16_t SensirionI2CScd4x::setAmbientPressure(uint16_t ambientPressure) {
+    return _execute(Scd4xCmdSetAmbientPressure, &ambientPressure, nullptr,
+                    ExecAll);
+}
 
-    delay(1);
+uint16_t
+SensirionI2CScd4x::performForcedRecalibration(uint16_t targetCo2Concentration,
+                                              uint16_t& frcCorrection) {
+    return _execute(Scd4xCmdPerformForcedRecalibration,
+                    &targetCo2Concentration, &frcCorrection, ExecAll);
+}
 
-    SensirionI2CRxFrame rxFrame(buffer, 3);
-    error = SensirionI2CCommunication::receiveFrame(SCD4X_I2C_ADDRESS, 3,
-                                                    rxFrame, *_i2cBus);
-    if (error) {
-        return error;
-    }
+uint16_t SensirionI2CScd4x::getAutomaticSelfCalibration(uint16_t& ascEnabled) {
+    return _execute(Scd4xCmdGetAutomaticSelfCalibration, nullptr, &ascEnabled,
+                    ExecAll);
+}
 
-    error |= rxFrame.getUInt16(dataReady);
-    return error;
+uint16_t SensirionI2CScd4x::setAutomaticSelfCalibration(uint16_t ascEnabled) {
+    return _execute(Scd4xCmdSetAutomaticSelfCalibration, &ascEnabled, nullptr,
+                    ExecAll);
 }
 
-uint16_t SensirionI2CScd4x::persistSettings() {
-    uint16_t error;
-    uint8_t buffer[2];
-    SensirionI2CTxFrame txFrame(buffer, 2);
+uint16_t SensirionI2CScd4x::startLowPowerPeriodicMeasurement() {
+    return _execute(Scd4xCmdStartLowPowerPeriodicMeasurement, nullptr,
+                    nullptr, ExecAll);
+}
 
-    error = txFrame.addCommand(0x3615);
-    if (error) {
-        return error;
-    }
+uint16_t SensirionI2CScd4x::getDataReadyStatus(uint16_t& dataReady) {
+    return _execute(Scd4xCmdGetDataReadyStatus, nullptr, &dataReady, ExecAll);
+}
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(800);
-    return error;
+uint16_t SensirionI2CScd4x::persistSettings() {
+    return _execute(Scd4xCmdPersistSettings, nullptr, nullptr, ExecAll);
 }
 
 uint16_t SensirionI2CScd4x::getSerialNumber(uint16_t& serial0,
                                             uint16_t& serial1,
                                             uint16_t& serial2) {
     uint16_t error;
-    uint8_t buffer[9];
-    SensirionI2CTxFrame txFrame(buffer, 9);
-
-    error = txFrame.addCommand(0x3682);
-    if (error) {
-        return error;
-    }
+    uint16_t words[3];
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    if (error) {
-        return error;
-    }
-
-    delay(1);
-
-    SensirionI2CRxFrame rxFrame(buffer, 9);
-    error = SensirionI2CCommunication::receiveFrame(SCD4X_I2C_ADDRESS, 9,
-                                                    rxFrame, *_i2cBus);
+    error = _execute(Scd4xCmdGetSerialNumber, nullptr, words, ExecAll);
     if (error) {
         return error;
     }
 
-    error |= rxFrame.getUInt16(serial0);
-    error |= rxFrame.getUInt16(serial1);
-    error |= rxFrame.getUInt16(serial2);
-    return error;
+    serial0 = words[0];
+    serial1 = words[1];
+    serial2 = words[2];
+    return NoError;
 }
 
 uint16_t SensirionI2CScd4x::performSelfTest(uint16_t& sensorStatus) {
-    uint16_t error;
-    uint8_t buffer[3];
-    SensirionI2CTxFrame txFrame(buffer, 3);
+    return _execute(Scd4xCmdPerformSelfTest, nullptr, &sensorStatus, ExecAll);
+}
 
-    error = txFrame.addCommand(0x3639);
-    if (error) {
-        return error;
-    }
+uint16_t SensirionI2CScd4x::sendPerformSelfTest() {
+    return _execute(Scd4xCmdPerformSelfTest, nullptr, nullptr, ExecSend);
+}
 
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    if (error) {
-        return error;
-    }
+uint16_t SensirionI2CScd4x::readPerformSelfTestResult(uint16_t& sensorStatus) {
+    return _execute(Scd4xCmdPerformSelfTest, nullptr, &sensorStatus,
+                    ExecReceive);
+}
 
-    delay(5500);
+uint16_t SensirionI2CScd4x::performFactoryReset() {
+    return _execute(Scd4xCmdPerformFactoryReset, nullptr, nullptr, ExecAll);
+}
 
-    SensirionI2CRxFrame rxFrame(buffer, 3);
-    error = SensirionI2CCommunication::receiveFrame(SCD4X_I2C_ADDRESS, 3,
-                                                    rxFrame, *_i2cBus);
-    if (error) {
-        return error;
-    }
+uint16_t SensirionI2CScd4x::sendPerformFactoryReset() {
+    return _execute(Scd4xCmdPerformFactoryReset, nullptr, nullptr, ExecSend);
+}
 
-    error |= rxFrame.getUInt16(sensorStatus);
-    return error;
+uint16_t SensirionI2CScd4x::probe() {
+    // address only, the sensor does not acknowledge while it is busy
+    _i2cBus->beginTransmission(SCD4X_I2C_ADDRESS);
+    if (_i2cBus->endTransmission()) {
+        return WriteError | I2cAddressNack;
+    }
+    return NoError;
 }
 
-uint16_t SensirionI2CScd4x::performFactoryReset() {
+uint16_t SensirionI2CScd4x::isMeasuring(bool& measuring) {
+    uint16_t words[3];
     uint16_t error;
-    uint8_t buffer[2];
-    SensirionI2CTxFrame txFrame(buffer, 2);
 
-    error = txFrame.addCommand(0x3632);
-    if (error) {
+    error = _execute(Scd4xCmdGetSerialNumber, nullptr, words, ExecAll);
+    if ((error & 0xFF00) != WriteError) {
+        measuring = false;
         return error;
     }
-
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(800);
+    // not acknowledged, which a measuring sensor does with this command
+    error = _execute(Scd4xCmdGetDataReadyStatus, nullptr, words, ExecAll);
+    measuring = !error;
     return error;
 }
 
 uint16_t SensirionI2CScd4x::reinit() {
-    uint16_t error;
-    uint8_t buffer[2];
-    SensirionI2CTxFrame txFrame(buffer, 2);
-
-    error = txFrame.addCommand(0x3646);
-    if (error) {
-        return error;
-    }
-
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(20);
-    return error;
+    return _execute(Scd4xCmdReinit, nullptr, nullptr, ExecAll);
 }
 
 uint16_t SensirionI2CScd4x::measureSingleShot() {
-    uint16_t error;
-    uint8_t buffer[2];
-    SensirionI2CTxFrame txFrame(buffer, 2);
-
-    error = txFrame.addCommand(0x219D);
-    if (error) {
-        return error;
-    }
-
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(1350);
-    return error;
+    return _execute(Scd4xCmdMeasureSingleShot, nullptr, nullptr, ExecAll);
 }
 
 uint16_t SensirionI2CScd4x::measureSingleShotRhtOnly() {
-    uint16_t error;
-    uint8_t buffer[2];
-    SensirionI2CTxFrame txFrame(buffer, 2);
-
-    error = txFrame.addCommand(0x2196);
-    if (error) {
-        return error;
-    }
-
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(50);
-    return error;
+    return _execute(Scd4xCmdMeasureSingleShotRhtOnly, nullptr, nullptr,
+                    ExecAll);
 }
 
 uint16_t SensirionI2CScd4x::powerDown() {
-    uint16_t error;
-    uint8_t buffer[2];
-    SensirionI2CTxFrame txFrame(buffer, 2);
-
-    error = txFrame.addCommand(0x36E0);
-    if (error) {
-        return error;
-    }
-
-    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
-                                                 *_i2cBus);
-    delay(1);
-    return error;
+    return _execute(Scd4xCmdPowerDown, nullptr, nullptr, ExecAll);
 }
 
 uint16_t SensirionI2CScd4x::wakeUp() {
-    uint16_t error;
-    uint8_t buffer[2];
-    SensirionI2CTxFrame txFrame(buffer, 2);
-
-    error = txFrame.addCommand(0x36F6);
-    if (error) {
-        return error;
-    }
-
-    // Sensor does not acknowledge the wake-up call, error is ignored
-    static_cast<void>(SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS,
-                                                           txFrame, *_i2cBus));
-    delay(20);
-    return NoError;
+    // the sensor does not acknowledge the wake-up call, the error is ignored
+    return _execute(Scd4xCmdWakeUp, nullptr, nullptr, ExecAll);
 }
@@ -43,6 +43,53 @@
 
 #include <SensirionCore.h>
 
+#include "Scd4xSampleRing.h"
+
+/*
+ * Scd4xCommandId - Index of a sensor command in the driver's command table,
+ * reported to the command callback and used for the latency estimates.
+ */
+enum Scd4xCommandId : uint8_t {
+    Scd4xCmdStartPeriodicMeasurement,
+    Scd4xCmdReadMeasurement,
+    Scd4xCmdStopPeriodicMeasurement,
+    Scd4xCmdGetTemperatureOffset,
+    Scd4xCmdSetTemperatureOffset,
+    Scd4xCmdGetSensorAltitude,
+    Scd4xCmdSetSensorAltitude,
+    Scd4xCmdSetAmbientPressure,
+    Scd4xCmdPerformForcedRecalibration,
+    Scd4xCmdGetAutomaticSelfCalibration,
+    Scd4xCmdSetAutomaticSelfCalibration,
+    Scd4xCmdStartLowPowerPeriodicMeasurement,
+    Scd4xCmdGetDataReadyStatus,
+    Scd4xCmdPersistSettings,
+    Scd4xCmdGetSerialNumber,
+    Scd4xCmdPerformSelfTest,
+    Scd4xCmdPerformFactoryReset,
+    Scd4xCmdReinit,
+    Scd4xCmdMeasureSingleShot,
+    Scd4xCmdMeasureSingleShotRhtOnly,
+    Scd4xCmdPowerDown,
+    Scd4xCmdWakeUp,
+    Scd4xCommandCount,
+};
+
+/*
+ * Scd4xCommandEvent - One executed command: the error of its last attempt,
+ * the number of attempts and the time spent including the waits.
+ */
+struct Scd4xCommandEvent {
+    Scd4xCommandId command;
+    uint8_t attempts;
+    uint16_t error;
+    uint32_t durationUs;
+};
+
+typedef void (*Scd4xCommandCallback)(const Scd4xCommandEvent& event);
+
+struct Scd4xCommandDescriptor;
+
 class SensirionI2CScd4x {
 
   public:
@@ -55,6 +102,57 @@ class SensirionI2CScd4x {
      */
     void begin(TwoWire& i2cBus);
 
+    /**
+     * attachSampleRing() - Push every successful measurement read-out into a
+     * sample ring. The driver is the only producer of the ring.
+     *
+     * @param ring Ring buffer to fill or nullptr to detach.
+     */
+    void attachSampleRing(Scd4xSampleRing* ring);
+
+    /**
+     * setAdaptiveTiming() - Replace the fixed datasheet waits after each
+     * command by polling: reads are retried until the sensor acknowledges,
+     * write-only commands are followed by address probes. Per command the
+     * driver keeps an estimate of the completion time and starts polling
+     * shortly before it. The datasheet wait remains the upper bound, and any
+     * unexpected error resets the estimate to it. Single shot measurements
+     * and power down keep their fixed waits.
+     *
+     * @param enabled true to enable, false for the fixed waits (default).
+     *                Both reset the learned estimates.
+     */
+    void setAdaptiveTiming(bool enabled);
+
+    /**
+     * latencyEstimate() - Get the learned completion time of a command.
+     *
+     * @param command Command to look up.
+     *
+     * @return Estimate in us, 0 if nothing was learned yet
+     */
+    uint32_t latencyEstimate(Scd4xCommandId command) const;
+
+    /**
+     * setRetries() - Repeat commands which can safely be sent twice (reading
+     * and writing settings, data ready status, serial number) after a NACK
+     * or CRC error. Measurement reads, calibration and mode changes are
+     * never repeated.
+     *
+     * @param retries Additional attempts per command, 0 by default, at
+     *                most 254 so that the attempts fit Scd4xCommandEvent.
+     */
+    void setRetries(uint8_t retries);
+
+    /**
+     * setCommandCallback() - Report every executed command, e.g. to collect
+     * bus statistics. The callback runs in the caller's context after the
+     * command finished and must not use the driver.
+     *
+     * @param callback Function receiving the events or nullptr to detach.
+     */
+    void setCommandCallback(Scd4xCommandCallback callback);
+
     /**
      * startPeriodicMeasurement() - start periodic measurement, signal update
      * interval is 5 seconds.
@@ -327,6 +425,28 @@ class SensirionI2CScd4x {
      */
     uint16_t performSelfTest(uint16_t& sensorStatus);
 
+    /**
+     * sendPerformSelfTest() - Start perform_self_test without waiting for
+     * the result. The sensor does not respond until the test is finished,
+     * collect the result with readPerformSelfTestResult().
+     *
+     * @note Only available in idle mode.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t sendPerformSelfTest(void);
+
+    /**
+     * readPerformSelfTestResult() - Read the result of a self test started
+     * with sendPerformSelfTest(). Fails with a read error while the test is
+     * still running.
+     *
+     * @param sensorStatus 0 means no malfunction detected
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t readPerformSelfTestResult(uint16_t& sensorStatus);
+
     /**
      * performFactoryReset() - Initiates the reset of all configurations stored
      * in the EEPROM and erases the FRC and ASC algorithm history.
@@ -342,6 +462,71 @@ class SensirionI2CScd4x {
      */
     uint16_t performFactoryReset(void);
 
+    /**
+     * sendPerformFactoryReset() - Start perform_factory_reset without waiting
+     * for its completion. Use probe() to detect when the sensor is done.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t sendPerformFactoryReset(void);
+
+    /**
+     * probe() - Address the sensor without sending a command. The sensor
+     * does not acknowledge its address while it executes a command.
+     *
+     * @return 0 if the sensor acknowledged, an error code otherwise
+     */
+    uint16_t probe(void);
+
+    /**
+     * isMeasuring() - Find out whether the sensor runs a periodic
+     * measurement, for example when the host restarted without a power
+     * cycle. A measuring sensor rejects get_serial_number but answers
+     * get_data_ready_status, an idle one answers both.
+     *
+     * @param measuring true in periodic or low power periodic measurement
+     *
+     * @return 0 on success, an error code if the sensor answers neither
+     */
+    uint16_t isMeasuring(bool& measuring);
+
+    /**
+     * sendCommand() - Send any command with its arguments and return without
+     * waiting for its execution. Event loops and coroutines wait
+     * executionTime() themselves and then collect the response, if the
+     * command has one, with readResponse().
+     *
+     * @param command Command to send
+     * @param args    Argument words, as many as the command takes
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t sendCommand(Scd4xCommandId command, const uint16_t args[]);
+
+    /**
+     * readResponse() - Read the response of a command sent with
+     * sendCommand(). Fails with a read error while the sensor still
+     * executes the command.
+     *
+     * @param command Command sent before
+     * @param results Response words, as many as the command returns
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t readResponse(Scd4xCommandId command, uint16_t results[]);
+
+    /**
+     * executionTime() - Datasheet execution time of a command in ms, the
+     * time to wait after sendCommand().
+     */
+    static uint16_t executionTime(Scd4xCommandId command);
+
+    /**
+     * responseWords() - Number of words the command returns, 0 if it has no
+     * response to read.
+     */
+    static uint8_t responseWords(Scd4xCommandId command);
+
     /**
      * reinit() - The reinit command reinitializes the sensor by reloading user
      * settings from EEPROM. Before sending the reinit command, the stop
@@ -396,7 +581,28 @@ class SensirionI2CScd4x {
     uint16_t wakeUp(void);
 
   private:
+    static float _convertTemperature(uint16_t temperatureTicks);
+    static float _convertHumidity(uint16_t humidityTicks);
+    static void _sleepUntil(uint32_t startUs, uint32_t offsetUs);
+    uint16_t _execute(Scd4xCommandId id, const uint16_t args[],
+                      uint16_t results[], uint8_t phases);
+    uint16_t _attempt(Scd4xCommandId id,
+                      const Scd4xCommandDescriptor& command,
+                      const uint16_t args[], uint16_t results[],
+                      uint8_t phases);
+    uint32_t _firstPoll(Scd4xCommandId id, uint32_t maxUs,
+                        uint32_t& stepUs) const;
+    void _learn(Scd4xCommandId id, uint32_t elapsedUs);
+    void _waitForCompletion(Scd4xCommandId id, uint16_t maxMs, bool poll);
+    uint16_t _receiveFrame(Scd4xCommandId id, uint16_t maxMs, size_t numBytes,
+                           SensirionI2CRxFrame& rxFrame);
+
     TwoWire* _i2cBus = nullptr;
+    Scd4xSampleRing* _sampleRing = nullptr;
+    Scd4xCommandCallback _commandCallback = nullptr;
+    uint16_t _latency[Scd4xCommandCount] = {};  // in 100 us, 0 = unknown
+    uint8_t _retries = 0;
+    bool _adaptiveTiming = false;
 };
 
 #endif /* SENSIRIONI2CSCD4X_H */